@@ -32,7 +32,10 @@ For discussion please visit http://box2d.org/forum
 // These include files constitute the main Box2D API
 
 #include <Box2D/Common/b2Settings.h>
+#include <Box2D/Common/b2Allocator.h>
+#include <Box2D/Common/b2ConcurrentBlockAllocator.h>
 #include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2TaskExecutor.h>
 #include <Box2D/Common/b2Timer.h>
 
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
@@ -46,6 +49,7 @@ For discussion please visit http://box2d.org/forum
 #include <Box2D/Collision/b2TimeOfImpact.h>
 
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactEvents.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
@@ -24,7 +24,14 @@ using namespace std;
 
 b2ChainShape::~b2ChainShape()
 {
-	b2Free(m_vertices);
+	if (m_allocator)
+	{
+		m_allocator->Free(m_vertices, m_count * sizeof(b2Vec2));
+	}
+	else
+	{
+		b2Free(m_vertices);
+	}
 	m_vertices = NULL;
 	m_count = 0;
 }
@@ -34,7 +41,7 @@ void b2ChainShape::CreateLoop(const b2Vec2* vertices, int32 count)
 	b2Assert(m_vertices == NULL && m_count == 0);
 	b2Assert(count >= 3);
 	m_count = count + 1;
-	m_vertices = (b2Vec2*)b2Alloc(m_count * sizeof(b2Vec2));
+	m_vertices = AllocateVertices(m_count);
 	memcpy(m_vertices, vertices, count * sizeof(b2Vec2));
 	m_vertices[count] = m_vertices[0];
 	m_prevVertex = m_vertices[m_count - 2];
@@ -48,7 +55,7 @@ void b2ChainShape::CreateChain(const b2Vec2* vertices, int32 count)
 	b2Assert(m_vertices == NULL && m_count == 0);
 	b2Assert(count >= 2);
 	m_count = count;
-	m_vertices = (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+	m_vertices = AllocateVertices(count);
 	memcpy(m_vertices, vertices, m_count * sizeof(b2Vec2));
 	m_hasPrevVertex = false;
 	m_hasNextVertex = false;
@@ -70,6 +77,7 @@ b2Shape* b2ChainShape::Clone(b2BlockAllocator* allocator) const
 {
 	void* mem = allocator->Allocate(sizeof(b2ChainShape));
 	b2ChainShape* clone = new (mem) b2ChainShape;
+	clone->m_allocator = allocator;
 	clone->CreateChain(m_vertices, m_count);
 	clone->m_prevVertex = m_prevVertex;
 	clone->m_nextVertex = m_nextVertex;
@@ -78,6 +86,16 @@ b2Shape* b2ChainShape::Clone(b2BlockAllocator* allocator) const
 	return clone;
 }
 
+b2Vec2* b2ChainShape::AllocateVertices(int32 count)
+{
+	if (m_allocator)
+	{
+		return (b2Vec2*)m_allocator->Allocate(count * sizeof(b2Vec2));
+	}
+
+	return (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+}
+
 int32 b2ChainShape::GetChildCount() const
 {
 	// edge count = vertex count - 1
@@ -26,7 +26,8 @@ class b2EdgeShape;
 /// A chain shape is a free form sequence of line segments.
 /// The chain has two-sided collision, so you can use inside and outside collision.
 /// Therefore, you may use any winding order.
-/// Since there may be many vertices, they are allocated using b2Alloc.
+/// Since there may be many vertices, they are allocated using b2Alloc, or using the
+/// world's allocator once the shape belongs to a fixture.
 /// Connectivity information is used to create smooth collisions.
 /// WARNING: The chain will not collide properly if there are self-intersections.
 class b2ChainShape : public b2Shape
@@ -34,7 +35,7 @@ class b2ChainShape : public b2Shape
 public:
 	b2ChainShape();
 
-	/// The destructor frees the vertices using b2Free.
+	/// The destructor frees the vertices using the allocator they came from.
 	~b2ChainShape();
 
 	/// Create a loop. This automatically adjusts connectivity.
@@ -55,7 +56,7 @@ public:
 	/// Don't call this for loops.
 	void SetNextVertex(const b2Vec2& nextVertex);
 
-	/// Implement b2Shape. Vertices are cloned using b2Alloc.
+	/// Implement b2Shape. Vertices are cloned using the provided allocator.
 	b2Shape* Clone(b2BlockAllocator* allocator) const;
 
 	/// @see b2Shape::GetChildCount
@@ -87,6 +88,13 @@ public:
 
 	b2Vec2 m_prevVertex, m_nextVertex;
 	bool m_hasPrevVertex, m_hasNextVertex;
+
+private:
+
+	b2Vec2* AllocateVertices(int32 count);
+
+	/// The allocator of the vertices. NULL means b2Alloc.
+	b2BlockAllocator* m_allocator;
 };
 
 inline b2ChainShape::b2ChainShape()
@@ -95,6 +103,7 @@ inline b2ChainShape::b2ChainShape()
 	m_radius = b2_polygonRadius;
 	m_vertices = NULL;
 	m_count = 0;
+	m_allocator = NULL;
 	m_hasPrevVertex = NULL;
 	m_hasNextVertex = NULL;
 }
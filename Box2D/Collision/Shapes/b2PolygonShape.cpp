@@ -39,6 +39,7 @@ void b2PolygonShape::SetAsBox(float32 hx, float32 hy)
 	m_normals[2].Set(0.0f, 1.0f);
 	m_normals[3].Set(-1.0f, 0.0f);
 	m_centroid.SetZero();
+	m_isBox = true;
 }
 
 void b2PolygonShape::SetAsBox(float32 hx, float32 hy, const b2Vec2& center, float32 angle)
@@ -64,6 +65,9 @@ void b2PolygonShape::SetAsBox(float32 hx, float32 hy, const b2Vec2& center, floa
 		m_vertices[i] = b2Mul(xf, m_vertices[i]);
 		m_normals[i] = b2Mul(xf.q, m_normals[i]);
 	}
+
+	// Rotation keeps opposite normals exactly opposite.
+	m_isBox = true;
 }
 
 int32 b2PolygonShape::GetChildCount() const
@@ -168,6 +172,10 @@ void b2PolygonShape::Set(const b2Vec2* vertices, int32 count)
 
 	// Compute the polygon centroid.
 	m_centroid = ComputeCentroid(m_vertices, m_vertexCount);
+
+	m_isBox = m_vertexCount == 4 &&
+		m_normals[2] == -m_normals[0] &&
+		m_normals[3] == -m_normals[1];
 }
 
 bool b2PolygonShape::TestPoint(const b2Transform& xf, const b2Vec2& p) const
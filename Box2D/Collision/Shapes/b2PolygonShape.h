@@ -76,6 +76,11 @@ public:
 	b2Vec2 m_vertices[b2_maxPolygonVertices];
 	b2Vec2 m_normals[b2_maxPolygonVertices];
 	int32 m_vertexCount;
+
+	/// True if the polygon has four vertices and opposite edges have exactly
+	/// opposite normals, as made by SetAsBox. Such polygons take the box
+	/// path in b2CollidePolygons.
+	bool m_isBox;
 };
 
 inline b2PolygonShape::b2PolygonShape()
@@ -84,6 +89,7 @@ inline b2PolygonShape::b2PolygonShape()
 	m_radius = b2_polygonRadius;
 	m_vertexCount = 0;
 	m_centroid.SetZero();
+	m_isBox = false;
 }
 
 inline const b2Vec2& b2PolygonShape::GetVertex(int32 index) const
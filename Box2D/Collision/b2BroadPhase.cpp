@@ -20,23 +20,27 @@
 #include <cstring>
 using namespace std;
 
-b2BroadPhase::b2BroadPhase()
+b2BroadPhase::b2BroadPhase(b2Allocator* allocator) : m_tree(allocator)
 {
+	m_allocator = allocator ? allocator : b2GetDefaultAllocator();
+
 	m_proxyCount = 0;
 
 	m_pairCapacity = 16;
+	m_maxPairCapacity = m_pairCapacity;
 	m_pairCount = 0;
-	m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	m_pairBuffer = (b2Pair*)m_allocator->Allocate(m_pairCapacity * sizeof(b2Pair));
 
 	m_moveCapacity = 16;
+	m_maxMoveCapacity = m_moveCapacity;
 	m_moveCount = 0;
-	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	m_moveBuffer = (int32*)m_allocator->Allocate(m_moveCapacity * sizeof(int32));
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
-	b2Free(m_moveBuffer);
-	b2Free(m_pairBuffer);
+	m_allocator->Free(m_moveBuffer, m_moveCapacity * sizeof(int32));
+	m_allocator->Free(m_pairBuffer, m_pairCapacity * sizeof(b2Pair));
 }
 
 int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
@@ -73,10 +77,12 @@ void b2BroadPhase::BufferMove(int32 proxyId)
 	if (m_moveCount == m_moveCapacity)
 	{
 		int32* oldBuffer = m_moveBuffer;
+		int32 oldCapacity = m_moveCapacity;
 		m_moveCapacity *= 2;
-		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+		m_maxMoveCapacity = b2Max(m_maxMoveCapacity, m_moveCapacity);
+		m_moveBuffer = (int32*)m_allocator->Allocate(m_moveCapacity * sizeof(int32));
 		memcpy(m_moveBuffer, oldBuffer, m_moveCount * sizeof(int32));
-		b2Free(oldBuffer);
+		m_allocator->Free(oldBuffer, oldCapacity * sizeof(int32));
 	}
 
 	m_moveBuffer[m_moveCount] = proxyId;
@@ -108,10 +114,12 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 	if (m_pairCount == m_pairCapacity)
 	{
 		b2Pair* oldBuffer = m_pairBuffer;
+		int32 oldCapacity = m_pairCapacity;
 		m_pairCapacity *= 2;
-		m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+		m_maxPairCapacity = b2Max(m_maxPairCapacity, m_pairCapacity);
+		m_pairBuffer = (b2Pair*)m_allocator->Allocate(m_pairCapacity * sizeof(b2Pair));
 		memcpy(m_pairBuffer, oldBuffer, m_pairCount * sizeof(b2Pair));
-		b2Free(oldBuffer);
+		m_allocator->Free(oldBuffer, oldCapacity * sizeof(b2Pair));
 	}
 
 	m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyId, m_queryProxyId);
@@ -120,3 +128,34 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 
 	return true;
 }
+
+void b2BroadPhase::Compact()
+{
+	// The move buffer may hold proxies for the next update, so keep enough room for them.
+	int32 moveCapacity = 16;
+	while (moveCapacity < m_moveCount)
+	{
+		moveCapacity *= 2;
+	}
+
+	if (moveCapacity < m_moveCapacity)
+	{
+		int32* oldBuffer = m_moveBuffer;
+		int32 oldCapacity = m_moveCapacity;
+		m_moveCapacity = moveCapacity;
+		m_moveBuffer = (int32*)m_allocator->Allocate(m_moveCapacity * sizeof(int32));
+		memcpy(m_moveBuffer, oldBuffer, m_moveCount * sizeof(int32));
+		m_allocator->Free(oldBuffer, oldCapacity * sizeof(int32));
+	}
+
+	// The pair buffer is scratch space for UpdatePairs.
+	if (m_pairCapacity > 16)
+	{
+		m_allocator->Free(m_pairBuffer, m_pairCapacity * sizeof(b2Pair));
+		m_pairCapacity = 16;
+		m_pairCount = 0;
+		m_pairBuffer = (b2Pair*)m_allocator->Allocate(m_pairCapacity * sizeof(b2Pair));
+	}
+
+	m_tree.ShrinkNodePool();
+}
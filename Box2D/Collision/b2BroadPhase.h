@@ -43,7 +43,8 @@ public:
 		e_nullProxy = -1
 	};
 
-	b2BroadPhase();
+	/// @param allocator supplies the tree and the pair buffers. NULL means the default allocator.
+	b2BroadPhase(b2Allocator* allocator = NULL);
 	~b2BroadPhase();
 
 	/// Create a proxy with an initial AABB. Pairs are not reported until
@@ -100,6 +101,21 @@ public:
 	/// Get the quality metric of the embedded tree.
 	float32 GetTreeQuality() const;
 
+	/// Release the unused capacity of the move buffer, the pair buffer
+	/// and the tree node pool. Call this outside of UpdatePairs.
+	void Compact();
+
+	/// Get the embedded tree. For memory accounting and testing.
+	const b2DynamicTree& GetTree() const;
+
+	/// Get the current and the largest capacity of the move buffer.
+	int32 GetMoveCapacity() const { return m_moveCapacity; }
+	int32 GetMaxMoveCapacity() const { return m_maxMoveCapacity; }
+
+	/// Get the current and the largest capacity of the pair buffer.
+	int32 GetPairCapacity() const { return m_pairCapacity; }
+	int32 GetMaxPairCapacity() const { return m_maxPairCapacity; }
+
 private:
 
 	friend class b2DynamicTree;
@@ -109,16 +125,20 @@ private:
 
 	bool QueryCallback(int32 proxyId);
 
+	b2Allocator* m_allocator;
+
 	b2DynamicTree m_tree;
 
 	int32 m_proxyCount;
 
 	int32* m_moveBuffer;
 	int32 m_moveCapacity;
+	int32 m_maxMoveCapacity;
 	int32 m_moveCount;
 
 	b2Pair* m_pairBuffer;
 	int32 m_pairCapacity;
+	int32 m_maxPairCapacity;
 	int32 m_pairCount;
 
 	int32 m_queryProxyId;
@@ -162,6 +182,11 @@ inline int32 b2BroadPhase::GetProxyCount() const
 	return m_proxyCount;
 }
 
+inline const b2DynamicTree& b2BroadPhase::GetTree() const
+{
+	return m_tree;
+}
+
 inline int32 b2BroadPhase::GetTreeHeight() const
 {
 	return m_tree.GetHeight();
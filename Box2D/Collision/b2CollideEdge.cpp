@@ -21,12 +21,17 @@
 #include <Box2D/Collision/Shapes/b2EdgeShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 
+#ifdef B2_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
 
 // Compute contact points for edge versus circle.
 // This accounts for edge connectivity.
 void b2CollideEdgeAndCircle(b2Manifold* manifold,
 							const b2EdgeShape* edgeA, const b2Transform& xfA,
-							const b2CircleShape* circleB, const b2Transform& xfB)
+							const b2CircleShape* circleB, const b2Transform& xfB,
+							float32 speculativeDistance)
 {
 	manifold->pointCount = 0;
 	
@@ -40,7 +45,7 @@ void b2CollideEdgeAndCircle(b2Manifold* manifold,
 	float32 u = b2Dot(e, B - Q);
 	float32 v = b2Dot(e, Q - A);
 	
-	float32 radius = edgeA->m_radius + circleB->m_radius;
+	float32 radius = edgeA->m_radius + circleB->m_radius + speculativeDistance;
 	
 	b2ContactFeature cf;
 	cf.indexB = 0;
@@ -194,7 +199,7 @@ struct b2ReferenceFace
 struct b2EPCollider
 {
 	void Collide(b2Manifold* manifold, const b2EdgeShape* edgeA, const b2Transform& xfA,
-				 const b2PolygonShape* polygonB, const b2Transform& xfB);
+				 const b2PolygonShape* polygonB, const b2Transform& xfB, float32 speculativeDistance);
 	b2EPAxis ComputeEdgeSeparation();
 	b2EPAxis ComputePolygonSeparation();
 	
@@ -228,7 +233,7 @@ struct b2EPCollider
 // 7. Return if _any_ axis indicates separation
 // 8. Clip
 void b2EPCollider::Collide(b2Manifold* manifold, const b2EdgeShape* edgeA, const b2Transform& xfA,
-						   const b2PolygonShape* polygonB, const b2Transform& xfB)
+						   const b2PolygonShape* polygonB, const b2Transform& xfB, float32 speculativeDistance)
 {
 	m_xf = b2MulT(xfA, xfB);
 	
@@ -432,7 +437,8 @@ void b2EPCollider::Collide(b2Manifold* manifold, const b2EdgeShape* edgeA, const
 		m_polygonB.normals[i] = b2Mul(m_xf.q, polygonB->m_normals[i]);
 	}
 	
-	m_radius = 2.0f * b2_polygonRadius;
+	// Points are accepted up to this separation.
+	m_radius = 2.0f * b2_polygonRadius + speculativeDistance;
 	
 	manifold->pointCount = 0;
 	
@@ -636,6 +642,56 @@ b2EPAxis b2EPCollider::ComputeEdgeSeparation()
 	return axis;
 }
 
+#ifdef B2_SIMD_SSE2
+
+// Compute the separation of the edge v1-v2 along each negated polygon normal,
+// four normals at a time. This matches the scalar code bit for bit.
+static void b2ComputeEdgeSeparations(float32* separations, const b2TempPolygon& polygon,
+									 const b2Vec2& v1, const b2Vec2& v2)
+{
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int32)0x80000000));
+	__m128 v1x = _mm_set1_ps(v1.x);
+	__m128 v1y = _mm_set1_ps(v1.y);
+	__m128 v2x = _mm_set1_ps(v2.x);
+	__m128 v2y = _mm_set1_ps(v2.y);
+
+	for (int32 i = 0; i < polygon.count; i += 4)
+	{
+		__m128 p01 = _mm_loadu_ps(&polygon.vertices[i].x);
+		__m128 p23 = _mm_loadu_ps(&polygon.vertices[i + 2].x);
+		__m128 px = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 py = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1));
+
+		__m128 n01 = _mm_loadu_ps(&polygon.normals[i].x);
+		__m128 n23 = _mm_loadu_ps(&polygon.normals[i + 2].x);
+		__m128 nx = _mm_xor_ps(_mm_shuffle_ps(n01, n23, _MM_SHUFFLE(2, 0, 2, 0)), signMask);
+		__m128 ny = _mm_xor_ps(_mm_shuffle_ps(n01, n23, _MM_SHUFFLE(3, 1, 3, 1)), signMask);
+
+		__m128 s1 = _mm_add_ps(_mm_mul_ps(nx, _mm_sub_ps(px, v1x)), _mm_mul_ps(ny, _mm_sub_ps(py, v1y)));
+		__m128 s2 = _mm_add_ps(_mm_mul_ps(nx, _mm_sub_ps(px, v2x)), _mm_mul_ps(ny, _mm_sub_ps(py, v2y)));
+
+		// minps(a, b) is a < b ? a : b, same as b2Min.
+		_mm_storeu_ps(separations + i, _mm_min_ps(s1, s2));
+	}
+}
+
+#else
+
+static void b2ComputeEdgeSeparations(float32* separations, const b2TempPolygon& polygon,
+									 const b2Vec2& v1, const b2Vec2& v2)
+{
+	for (int32 i = 0; i < polygon.count; ++i)
+	{
+		b2Vec2 n = -polygon.normals[i];
+
+		float32 s1 = b2Dot(n, polygon.vertices[i] - v1);
+		float32 s2 = b2Dot(n, polygon.vertices[i] - v2);
+		separations[i] = b2Min(s1, s2);
+	}
+}
+
+#endif
+
 b2EPAxis b2EPCollider::ComputePolygonSeparation()
 {
 	b2EPAxis axis;
@@ -645,13 +701,13 @@ b2EPAxis b2EPCollider::ComputePolygonSeparation()
 
 	b2Vec2 perp(-m_normal.y, m_normal.x);
 
+	float32 separations[b2_maxPolygonVertices];
+	b2ComputeEdgeSeparations(separations, m_polygonB, m_v1, m_v2);
+
 	for (int32 i = 0; i < m_polygonB.count; ++i)
 	{
 		b2Vec2 n = -m_polygonB.normals[i];
-		
-		float32 s1 = b2Dot(n, m_polygonB.vertices[i] - m_v1);
-		float32 s2 = b2Dot(n, m_polygonB.vertices[i] - m_v2);
-		float32 s = b2Min(s1, s2);
+		float32 s = separations[i];
 		
 		if (s > m_radius)
 		{
@@ -691,8 +747,9 @@ b2EPAxis b2EPCollider::ComputePolygonSeparation()
 
 void b2CollideEdgeAndPolygon(	b2Manifold* manifold,
 							 const b2EdgeShape* edgeA, const b2Transform& xfA,
-							 const b2PolygonShape* polygonB, const b2Transform& xfB)
+							 const b2PolygonShape* polygonB, const b2Transform& xfB,
+							 float32 speculativeDistance)
 {
 	b2EPCollider collider;
-	collider.Collide(manifold, edgeA, xfA, polygonB, xfB);
+	collider.Collide(manifold, edgeA, xfA, polygonB, xfB, speculativeDistance);
 }
@@ -36,18 +36,7 @@ static float32 b2EdgeSeparation(const b2PolygonShape* poly1, const b2Transform&
 	b2Vec2 normal1 = b2MulT(xf2.q, normal1World);
 
 	// Find support vertex on poly2 for -normal.
-	int32 index = 0;
-	float32 minDot = b2_maxFloat;
-
-	for (int32 i = 0; i < count2; ++i)
-	{
-		float32 dot = b2Dot(vertices2[i], normal1);
-		if (dot < minDot)
-		{
-			minDot = dot;
-			index = i;
-		}
-	}
+	int32 index = b2FindMinProjection(vertices2, count2, normal1);
 
 	b2Vec2 v1 = b2Mul(xf1, vertices1[edge1]);
 	b2Vec2 v2 = b2Mul(xf2, vertices2[index]);
@@ -68,17 +57,7 @@ static float32 b2FindMaxSeparation(int32* edgeIndex,
 	b2Vec2 dLocal1 = b2MulT(xf1.q, d);
 
 	// Find edge normal on poly1 that has the largest projection onto d.
-	int32 edge = 0;
-	float32 maxDot = -b2_maxFloat;
-	for (int32 i = 0; i < count1; ++i)
-	{
-		float32 dot = b2Dot(normals1[i], dLocal1);
-		if (dot > maxDot)
-		{
-			maxDot = dot;
-			edge = i;
-		}
-	}
+	int32 edge = b2FindMinProjection(normals1, count1, -dLocal1);
 
 	// Get the separation for the edge normal.
 	float32 s = b2EdgeSeparation(poly1, xf1, edge, poly2, xf2);
@@ -138,6 +117,25 @@ static float32 b2FindMaxSeparation(int32* edgeIndex,
 	return bestSeparation;
 }
 
+// Build the clip vertices for the incident edge.
+static void b2SetIncidentEdge(b2ClipVertex c[2], int32 edge1,
+							const b2PolygonShape* poly2, const b2Transform& xf2, int32 i1, int32 i2)
+{
+	const b2Vec2* vertices2 = poly2->m_vertices;
+
+	c[0].v = b2Mul(xf2, vertices2[i1]);
+	c[0].id.cf.indexA = (uint8)edge1;
+	c[0].id.cf.indexB = (uint8)i1;
+	c[0].id.cf.typeA = b2ContactFeature::e_face;
+	c[0].id.cf.typeB = b2ContactFeature::e_vertex;
+
+	c[1].v = b2Mul(xf2, vertices2[i2]);
+	c[1].id.cf.indexA = (uint8)edge1;
+	c[1].id.cf.indexB = (uint8)i2;
+	c[1].id.cf.typeA = b2ContactFeature::e_face;
+	c[1].id.cf.typeB = b2ContactFeature::e_vertex;
+}
+
 static void b2FindIncidentEdge(b2ClipVertex c[2],
 							 const b2PolygonShape* poly1, const b2Transform& xf1, int32 edge1,
 							 const b2PolygonShape* poly2, const b2Transform& xf2)
@@ -145,7 +143,6 @@ static void b2FindIncidentEdge(b2ClipVertex c[2],
 	const b2Vec2* normals1 = poly1->m_normals;
 
 	int32 count2 = poly2->m_vertexCount;
-	const b2Vec2* vertices2 = poly2->m_vertices;
 	const b2Vec2* normals2 = poly2->m_normals;
 
 	b2Assert(0 <= edge1 && edge1 < poly1->m_vertexCount);
@@ -154,33 +151,161 @@ static void b2FindIncidentEdge(b2ClipVertex c[2],
 	b2Vec2 normal1 = b2MulT(xf2.q, b2Mul(xf1.q, normals1[edge1]));
 
 	// Find the incident edge on poly2.
-	int32 index = 0;
-	float32 minDot = b2_maxFloat;
-	for (int32 i = 0; i < count2; ++i)
+	int32 index = b2FindMinProjection(normals2, count2, normal1);
+
+	int32 i1 = index;
+	int32 i2 = i1 + 1 < count2 ? i1 + 1 : 0;
+	b2SetIncidentEdge(c, edge1, poly2, xf2, i1, i2);
+}
+
+// The box path. Both polygons have four vertices and opposite edges have
+// opposite normals, so only two normals are rotated and the other two are
+// negated. Negation is exact, so the box path takes the same branches and
+// produces the same manifold and feature ids as the general path.
+
+// Find the separation between box1 and box2 for an edge normal on box1.
+// The normal is given in world coordinates and in box2's frame.
+static float32 b2BoxEdgeSeparation(const b2PolygonShape* box1, const b2Transform& xf1, int32 edge1,
+								 const b2Vec2& normal1World, const b2Vec2& normal1,
+								 const b2PolygonShape* box2, const b2Transform& xf2)
+{
+	const b2Vec2* vertices2 = box2->m_vertices;
+
+	// Find support vertex on box2 for -normal.
+	int32 index = b2FindMinProjection(vertices2, 4, normal1);
+
+	b2Vec2 v1 = b2Mul(xf1, box1->m_vertices[edge1]);
+	b2Vec2 v2 = b2Mul(xf2, vertices2[index]);
+	float32 separation = b2Dot(v2 - v1, normal1World);
+	return separation;
+}
+
+// Find the max separation between box1 and box2 using edge normals from box1.
+static float32 b2FindMaxSeparationBox(int32* edgeIndex,
+									const b2PolygonShape* box1, const b2Transform& xf1,
+									const b2PolygonShape* box2, const b2Transform& xf2)
+{
+	const b2Vec2* normals1 = box1->m_normals;
+
+	// Vector pointing from the centroid of box1 to the centroid of box2.
+	b2Vec2 d = b2Mul(xf2, box2->m_centroid) - b2Mul(xf1, box1->m_centroid);
+	b2Vec2 dLocal1 = b2MulT(xf1.q, d);
+
+	// Find edge normal on box1 that has the largest projection onto d.
+	float32 dots[4];
+	dots[0] = b2Dot(normals1[0], dLocal1);
+	dots[1] = b2Dot(normals1[1], dLocal1);
+	dots[2] = -dots[0];
+	dots[3] = -dots[1];
+
+	int32 edge = 0;
+	float32 maxDot = dots[0];
+	for (int32 i = 1; i < 4; ++i)
 	{
-		float32 dot = b2Dot(normal1, normals2[i]);
-		if (dot < minDot)
+		if (dots[i] > maxDot)
 		{
-			minDot = dot;
-			index = i;
+			maxDot = dots[i];
+			edge = i;
 		}
 	}
 
-	// Build the clip vertices for the incident edge.
-	int32 i1 = index;
-	int32 i2 = i1 + 1 < count2 ? i1 + 1 : 0;
+	// Rotate the edge normals into world and into box2's frame.
+	b2Vec2 worldNormals[4];
+	b2Vec2 normals[4];
+	worldNormals[0] = b2Mul(xf1.q, normals1[0]);
+	worldNormals[1] = b2Mul(xf1.q, normals1[1]);
+	worldNormals[2] = -worldNormals[0];
+	worldNormals[3] = -worldNormals[1];
+	normals[0] = b2MulT(xf2.q, worldNormals[0]);
+	normals[1] = b2MulT(xf2.q, worldNormals[1]);
+	normals[2] = -normals[0];
+	normals[3] = -normals[1];
 
-	c[0].v = b2Mul(xf2, vertices2[i1]);
-	c[0].id.cf.indexA = (uint8)edge1;
-	c[0].id.cf.indexB = (uint8)i1;
-	c[0].id.cf.typeA = b2ContactFeature::e_face;
-	c[0].id.cf.typeB = b2ContactFeature::e_vertex;
+	// Get the separation for the edge normal.
+	float32 s = b2BoxEdgeSeparation(box1, xf1, edge, worldNormals[edge], normals[edge], box2, xf2);
 
-	c[1].v = b2Mul(xf2, vertices2[i2]);
-	c[1].id.cf.indexA = (uint8)edge1;
-	c[1].id.cf.indexB = (uint8)i2;
-	c[1].id.cf.typeA = b2ContactFeature::e_face;
-	c[1].id.cf.typeB = b2ContactFeature::e_vertex;
+	// Check the separation for the previous edge normal.
+	int32 prevEdge = (edge + 3) & 3;
+	float32 sPrev = b2BoxEdgeSeparation(box1, xf1, prevEdge, worldNormals[prevEdge], normals[prevEdge], box2, xf2);
+
+	// Check the separation for the next edge normal.
+	int32 nextEdge = (edge + 1) & 3;
+	float32 sNext = b2BoxEdgeSeparation(box1, xf1, nextEdge, worldNormals[nextEdge], normals[nextEdge], box2, xf2);
+
+	// Find the best edge and the search direction.
+	int32 bestEdge;
+	float32 bestSeparation;
+	int32 increment;
+	if (sPrev > s && sPrev > sNext)
+	{
+		increment = 3;
+		bestEdge = prevEdge;
+		bestSeparation = sPrev;
+	}
+	else if (sNext > s)
+	{
+		increment = 1;
+		bestEdge = nextEdge;
+		bestSeparation = sNext;
+	}
+	else
+	{
+		*edgeIndex = edge;
+		return s;
+	}
+
+	// Perform a local search for the best edge normal.
+	for ( ; ; )
+	{
+		edge = (bestEdge + increment) & 3;
+
+		s = b2BoxEdgeSeparation(box1, xf1, edge, worldNormals[edge], normals[edge], box2, xf2);
+
+		if (s > bestSeparation)
+		{
+			bestEdge = edge;
+			bestSeparation = s;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	*edgeIndex = bestEdge;
+	return bestSeparation;
+}
+
+static void b2FindIncidentEdgeBox(b2ClipVertex c[2],
+								const b2PolygonShape* box1, const b2Transform& xf1, int32 edge1,
+								const b2PolygonShape* box2, const b2Transform& xf2)
+{
+	const b2Vec2* normals2 = box2->m_normals;
+
+	b2Assert(0 <= edge1 && edge1 < 4);
+
+	// Get the normal of the reference edge in box2's frame.
+	b2Vec2 normal1 = b2MulT(xf2.q, b2Mul(xf1.q, box1->m_normals[edge1]));
+
+	// Find the incident edge on box2.
+	float32 dots[4];
+	dots[0] = b2Dot(normal1, normals2[0]);
+	dots[1] = b2Dot(normal1, normals2[1]);
+	dots[2] = -dots[0];
+	dots[3] = -dots[1];
+
+	int32 index = 0;
+	float32 minDot = dots[0];
+	for (int32 i = 1; i < 4; ++i)
+	{
+		if (dots[i] < minDot)
+		{
+			minDot = dots[i];
+			index = i;
+		}
+	}
+
+	b2SetIncidentEdge(c, edge1, box2, xf2, index, (index + 1) & 3);
 }
 
 // Find edge normal of max separation on A - return if separating axis is found
@@ -192,19 +317,27 @@ static void b2FindIncidentEdge(b2ClipVertex c[2],
 // The normal points from 1 to 2
 void b2CollidePolygons(b2Manifold* manifold,
 					  const b2PolygonShape* polyA, const b2Transform& xfA,
-					  const b2PolygonShape* polyB, const b2Transform& xfB)
+					  const b2PolygonShape* polyB, const b2Transform& xfB,
+					  float32 speculativeDistance)
 {
 	manifold->pointCount = 0;
 	float32 totalRadius = polyA->m_radius + polyB->m_radius;
+	float32 maxSeparation = totalRadius + speculativeDistance;
+
+	bool boxes = polyA->m_isBox && polyB->m_isBox;
 
 	int32 edgeA = 0;
-	float32 separationA = b2FindMaxSeparation(&edgeA, polyA, xfA, polyB, xfB);
-	if (separationA > totalRadius)
+	float32 separationA = boxes ?
+		b2FindMaxSeparationBox(&edgeA, polyA, xfA, polyB, xfB) :
+		b2FindMaxSeparation(&edgeA, polyA, xfA, polyB, xfB);
+	if (separationA > maxSeparation)
 		return;
 
 	int32 edgeB = 0;
-	float32 separationB = b2FindMaxSeparation(&edgeB, polyB, xfB, polyA, xfA);
-	if (separationB > totalRadius)
+	float32 separationB = boxes ?
+		b2FindMaxSeparationBox(&edgeB, polyB, xfB, polyA, xfA) :
+		b2FindMaxSeparation(&edgeB, polyB, xfB, polyA, xfA);
+	if (separationB > maxSeparation)
 		return;
 
 	const b2PolygonShape* poly1;	// reference polygon
@@ -237,7 +370,14 @@ void b2CollidePolygons(b2Manifold* manifold,
 	}
 
 	b2ClipVertex incidentEdge[2];
-	b2FindIncidentEdge(incidentEdge, poly1, xf1, edge1, poly2, xf2);
+	if (boxes)
+	{
+		b2FindIncidentEdgeBox(incidentEdge, poly1, xf1, edge1, poly2, xf2);
+	}
+	else
+	{
+		b2FindIncidentEdge(incidentEdge, poly1, xf1, edge1, poly2, xf2);
+	}
 
 	int32 count1 = poly1->m_vertexCount;
 	const b2Vec2* vertices1 = poly1->m_vertices;
@@ -295,7 +435,7 @@ void b2CollidePolygons(b2Manifold* manifold,
 	{
 		float32 separation = b2Dot(normal, clipPoints2[i].v) - frontOffset;
 
-		if (separation <= totalRadius)
+		if (separation <= maxSeparation)
 		{
 			b2ManifoldPoint* cp = manifold->points + pointCount;
 			cp->localPoint = b2MulT(xf2, clipPoints2[i].v);
@@ -19,6 +19,10 @@
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/b2Distance.h>
 
+#ifdef B2_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
 void b2WorldManifold::Initialize(const b2Manifold* manifold,
 						  const b2Transform& xfA, float32 radiusA,
 						  const b2Transform& xfB, float32 radiusB)
@@ -247,3 +251,80 @@ bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
 
 	return output.distance < 10.0f * b2_epsilon;
 }
+
+#ifdef B2_SIMD_SSE2
+
+// Project four vertices onto d. Lanes at or past count are set to b2_maxFloat.
+static inline __m128 b2ProjectVertices4(const b2Vec2* vertices, int32 first, int32 count, __m128 dx, __m128 dy)
+{
+	// Load x0 y0 x1 y1 and x2 y2 x3 y3, then split into x and y.
+	__m128 v01 = _mm_loadu_ps(&vertices[first].x);
+	__m128 v23 = _mm_loadu_ps(&vertices[first + 2].x);
+	__m128 xs = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 ys = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(3, 1, 3, 1));
+
+	// Same operations as b2Dot, so the results are the same.
+	__m128 dots = _mm_add_ps(_mm_mul_ps(xs, dx), _mm_mul_ps(ys, dy));
+
+	__m128i lanes = _mm_set_epi32(first + 3, first + 2, first + 1, first);
+	__m128 valid = _mm_castsi128_ps(_mm_cmplt_epi32(lanes, _mm_set1_epi32(count)));
+	return _mm_or_ps(_mm_and_ps(valid, dots), _mm_andnot_ps(valid, _mm_set1_ps(b2_maxFloat)));
+}
+
+int32 b2FindMinProjection(const b2Vec2* vertices, int32 count, const b2Vec2& d)
+{
+	b2Assert(0 < count && count <= b2_maxPolygonVertices);
+
+	__m128 dx = _mm_set1_ps(d.x);
+	__m128 dy = _mm_set1_ps(d.y);
+
+	__m128 dots0 = b2ProjectVertices4(vertices, 0, count, dx, dy);
+	__m128 dots1 = _mm_set1_ps(b2_maxFloat);
+	if (count > 4)
+	{
+		dots1 = b2ProjectVertices4(vertices, 4, count, dx, dy);
+	}
+
+	// Reduce to the minimum, then take the first lane that holds it.
+	__m128 m = _mm_min_ps(dots0, dots1);
+	m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+
+	int32 mask = _mm_movemask_ps(_mm_cmpeq_ps(dots0, m)) | (_mm_movemask_ps(_mm_cmpeq_ps(dots1, m)) << 4);
+	if (mask == 0)
+	{
+		// Only NaN projections. The scalar loop keeps the first vertex.
+		return 0;
+	}
+
+	int32 index = 0;
+	while ((mask & 1) == 0)
+	{
+		mask >>= 1;
+		++index;
+	}
+	return index;
+}
+
+#else
+
+int32 b2FindMinProjection(const b2Vec2* vertices, int32 count, const b2Vec2& d)
+{
+	b2Assert(0 < count && count <= b2_maxPolygonVertices);
+
+	int32 index = 0;
+	float32 minDot = b2_maxFloat;
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 dot = b2Dot(vertices[i], d);
+		if (dot < minDot)
+		{
+			minDot = dot;
+			index = i;
+		}
+	}
+
+	return index;
+}
+
+#endif
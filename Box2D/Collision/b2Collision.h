@@ -214,35 +214,48 @@ struct b2AABB
 	b2Vec2 upperBound;	///< the upper vertex
 };
 
+/// The collide functions below keep manifold points that are separated by up to
+/// speculativeDistance, so that a solver can act on shapes that are about to touch.
+
 /// Compute the collision manifold between two circles.
 void b2CollideCircles(b2Manifold* manifold,
 					  const b2CircleShape* circleA, const b2Transform& xfA,
-					  const b2CircleShape* circleB, const b2Transform& xfB);
+					  const b2CircleShape* circleB, const b2Transform& xfB,
+					  float32 speculativeDistance = 0.0f);
 
 /// Compute the collision manifold between a polygon and a circle.
 void b2CollidePolygonAndCircle(b2Manifold* manifold,
 							   const b2PolygonShape* polygonA, const b2Transform& xfA,
-							   const b2CircleShape* circleB, const b2Transform& xfB);
+							   const b2CircleShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
 
 /// Compute the collision manifold between two polygons.
 void b2CollidePolygons(b2Manifold* manifold,
 					   const b2PolygonShape* polygonA, const b2Transform& xfA,
-					   const b2PolygonShape* polygonB, const b2Transform& xfB);
+					   const b2PolygonShape* polygonB, const b2Transform& xfB,
+					   float32 speculativeDistance = 0.0f);
 
 /// Compute the collision manifold between an edge and a circle.
 void b2CollideEdgeAndCircle(b2Manifold* manifold,
 							   const b2EdgeShape* polygonA, const b2Transform& xfA,
-							   const b2CircleShape* circleB, const b2Transform& xfB);
+							   const b2CircleShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
 
 /// Compute the collision manifold between an edge and a circle.
 void b2CollideEdgeAndPolygon(b2Manifold* manifold,
 							   const b2EdgeShape* edgeA, const b2Transform& xfA,
-							   const b2PolygonShape* circleB, const b2Transform& xfB);
+							   const b2PolygonShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
 
 /// Clipping for contact manifolds.
 int32 b2ClipSegmentToLine(b2ClipVertex vOut[2], const b2ClipVertex vIn[2],
 							const b2Vec2& normal, float32 offset, int32 vertexIndexA);
 
+/// Find the vertex with the smallest projection onto a direction. Ties go to
+/// the lowest index. The vertex array must hold b2_maxPolygonVertices vertices,
+/// only the first count are used.
+int32 b2FindMinProjection(const b2Vec2* vertices, int32 count, const b2Vec2& d);
+
 /// Determine if two generic shapes overlap.
 bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
 					const b2Shape* shapeB, int32 indexB,
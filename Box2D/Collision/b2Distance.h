@@ -83,6 +83,14 @@ struct b2DistanceOutput
 	int32 iterations;	///< number of GJK iterations used
 };
 
+/// GJK counters of one or more b2Distance calls.
+struct b2DistanceStats
+{
+	int32 calls;
+	int32 iters;
+	int32 maxIters;
+};
+
 /// Compute the closest points between two shapes. Supports any combination of:
 /// b2CircleShape, b2PolygonShape, b2EdgeShape. The simplex cache is input/output.
 /// On the first call set b2SimplexCache.count to zero.
@@ -90,6 +98,13 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache, 
 				const b2DistanceInput* input);
 
+/// Same as above, but adds the counters to stats instead of the global GJK
+/// statistics, so it can be called from several threads.
+void b2Distance(b2DistanceOutput* output,
+				b2SimplexCache* cache,
+				const b2DistanceInput* input,
+				b2DistanceStats* stats);
+
 
 //////////////////////////////////////////////////////////////////////////
 
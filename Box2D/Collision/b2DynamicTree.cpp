@@ -22,13 +22,16 @@
 using namespace std;
 
 
-b2DynamicTree::b2DynamicTree()
+b2DynamicTree::b2DynamicTree(b2Allocator* allocator)
 {
+	m_allocator = allocator ? allocator : b2GetDefaultAllocator();
+
 	m_root = b2_nullNode;
 
 	m_nodeCapacity = 16;
+	m_maxNodeCapacity = m_nodeCapacity;
 	m_nodeCount = 0;
-	m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	m_nodes = (b2TreeNode*)m_allocator->Allocate(m_nodeCapacity * sizeof(b2TreeNode));
 	memset(m_nodes, 0, m_nodeCapacity * sizeof(b2TreeNode));
 
 	// Build a linked list for the free list.
@@ -49,7 +52,7 @@ b2DynamicTree::b2DynamicTree()
 b2DynamicTree::~b2DynamicTree()
 {
 	// This frees the entire tree in one shot.
-	b2Free(m_nodes);
+	m_allocator->Free(m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
 }
 
 // Allocate a node from the pool. Grow the pool if necessary.
@@ -62,10 +65,12 @@ int32 b2DynamicTree::AllocateNode()
 
 		// The free list is empty. Rebuild a bigger pool.
 		b2TreeNode* oldNodes = m_nodes;
+		int32 oldCapacity = m_nodeCapacity;
 		m_nodeCapacity *= 2;
-		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+		m_maxNodeCapacity = b2Max(m_maxNodeCapacity, m_nodeCapacity);
+		m_nodes = (b2TreeNode*)m_allocator->Allocate(m_nodeCapacity * sizeof(b2TreeNode));
 		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2TreeNode));
-		b2Free(oldNodes);
+		m_allocator->Free(oldNodes, oldCapacity * sizeof(b2TreeNode));
 
 		// Build a linked list for the free list. The parent
 		// pointer becomes the "next" pointer.
@@ -102,6 +107,48 @@ void b2DynamicTree::FreeNode(int32 nodeId)
 	--m_nodeCount;
 }
 
+bool b2DynamicTree::ShrinkNodePool()
+{
+	// Find the end of the nodes in use.
+	int32 used = m_nodeCapacity;
+	while (used > 0 && m_nodes[used - 1].height == -1)
+	{
+		--used;
+	}
+
+	// Keep the capacity on the growth schedule.
+	int32 capacity = 16;
+	while (capacity < used)
+	{
+		capacity *= 2;
+	}
+
+	if (capacity >= m_nodeCapacity)
+	{
+		return false;
+	}
+
+	b2TreeNode* oldNodes = m_nodes;
+	int32 oldCapacity = m_nodeCapacity;
+	m_nodeCapacity = capacity;
+	m_nodes = (b2TreeNode*)m_allocator->Allocate(m_nodeCapacity * sizeof(b2TreeNode));
+	memcpy(m_nodes, oldNodes, m_nodeCapacity * sizeof(b2TreeNode));
+	m_allocator->Free(oldNodes, oldCapacity * sizeof(b2TreeNode));
+
+	// Rebuild the free list over the remaining pool in index order.
+	m_freeList = b2_nullNode;
+	for (int32 i = m_nodeCapacity - 1; i >= 0; --i)
+	{
+		if (m_nodes[i].height == -1)
+		{
+			m_nodes[i].next = m_freeList;
+			m_freeList = i;
+		}
+	}
+
+	return true;
+}
+
 // Create a proxy in the tree as a leaf node. We return the index
 // of the node instead of a pointer so that we can grow
 // the node pool.
@@ -696,7 +743,8 @@ int32 b2DynamicTree::GetMaxBalance() const
 
 void b2DynamicTree::RebuildBottomUp()
 {
-	int32* nodes = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32 nodeBufferSize = m_nodeCount * sizeof(int32);
+	int32* nodes = (int32*)m_allocator->Allocate(nodeBufferSize);
 	int32 count = 0;
 
 	// Build array of leaves. Free the rest.
@@ -765,7 +813,7 @@ void b2DynamicTree::RebuildBottomUp()
 	}
 
 	m_root = nodes[0];
-	b2Free(nodes);
+	m_allocator->Free(nodes, nodeBufferSize);
 
 	Validate();
 }
@@ -21,6 +21,7 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2GrowableStack.h>
+#include <Box2D/Common/b2Allocator.h>
 
 #define b2_nullNode (-1)
 
@@ -62,7 +63,8 @@ class b2DynamicTree
 {
 public:
 	/// Constructing the tree initializes the node pool.
-	b2DynamicTree();
+	/// @param allocator supplies the node pool. NULL means the default allocator.
+	b2DynamicTree(b2Allocator* allocator = NULL);
 
 	/// Destroy the tree, freeing the node pool.
 	~b2DynamicTree();
@@ -118,6 +120,17 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Release the free nodes at the end of the node pool. Proxy ids are
+	/// node indices, so nodes in use are never moved.
+	/// @return true if the pool was shrunk.
+	bool ShrinkNodePool();
+
+	/// Get the number of nodes the pool can hold.
+	int32 GetNodeCapacity() const;
+
+	/// Get the largest node capacity reached.
+	int32 GetMaxNodeCapacity() const;
+
 private:
 
 	int32 AllocateNode();
@@ -134,11 +147,14 @@ private:
 	void ValidateStructure(int32 index) const;
 	void ValidateMetrics(int32 index) const;
 
+	b2Allocator* m_allocator;
+
 	int32 m_root;
 
 	b2TreeNode* m_nodes;
 	int32 m_nodeCount;
 	int32 m_nodeCapacity;
+	int32 m_maxNodeCapacity;
 
 	int32 m_freeList;
 
@@ -154,6 +170,16 @@ inline void* b2DynamicTree::GetUserData(int32 proxyId) const
 	return m_nodes[proxyId].userData;
 }
 
+inline int32 b2DynamicTree::GetNodeCapacity() const
+{
+	return m_nodeCapacity;
+}
+
+inline int32 b2DynamicTree::GetMaxNodeCapacity() const
+{
+	return m_maxNodeCapacity;
+}
+
 inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -27,6 +27,7 @@ using namespace std;
 
 int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
 int32 b2_toiRootIters, b2_toiMaxRootIters;
+extern int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
 
 struct b2SeparationFunction
 {
@@ -252,11 +253,43 @@ struct b2SeparationFunction
 	b2Vec2 m_axis;
 };
 
+void b2ResetTOIStats(b2TOIStats* stats)
+{
+	stats->calls = 0;
+	stats->iters = 0;
+	stats->maxIters = 0;
+	stats->rootIters = 0;
+	stats->maxRootIters = 0;
+	stats->gjk.calls = 0;
+	stats->gjk.iters = 0;
+	stats->gjk.maxIters = 0;
+}
+
+void b2AddTOIStats(const b2TOIStats* stats)
+{
+	b2_toiCalls += stats->calls;
+	b2_toiIters += stats->iters;
+	b2_toiMaxIters = b2Max(b2_toiMaxIters, stats->maxIters);
+	b2_toiRootIters += stats->rootIters;
+	b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, stats->maxRootIters);
+	b2_gjkCalls += stats->gjk.calls;
+	b2_gjkIters += stats->gjk.iters;
+	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, stats->gjk.maxIters);
+}
+
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
+{
+	b2TOIStats stats;
+	b2ResetTOIStats(&stats);
+	b2TimeOfImpact(output, input, &stats);
+	b2AddTOIStats(&stats);
+}
+
 // CCD via the local separating axis method. This seeks progression
 // by computing the largest time at which separation is maintained.
-void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2TOIStats* stats)
 {
-	++b2_toiCalls;
+	++stats->calls;
 
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
@@ -304,7 +337,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		distanceInput.transformA = xfA;
 		distanceInput.transformB = xfB;
 		b2DistanceOutput distanceOutput;
-		b2Distance(&distanceOutput, &cache, &distanceInput);
+		b2Distance(&distanceOutput, &cache, &distanceInput, &stats->gjk);
 
 		// If the shapes are overlapped, we give up on continuous collision.
 		if (distanceOutput.distance <= 0.0f)
@@ -444,7 +477,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 
 				++rootIterCount;
-				++b2_toiRootIters;
+				++stats->rootIters;
 
 				if (rootIterCount == 50)
 				{
@@ -452,7 +485,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 			}
 
-			b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, rootIterCount);
+			stats->maxRootIters = b2Max(stats->maxRootIters, rootIterCount);
 
 			++pushBackIter;
 
@@ -463,7 +496,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 
 		++iter;
-		++b2_toiIters;
+		++stats->iters;
 
 		if (done)
 		{
@@ -479,5 +512,5 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 	}
 
-	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
+	stats->maxIters = b2Max(stats->maxIters, iter);
 }
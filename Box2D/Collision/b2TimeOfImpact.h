@@ -48,6 +48,24 @@ struct b2TOIOutput
 	float32 t;
 };
 
+/// TOI counters of one or more b2TimeOfImpact calls, with the counters of the
+/// GJK calls they made.
+struct b2TOIStats
+{
+	int32 calls;
+	int32 iters;
+	int32 maxIters;
+	int32 rootIters;
+	int32 maxRootIters;
+	b2DistanceStats gjk;
+};
+
+/// Clear the counters.
+void b2ResetTOIStats(b2TOIStats* stats);
+
+/// Add the counters to the global TOI and GJK statistics.
+void b2AddTOIStats(const b2TOIStats* stats);
+
 /// Compute the upper bound on time before two shapes penetrate. Time is represented as
 /// a fraction between [0,tMax]. This uses a swept separating axis and may miss some intermediate,
 /// non-tunneling collision. If you change the time interval, you should call this function
@@ -55,4 +73,8 @@ struct b2TOIOutput
 /// Note: use b2Distance to compute the contact point and normal at the time of impact.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input);
 
+/// Same as above, but adds the counters to stats instead of the global
+/// statistics, so it can be called from several threads.
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2TOIStats* stats);
+
 #endif
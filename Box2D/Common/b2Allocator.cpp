@@ -0,0 +1,188 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2Allocator.h>
+#include <Box2D/Common/b2Math.h>
+
+void* b2DefaultAllocator::Allocate(int32 size)
+{
+	return b2Alloc(size);
+}
+
+void b2DefaultAllocator::Free(void* mem, int32 size)
+{
+	B2_NOT_USED(size);
+	b2Free(mem);
+}
+
+b2Allocator* b2GetDefaultAllocator()
+{
+	static b2DefaultAllocator s_allocator;
+	return &s_allocator;
+}
+
+b2TrackingAllocator::b2TrackingAllocator(b2Allocator* parent)
+{
+	m_parent = parent ? parent : b2GetDefaultAllocator();
+	m_bytes = 0;
+	m_peakBytes = 0;
+	m_count = 0;
+	m_totalCount = 0;
+}
+
+b2TrackingAllocator::~b2TrackingAllocator()
+{
+	// Everything should be returned before the tracker goes away.
+	b2Assert(m_count == 0);
+}
+
+void* b2TrackingAllocator::Allocate(int32 size)
+{
+	m_bytes += size;
+	m_peakBytes = b2Max(m_peakBytes, m_bytes);
+	++m_count;
+	++m_totalCount;
+	return m_parent->Allocate(size);
+}
+
+void b2TrackingAllocator::Free(void* mem, int32 size)
+{
+	if (mem == NULL)
+	{
+		return;
+	}
+
+	b2Assert(m_count > 0 && m_bytes >= size);
+	m_bytes -= size;
+	--m_count;
+	m_parent->Free(mem, size);
+}
+
+// Page header. The page data follows the header.
+struct b2ArenaPage
+{
+	b2ArenaPage* next;
+	int32 size;
+	int32 used;
+};
+
+// Keep the returned blocks aligned for any type stored in the world.
+const int32 b2_arenaAlignment = 16;
+const int32 b2_arenaHeaderSize = (sizeof(b2ArenaPage) + b2_arenaAlignment - 1) & ~(b2_arenaAlignment - 1);
+
+b2ArenaAllocator::b2ArenaAllocator(int32 pageSize, b2Allocator* parent)
+{
+	b2Assert(pageSize > b2_arenaHeaderSize);
+	m_parent = parent ? parent : b2GetDefaultAllocator();
+	m_pages = NULL;
+	m_pageSize = pageSize;
+	m_bytesUsed = 0;
+	m_bytesReserved = 0;
+	m_last = NULL;
+	m_lastSize = 0;
+}
+
+b2ArenaAllocator::~b2ArenaAllocator()
+{
+	Reset();
+}
+
+void* b2ArenaAllocator::Allocate(int32 size)
+{
+	if (size == 0)
+	{
+		return NULL;
+	}
+
+	int32 alignedSize = (size + b2_arenaAlignment - 1) & ~(b2_arenaAlignment - 1);
+	int32 capacity = m_pageSize - b2_arenaHeaderSize;
+
+	// Large blocks get a dedicated page. It is linked behind the current
+	// page so that small blocks keep bumping out of the current page.
+	if (alignedSize > capacity / 4)
+	{
+		int32 pageSize = b2_arenaHeaderSize + alignedSize;
+		b2ArenaPage* page = (b2ArenaPage*)m_parent->Allocate(pageSize);
+		page->size = pageSize;
+		page->used = pageSize;
+		if (m_pages)
+		{
+			page->next = m_pages->next;
+			m_pages->next = page;
+		}
+		else
+		{
+			page->next = NULL;
+			m_pages = page;
+		}
+
+		m_bytesReserved += pageSize;
+		m_bytesUsed += alignedSize;
+		return (char*)page + b2_arenaHeaderSize;
+	}
+
+	if (m_pages == NULL || m_pages->used + alignedSize > m_pages->size)
+	{
+		b2ArenaPage* page = (b2ArenaPage*)m_parent->Allocate(m_pageSize);
+		page->size = m_pageSize;
+		page->used = b2_arenaHeaderSize;
+		page->next = m_pages;
+		m_pages = page;
+		m_bytesReserved += m_pageSize;
+	}
+
+	char* mem = (char*)m_pages + m_pages->used;
+	m_pages->used += alignedSize;
+	m_bytesUsed += alignedSize;
+
+	m_last = mem;
+	m_lastSize = alignedSize;
+	return mem;
+}
+
+void b2ArenaAllocator::Free(void* mem, int32 size)
+{
+	B2_NOT_USED(size);
+
+	// Only the most recent block can be reclaimed. This lets temporary
+	// buffers that are freed right away be reused.
+	if (mem != NULL && mem == m_last)
+	{
+		m_pages->used -= m_lastSize;
+		m_bytesUsed -= m_lastSize;
+		m_last = NULL;
+		m_lastSize = 0;
+	}
+}
+
+void b2ArenaAllocator::Reset()
+{
+	b2ArenaPage* page = m_pages;
+	while (page)
+	{
+		b2ArenaPage* next = page->next;
+		m_parent->Free(page, page->size);
+		page = next;
+	}
+
+	m_pages = NULL;
+	m_bytesUsed = 0;
+	m_bytesReserved = 0;
+	m_last = NULL;
+	m_lastSize = 0;
+}
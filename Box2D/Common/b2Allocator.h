@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ALLOCATOR_H
+#define B2_ALLOCATOR_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// The heap interface used by a world. All of the world's long lived heap memory
+/// (block allocator chunks, the dynamic tree node pool, broad-phase buffers and
+/// stack allocator overflow) is obtained through this interface.
+/// Implement this to route a world's memory to your own allocator. The allocator
+/// is owned by you and must outlive the world.
+class b2Allocator
+{
+public:
+	virtual ~b2Allocator() {}
+
+	/// Allocate a block of memory. This should not return NULL for a positive size.
+	virtual void* Allocate(int32 size) = 0;
+
+	/// Free a block of memory. The size is the one passed to Allocate.
+	virtual void Free(void* mem, int32 size) = 0;
+};
+
+/// This allocator forwards to b2Alloc and b2Free. It is used by worlds
+/// that are not given an allocator.
+class b2DefaultAllocator : public b2Allocator
+{
+public:
+	void* Allocate(int32 size);
+	void Free(void* mem, int32 size);
+};
+
+/// Get the process wide default allocator.
+b2Allocator* b2GetDefaultAllocator();
+
+/// This allocator forwards to another allocator and keeps count of the
+/// memory passing through it. Use this to attribute memory to a world.
+class b2TrackingAllocator : public b2Allocator
+{
+public:
+	/// @param parent the allocator that supplies the memory. NULL means the default allocator.
+	b2TrackingAllocator(b2Allocator* parent = NULL);
+	~b2TrackingAllocator();
+
+	void* Allocate(int32 size);
+	void Free(void* mem, int32 size);
+
+	/// Get the number of bytes currently allocated.
+	int32 GetBytesAllocated() const { return m_bytes; }
+
+	/// Get the largest number of bytes that were allocated at once.
+	int32 GetPeakBytes() const { return m_peakBytes; }
+
+	/// Get the number of live allocations.
+	int32 GetAllocationCount() const { return m_count; }
+
+	/// Get the number of calls to Allocate since construction.
+	int32 GetTotalAllocationCount() const { return m_totalCount; }
+
+	/// Reset the peak to the current number of bytes.
+	void ResetPeak() { m_peakBytes = m_bytes; }
+
+private:
+
+	b2Allocator* m_parent;
+
+	int32 m_bytes;
+	int32 m_peakBytes;
+	int32 m_count;
+	int32 m_totalCount;
+};
+
+struct b2ArenaPage;
+
+/// This is a region allocator. Memory is bumped out of large pages and
+/// individual frees are ignored, except for the most recent allocation. All
+/// the memory is released in one shot by Reset or by the destructor.
+/// Since growable buffers abandon their old storage in the arena, this is best
+/// suited to worlds that are built up front and thrown away as a whole.
+/// @warning destroy the world before resetting or destroying its arena.
+class b2ArenaAllocator : public b2Allocator
+{
+public:
+	/// @param pageSize the size of each page requested from the parent.
+	/// @param parent the allocator that supplies the pages. NULL means the default allocator.
+	b2ArenaAllocator(int32 pageSize = 256 * 1024, b2Allocator* parent = NULL);
+	~b2ArenaAllocator();
+
+	void* Allocate(int32 size);
+	void Free(void* mem, int32 size);
+
+	/// Release all pages back to the parent allocator.
+	void Reset();
+
+	/// Get the number of bytes handed out and not rolled back.
+	int32 GetBytesUsed() const { return m_bytesUsed; }
+
+	/// Get the number of bytes requested from the parent allocator.
+	int32 GetBytesReserved() const { return m_bytesReserved; }
+
+private:
+
+	b2Allocator* m_parent;
+	b2ArenaPage* m_pages;
+	int32 m_pageSize;
+
+	int32 m_bytesUsed;
+	int32 m_bytesReserved;
+
+	char* m_last;
+	int32 m_lastSize;
+};
+
+#endif
@@ -17,10 +17,12 @@
 */
 
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Math.h>
 #include <cstdlib>
 #include <climits>
 #include <cstring>
 #include <memory>
+#include <algorithm>
 using namespace std;
 
 int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] = 
@@ -54,16 +56,23 @@ struct b2Block
 	b2Block* next;
 };
 
-b2BlockAllocator::b2BlockAllocator()
+b2BlockAllocator::b2BlockAllocator(b2Allocator* allocator)
 {
 	b2Assert(b2_blockSizes < UCHAR_MAX);
 
+	m_allocator = allocator ? allocator : b2GetDefaultAllocator();
+
 	m_chunkSpace = b2_chunkArrayIncrement;
 	m_chunkCount = 0;
-	m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
+	m_chunks = (b2Chunk*)m_allocator->Allocate(m_chunkSpace * sizeof(b2Chunk));
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_classChunkCounts, 0, sizeof(m_classChunkCounts));
+
+	m_largeBytes = 0;
+	m_peakBytes = 0;
+	UpdatePeak();
 
 	if (s_blockSizeLookupInitialized == false)
 	{
@@ -90,10 +99,10 @@ b2BlockAllocator::~b2BlockAllocator()
 {
 	for (int32 i = 0; i < m_chunkCount; ++i)
 	{
-		b2Free(m_chunks[i].blocks);
+		m_allocator->Free(m_chunks[i].blocks, b2_chunkSize);
 	}
 
-	b2Free(m_chunks);
+	m_allocator->Free(m_chunks, m_chunkSpace * sizeof(b2Chunk));
 }
 
 void* b2BlockAllocator::Allocate(int32 size)
@@ -105,7 +114,9 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		return b2Alloc(size);
+		m_largeBytes += size;
+		UpdatePeak();
+		return m_allocator->Allocate(size);
 	}
 
 	int32 index = s_blockSizeLookup[size];
@@ -122,15 +133,16 @@ void* b2BlockAllocator::Allocate(int32 size)
 		if (m_chunkCount == m_chunkSpace)
 		{
 			b2Chunk* oldChunks = m_chunks;
+			int32 oldSpace = m_chunkSpace;
 			m_chunkSpace += b2_chunkArrayIncrement;
-			m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
+			m_chunks = (b2Chunk*)m_allocator->Allocate(m_chunkSpace * sizeof(b2Chunk));
 			memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
 			memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
-			b2Free(oldChunks);
+			m_allocator->Free(oldChunks, oldSpace * sizeof(b2Chunk));
 		}
 
 		b2Chunk* chunk = m_chunks + m_chunkCount;
-		chunk->blocks = (b2Block*)b2Alloc(b2_chunkSize);
+		chunk->blocks = (b2Block*)m_allocator->Allocate(b2_chunkSize);
 #if defined(_DEBUG)
 		memset(chunk->blocks, 0xcd, b2_chunkSize);
 #endif
@@ -149,6 +161,8 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 		m_freeLists[index] = chunk->blocks->next;
 		++m_chunkCount;
+		++m_classChunkCounts[index];
+		UpdatePeak();
 
 		return chunk->blocks;
 	}
@@ -165,7 +179,8 @@ void b2BlockAllocator::Free(void* p, int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		b2Free(p);
+		m_largeBytes -= size;
+		m_allocator->Free(p, size);
 		return;
 	}
 
@@ -207,11 +222,177 @@ void b2BlockAllocator::Clear()
 {
 	for (int32 i = 0; i < m_chunkCount; ++i)
 	{
-		b2Free(m_chunks[i].blocks);
+		m_allocator->Free(m_chunks[i].blocks, b2_chunkSize);
 	}
 
 	m_chunkCount = 0;
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_classChunkCounts, 0, sizeof(m_classChunkCounts));
+}
+
+// Orders chunk indices by the address of their blocks.
+struct b2ChunkAddressLessThan
+{
+	bool operator()(int32 a, int32 b) const
+	{
+		return chunks[a].blocks < chunks[b].blocks;
+	}
+
+	const b2Chunk* chunks;
+};
+
+// Find the chunk that holds a block. The order array holds the chunk indices sorted by address.
+static int32 b2FindChunk(const b2Chunk* chunks, const int32* order, int32 count, const void* p)
+{
+	int32 low = 0;
+	int32 high = count - 1;
+	while (low < high)
+	{
+		int32 mid = (low + high + 1) / 2;
+		if ((const int8*)chunks[order[mid]].blocks <= (const int8*)p)
+		{
+			low = mid;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+
+	b2Assert((const int8*)chunks[order[low]].blocks <= (const int8*)p);
+	b2Assert((const int8*)p < (const int8*)chunks[order[low]].blocks + b2_chunkSize);
+	return order[low];
+}
+
+int32 b2BlockAllocator::Compact()
+{
+	if (m_chunkCount == 0)
+	{
+		return 0;
+	}
+
+	int32 bufferSize = m_chunkCount * sizeof(int32);
+	int32* order = (int32*)m_allocator->Allocate(bufferSize);
+	int32* freeCounts = (int32*)m_allocator->Allocate(bufferSize);
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		order[i] = i;
+		freeCounts[i] = 0;
+	}
+
+	b2ChunkAddressLessThan lessThan;
+	lessThan.chunks = m_chunks;
+	std::sort(order, order + m_chunkCount, lessThan);
+
+	// Count the free blocks in each chunk.
+	for (int32 i = 0; i < b2_blockSizes; ++i)
+	{
+		for (b2Block* block = m_freeLists[i]; block; block = block->next)
+		{
+			int32 index = b2FindChunk(m_chunks, order, m_chunkCount, block);
+			++freeCounts[index];
+		}
+	}
+
+	// A chunk is empty when all of its blocks are free. Mark it with -1.
+	int32 releaseCount = 0;
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		int32 blockCount = b2_chunkSize / m_chunks[i].blockSize;
+		if (freeCounts[i] == blockCount)
+		{
+			freeCounts[i] = -1;
+			++releaseCount;
+		}
+	}
+
+	if (releaseCount > 0)
+	{
+		// Unlink the blocks of empty chunks from the free lists.
+		for (int32 i = 0; i < b2_blockSizes; ++i)
+		{
+			b2Block** node = m_freeLists + i;
+			while (*node)
+			{
+				int32 index = b2FindChunk(m_chunks, order, m_chunkCount, *node);
+				if (freeCounts[index] == -1)
+				{
+					*node = (*node)->next;
+				}
+				else
+				{
+					node = &(*node)->next;
+				}
+			}
+		}
+
+		// Release the empty chunks and pack the chunk array.
+		int32 count = 0;
+		for (int32 i = 0; i < m_chunkCount; ++i)
+		{
+			b2Chunk* chunk = m_chunks + i;
+			if (freeCounts[i] == -1)
+			{
+				--m_classChunkCounts[s_blockSizeLookup[chunk->blockSize]];
+				m_allocator->Free(chunk->blocks, b2_chunkSize);
+				continue;
+			}
+
+			m_chunks[count++] = *chunk;
+		}
+
+		memset(m_chunks + count, 0, (m_chunkCount - count) * sizeof(b2Chunk));
+		m_chunkCount = count;
+	}
+
+	m_allocator->Free(freeCounts, bufferSize);
+	m_allocator->Free(order, bufferSize);
+	return releaseCount;
+}
+
+int32 b2BlockAllocator::GetBlockSize(int32 sizeClass)
+{
+	b2Assert(0 <= sizeClass && sizeClass < b2_blockSizes);
+	return s_blockSizes[sizeClass];
+}
+
+int32 b2BlockAllocator::GetSizeClass(int32 size)
+{
+	b2Assert(s_blockSizeLookupInitialized);
+	b2Assert(0 < size && size <= b2_maxBlockSize);
+	return s_blockSizeLookup[size];
+}
+
+int32 b2BlockAllocator::GetChunkCount(int32 sizeClass) const
+{
+	b2Assert(0 <= sizeClass && sizeClass < b2_blockSizes);
+	return m_classChunkCounts[sizeClass];
+}
+
+int32 b2BlockAllocator::GetFreeBlockCount(int32 sizeClass) const
+{
+	b2Assert(0 <= sizeClass && sizeClass < b2_blockSizes);
+	int32 count = 0;
+	for (b2Block* block = m_freeLists[sizeClass]; block; block = block->next)
+	{
+		++count;
+	}
+	return count;
+}
+
+int32 b2BlockAllocator::GetBytes() const
+{
+	return m_chunkSpace * sizeof(b2Chunk) + m_chunkCount * b2_chunkSize + m_largeBytes;
+}
+
+int32 b2BlockAllocator::GetPeakBytes() const
+{
+	return m_peakBytes;
+}
+
+void b2BlockAllocator::UpdatePeak()
+{
+	m_peakBytes = b2Max(m_peakBytes, GetBytes());
 }
@@ -20,6 +20,7 @@
 #define B2_BLOCK_ALLOCATOR_H
 
 #include <Box2D/Common/b2Settings.h>
+#include <Box2D/Common/b2Allocator.h>
 
 const int32 b2_chunkSize = 16 * 1024;
 const int32 b2_maxBlockSize = 640;
@@ -35,24 +36,56 @@ struct b2Chunk;
 class b2BlockAllocator
 {
 public:
-	b2BlockAllocator();
+	/// @param allocator supplies the chunks. NULL means the default allocator.
+	b2BlockAllocator(b2Allocator* allocator = NULL);
 	~b2BlockAllocator();
 
-	/// Allocate memory. This will use b2Alloc if the size is larger than b2_maxBlockSize.
+	/// Allocate memory. This will use the heap allocator if the size is larger than b2_maxBlockSize.
 	void* Allocate(int32 size);
 
-	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
+	/// Free memory. This will use the heap allocator if the size is larger than b2_maxBlockSize.
 	void Free(void* p, int32 size);
 
 	void Clear();
 
+	/// Release the chunks whose blocks are all free. This is O(free blocks * log(chunks)).
+	/// @return the number of chunks released.
+	int32 Compact();
+
+	/// Get the block size of a size class in [0, b2_blockSizes).
+	static int32 GetBlockSize(int32 sizeClass);
+
+	/// Get the size class used for a size in (0, b2_maxBlockSize].
+	/// Only valid once a block allocator has been constructed.
+	static int32 GetSizeClass(int32 size);
+
+	/// Get the number of chunks carved into blocks of a size class.
+	int32 GetChunkCount(int32 sizeClass) const;
+
+	/// Get the number of free blocks of a size class. This walks the free list.
+	int32 GetFreeBlockCount(int32 sizeClass) const;
+
+	/// Get the heap bytes held by this allocator: chunks, the chunk array and large blocks.
+	int32 GetBytes() const;
+
+	/// Get the largest value GetBytes has reached.
+	int32 GetPeakBytes() const;
+
 private:
 
+	void UpdatePeak();
+
+	b2Allocator* m_allocator;
+
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
 
 	b2Block* m_freeLists[b2_blockSizes];
+	int32 m_classChunkCounts[b2_blockSizes];
+
+	int32 m_largeBytes;
+	int32 m_peakBytes;
 
 	static int32 s_blockSizes[b2_blockSizes];
 	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
@@ -0,0 +1,198 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2ConcurrentBlockAllocator.h>
+#include <Box2D/Common/b2Math.h>
+#include <cstring>
+using namespace std;
+
+struct b2CachedBlock
+{
+	b2CachedBlock* next;
+};
+
+// Move fewer large blocks at once so a cache does not hoard whole chunks.
+static int32 b2GetBatchSize(int32 sizeClass)
+{
+	int32 blockCount = b2_chunkSize / b2BlockAllocator::GetBlockSize(sizeClass);
+	return b2Min(b2_blockCacheBatch, b2Max(blockCount / 2, 1));
+}
+
+b2BlockCache::b2BlockCache(b2ConcurrentBlockAllocator* allocator)
+{
+	m_allocator = allocator;
+	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_counts, 0, sizeof(m_counts));
+}
+
+b2BlockCache::~b2BlockCache()
+{
+	Flush();
+}
+
+void* b2BlockCache::Allocate(int32 size)
+{
+	if (size == 0)
+	{
+		return NULL;
+	}
+
+	b2Assert(0 < size);
+
+	if (size > b2_maxBlockSize)
+	{
+		return m_allocator->AllocateLarge(size);
+	}
+
+	int32 index = b2BlockAllocator::GetSizeClass(size);
+	if (m_freeLists[index] == NULL)
+	{
+		m_allocator->Refill(this, index);
+	}
+
+	b2CachedBlock* block = m_freeLists[index];
+	m_freeLists[index] = block->next;
+	--m_counts[index];
+	return block;
+}
+
+void b2BlockCache::Free(void* p, int32 size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	b2Assert(0 < size);
+
+	if (size > b2_maxBlockSize)
+	{
+		m_allocator->FreeLarge(p, size);
+		return;
+	}
+
+	int32 index = b2BlockAllocator::GetSizeClass(size);
+
+#ifdef _DEBUG
+	// Verify the memory address and size is valid.
+	int32 blockSize = b2BlockAllocator::GetBlockSize(index);
+	memset(p, 0xfd, blockSize);
+#endif
+
+	b2CachedBlock* block = (b2CachedBlock*)p;
+	block->next = m_freeLists[index];
+	m_freeLists[index] = block;
+	++m_counts[index];
+
+	// Keep one batch around for the next allocations and return the rest.
+	int32 batch = b2GetBatchSize(index);
+	if (m_counts[index] >= 2 * batch)
+	{
+		m_allocator->Return(this, index, batch);
+	}
+}
+
+void b2BlockCache::Flush()
+{
+	for (int32 i = 0; i < b2_blockSizes; ++i)
+	{
+		if (m_counts[i] > 0)
+		{
+			m_allocator->Return(this, i, m_counts[i]);
+		}
+	}
+}
+
+int32 b2BlockCache::GetBlockCount() const
+{
+	int32 count = 0;
+	for (int32 i = 0; i < b2_blockSizes; ++i)
+	{
+		count += m_counts[i];
+	}
+	return count;
+}
+
+b2ConcurrentBlockAllocator::b2ConcurrentBlockAllocator(b2Allocator* allocator)
+	: m_shared(allocator)
+{
+}
+
+b2ConcurrentBlockAllocator::~b2ConcurrentBlockAllocator()
+{
+}
+
+void b2ConcurrentBlockAllocator::Refill(b2BlockCache* cache, int32 sizeClass)
+{
+	int32 blockSize = b2BlockAllocator::GetBlockSize(sizeClass);
+	int32 batch = b2GetBatchSize(sizeClass);
+
+	b2MutexLock lock(&m_mutex);
+	for (int32 i = 0; i < batch; ++i)
+	{
+		b2CachedBlock* block = (b2CachedBlock*)m_shared.Allocate(blockSize);
+		block->next = cache->m_freeLists[sizeClass];
+		cache->m_freeLists[sizeClass] = block;
+	}
+	cache->m_counts[sizeClass] += batch;
+}
+
+void b2ConcurrentBlockAllocator::Return(b2BlockCache* cache, int32 sizeClass, int32 count)
+{
+	b2Assert(count <= cache->m_counts[sizeClass]);
+	int32 blockSize = b2BlockAllocator::GetBlockSize(sizeClass);
+
+	b2MutexLock lock(&m_mutex);
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2CachedBlock* block = cache->m_freeLists[sizeClass];
+		cache->m_freeLists[sizeClass] = block->next;
+		m_shared.Free(block, blockSize);
+	}
+	cache->m_counts[sizeClass] -= count;
+}
+
+void* b2ConcurrentBlockAllocator::AllocateLarge(int32 size)
+{
+	b2MutexLock lock(&m_mutex);
+	return m_shared.Allocate(size);
+}
+
+void b2ConcurrentBlockAllocator::FreeLarge(void* p, int32 size)
+{
+	b2MutexLock lock(&m_mutex);
+	m_shared.Free(p, size);
+}
+
+int32 b2ConcurrentBlockAllocator::Compact()
+{
+	b2MutexLock lock(&m_mutex);
+	return m_shared.Compact();
+}
+
+int32 b2ConcurrentBlockAllocator::GetBytes() const
+{
+	b2MutexLock lock(&m_mutex);
+	return m_shared.GetBytes();
+}
+
+int32 b2ConcurrentBlockAllocator::GetPeakBytes() const
+{
+	b2MutexLock lock(&m_mutex);
+	return m_shared.GetPeakBytes();
+}
@@ -0,0 +1,102 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_CONCURRENT_BLOCK_ALLOCATOR_H
+#define B2_CONCURRENT_BLOCK_ALLOCATOR_H
+
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Mutex.h>
+
+/// The most blocks a cache moves to or from the shared allocator at once.
+const int32 b2_blockCacheBatch = 32;
+
+struct b2CachedBlock;
+class b2ConcurrentBlockAllocator;
+
+/// A per-thread cache of free blocks in front of a b2ConcurrentBlockAllocator.
+/// Each worker thread owns one cache and must not share it. Blocks may be
+/// freed through a different cache than the one that allocated them.
+/// The cache is a b2Allocator, so it can be handed to code that takes one.
+class b2BlockCache : public b2Allocator
+{
+public:
+	b2BlockCache(b2ConcurrentBlockAllocator* allocator);
+
+	/// Returns the cached blocks to the shared allocator.
+	~b2BlockCache();
+
+	void* Allocate(int32 size);
+	void Free(void* p, int32 size);
+
+	/// Return all cached blocks to the shared allocator.
+	void Flush();
+
+	/// Get the number of free blocks held by this cache.
+	int32 GetBlockCount() const;
+
+private:
+
+	friend class b2ConcurrentBlockAllocator;
+
+	b2ConcurrentBlockAllocator* m_allocator;
+
+	b2CachedBlock* m_freeLists[b2_blockSizes];
+	int32 m_counts[b2_blockSizes];
+};
+
+/// A block allocator that can be used from several threads at once. Threads
+/// allocate through their own b2BlockCache. A cache refills from and returns
+/// to the shared chunk lists in batches, so the shared lock is taken once per
+/// batch instead of once per block. Large blocks go straight to the shared
+/// allocator under the lock.
+class b2ConcurrentBlockAllocator
+{
+public:
+	/// @param allocator supplies the chunks. It is only called under the lock.
+	/// NULL means the default allocator.
+	b2ConcurrentBlockAllocator(b2Allocator* allocator = NULL);
+
+	/// All caches must be destroyed or flushed first.
+	~b2ConcurrentBlockAllocator();
+
+	/// Release the chunks whose blocks are all free. Flush the caches first
+	/// to give back as much as possible.
+	/// @return the number of chunks released.
+	int32 Compact();
+
+	/// Get the heap bytes held by the shared allocator, including blocks
+	/// sitting in caches.
+	int32 GetBytes() const;
+
+	/// Get the largest value GetBytes has reached.
+	int32 GetPeakBytes() const;
+
+private:
+
+	friend class b2BlockCache;
+
+	void Refill(b2BlockCache* cache, int32 sizeClass);
+	void Return(b2BlockCache* cache, int32 sizeClass, int32 count);
+	void* AllocateLarge(int32 size);
+	void FreeLarge(void* p, int32 size);
+
+	mutable b2Mutex m_mutex;
+	b2BlockAllocator m_shared;
+};
+
+#endif
@@ -0,0 +1,89 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2Mutex.h>
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+b2Mutex::b2Mutex()
+{
+	b2Assert(sizeof(CRITICAL_SECTION) <= sizeof(m_handle));
+	InitializeCriticalSection((CRITICAL_SECTION*)m_handle);
+}
+
+b2Mutex::~b2Mutex()
+{
+	DeleteCriticalSection((CRITICAL_SECTION*)m_handle);
+}
+
+void b2Mutex::Lock()
+{
+	EnterCriticalSection((CRITICAL_SECTION*)m_handle);
+}
+
+void b2Mutex::Unlock()
+{
+	LeaveCriticalSection((CRITICAL_SECTION*)m_handle);
+}
+
+#elif defined(__linux__) || defined (__APPLE__)
+
+#include <pthread.h>
+
+b2Mutex::b2Mutex()
+{
+	b2Assert(sizeof(pthread_mutex_t) <= sizeof(m_handle));
+	pthread_mutex_init((pthread_mutex_t*)m_handle, NULL);
+}
+
+b2Mutex::~b2Mutex()
+{
+	pthread_mutex_destroy((pthread_mutex_t*)m_handle);
+}
+
+void b2Mutex::Lock()
+{
+	pthread_mutex_lock((pthread_mutex_t*)m_handle);
+}
+
+void b2Mutex::Unlock()
+{
+	pthread_mutex_unlock((pthread_mutex_t*)m_handle);
+}
+
+#else
+
+b2Mutex::b2Mutex()
+{
+}
+
+b2Mutex::~b2Mutex()
+{
+}
+
+void b2Mutex::Lock()
+{
+}
+
+void b2Mutex::Unlock()
+{
+}
+
+#endif
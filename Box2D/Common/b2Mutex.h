@@ -0,0 +1,63 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_MUTEX_H
+#define B2_MUTEX_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// A non-recursive mutex. This has platform specific code. On platforms
+/// without thread support it does nothing.
+class b2Mutex
+{
+public:
+	b2Mutex();
+	~b2Mutex();
+
+	void Lock();
+	void Unlock();
+
+private:
+
+	b2Mutex(const b2Mutex&);
+	b2Mutex& operator=(const b2Mutex&);
+
+	// Storage for the native handle, so the platform headers stay out of here.
+	union
+	{
+		void* m_align;
+		char m_handle[64];
+	};
+};
+
+/// Locks a mutex for the lifetime of the object.
+class b2MutexLock
+{
+public:
+	b2MutexLock(b2Mutex* mutex) : m_mutex(mutex) { m_mutex->Lock(); }
+	~b2MutexLock() { m_mutex->Unlock(); }
+
+private:
+
+	b2MutexLock(const b2MutexLock&);
+	b2MutexLock& operator=(const b2MutexLock&);
+
+	b2Mutex* m_mutex;
+};
+
+#endif
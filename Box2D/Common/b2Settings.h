@@ -52,6 +52,15 @@ typedef double float64;
 /// this too much because b2BlockAllocator has a maximum object size.
 #define b2_maxPolygonVertices	8
 
+/// The polygon colliders use SSE2 where the compiler targets it (always on x64).
+/// The SSE2 kernels give the same results as the scalar code, bit for bit.
+/// They work on two groups of four vertices. Define B2_NO_SIMD to build the
+/// scalar code only.
+#if !defined(B2_NO_SIMD) && b2_maxPolygonVertices == 8 && \
+	(defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define B2_SIMD_SSE2
+#endif
+
 /// This is used to fatten AABBs in the dynamic tree. This allows proxies
 /// to move by a small amount without triggering a tree adjustment.
 /// This is in meters.
@@ -70,6 +79,15 @@ typedef double float64;
 /// chosen to be numerically significant, but visually insignificant.
 #define b2_angularSlop			(2.0f / 180.0f * b2_pi)
 
+/// A contact keeps its manifold while the relative position of its bodies stays
+/// within this distance of the position the manifold was computed at. Set this
+/// and b2_manifoldAngularTolerance to zero to compute every manifold every step.
+#define b2_manifoldLinearTolerance	(0.1f * b2_linearSlop)
+
+/// A contact keeps its manifold while the relative rotation of its bodies stays
+/// within this angle (in radians) of the rotation the manifold was computed at.
+#define b2_manifoldAngularTolerance	0.0005f
+
 /// The radius of the polygon/edge shape skin. This should not be modified. Making
 /// this smaller means polygons will have an insufficient buffer for continuous collision.
 /// Making it larger may create artifacts for vertex collision.
@@ -84,6 +102,36 @@ typedef double float64;
 /// Maximum number of contacts to be handled to solve a TOI impact.
 #define b2_maxTOIContacts			32
 
+/// With speculative contacts, shapes are solved once they are within this distance
+/// plus the distance they can approach each other during the step.
+#define b2_speculativeDistance		(4.0f * b2_linearSlop)
+
+/// A body only takes part in continuous collision if its swept motion in a step
+/// is larger than this fraction of its smallest shape extent. Slower bodies
+/// cannot tunnel, so resting and slowly moving bodies skip the TOI.
+#define b2_ccdMotionFraction		0.5f
+
+/// The smallest number of TOI computations handed to a task executor at once.
+#define b2_minTOITaskRange			32
+
+/// With adaptive iterations, an island stops its velocity iterations once no contact
+/// changes the relative velocity at its points by more than this in one iteration.
+#define b2_velocityTolerance		0.001f
+
+/// With a step budget, islands solved after this fraction of the budget has been
+/// spent use fewer iterations, unless they hold a bullet.
+#define b2_budgetIslandFraction		0.5f
+#define b2_budgetVelocityIterations	2
+#define b2_budgetPositionIterations	1
+
+/// With a step budget, continuous collision is only done for bullets if this
+/// fraction of the budget has been spent before it starts.
+#define b2_budgetTOIFraction		0.75f
+
+/// When a step overruns its budget, islands whose bodies all move slower than
+/// this multiple of the sleep tolerances are put to sleep.
+#define b2_budgetSleepFactor		4.0f
+
 /// A velocity threshold for elastic collisions. Any collision with a relative linear
 /// velocity below this threshold will be treated as inelastic.
 #define b2_velocityThreshold		1.0f
@@ -112,6 +160,18 @@ typedef double float64;
 #define b2_baumgarte				0.2f
 #define b2_toiBaugarte				0.75f
 
+/// The stiffness of contacts in the soft step solver, in cycles per second. This is
+/// limited to a quarter of the sub-step rate to keep the contacts stable. Contacts
+/// with static bodies use twice this stiffness.
+#define b2_contactHertz				60.0f
+
+/// The damping ratio of contacts in the soft step solver. Contacts are heavily
+/// over-damped so that overlap is removed without bouncing.
+#define b2_contactDampingRatio		10.0f
+
+/// The maximum velocity used by the soft step solver to push overlapping shapes apart.
+#define b2_contactPushVelocity		3.0f
+
 
 // Sleep
 
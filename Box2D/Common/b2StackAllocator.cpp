@@ -19,37 +19,117 @@
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Math.h>
 
-b2StackAllocator::b2StackAllocator()
+b2StackAllocator::b2StackAllocator(b2Allocator* allocator, int32 initialCapacity)
 {
-	m_index = 0;
+	b2Assert(initialCapacity > 0);
+	m_allocator = allocator ? allocator : b2GetDefaultAllocator();
+	m_segmentCount = 0;
+	m_segment = 0;
+	m_initialCapacity = initialCapacity;
+	m_capacity = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_growCount = 0;
+	m_fallbackCount = 0;
 	m_entryCount = 0;
 }
 
 b2StackAllocator::~b2StackAllocator()
 {
-	b2Assert(m_index == 0);
+	b2Assert(m_allocation == 0);
 	b2Assert(m_entryCount == 0);
+
+	for (int32 i = m_segmentCount - 1; i >= 0; --i)
+	{
+		m_allocator->Free(m_segments[i].data, m_segments[i].capacity);
+	}
+}
+
+// Make a segment that can hold size bytes current. Segments above the
+// current one are empty, so an undersized one is replaced.
+bool b2StackAllocator::PushSegment(int32 size)
+{
+	int32 next = m_segmentCount > 0 ? m_segment + 1 : 0;
+	if (next < m_segmentCount)
+	{
+		b2StackSegment* segment = m_segments + next;
+		b2Assert(segment->index == 0);
+		if (segment->capacity >= size)
+		{
+			m_segment = next;
+			return true;
+		}
+
+		// Too small. Drop it and everything above it.
+		for (int32 i = m_segmentCount - 1; i >= next; --i)
+		{
+			m_capacity -= m_segments[i].capacity;
+			m_allocator->Free(m_segments[i].data, m_segments[i].capacity);
+		}
+		m_segmentCount = next;
+	}
+
+	if (m_segmentCount == b2_maxStackSegments || size > b2_maxStackSegmentSize)
+	{
+		return false;
+	}
+
+	// Double the capacity so the number of segments stays small.
+	int32 capacity = m_initialCapacity;
+	if (m_segmentCount > 0)
+	{
+		int32 lastCapacity = m_segments[m_segmentCount - 1].capacity;
+		capacity = lastCapacity <= b2_maxStackSegmentSize / 2 ? 2 * lastCapacity : b2_maxStackSegmentSize;
+	}
+	capacity = b2Max(capacity, size);
+
+	b2StackSegment* segment = m_segments + m_segmentCount;
+	segment->data = (char*)m_allocator->Allocate(capacity);
+	segment->capacity = capacity;
+	segment->index = 0;
+	m_capacity += capacity;
+
+	// The first segment is not growth.
+	if (m_segmentCount > 0)
+	{
+		++m_growCount;
+	}
+
+	m_segment = m_segmentCount;
+	++m_segmentCount;
+	return true;
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
 	b2Assert(m_entryCount < b2_maxStackEntries);
 
+	// Keep the next block aligned for any type.
+	size = (size + b2_stackAlignment - 1) & ~(b2_stackAlignment - 1);
+
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+
+	bool fits = m_segmentCount > 0 && m_segments[m_segment].index + size <= m_segments[m_segment].capacity;
+	if (fits == false)
 	{
-		entry->data = (char*)b2Alloc(size);
-		entry->usedMalloc = true;
+		fits = PushSegment(size);
 	}
-	else
+
+	if (fits)
 	{
-		entry->data = m_data + m_index;
+		b2StackSegment* segment = m_segments + m_segment;
+		entry->data = segment->data + segment->index;
 		entry->usedMalloc = false;
-		m_index += size;
+		segment->index += size;
+	}
+	else
+	{
+		entry->data = (char*)m_allocator->Allocate(size);
+		entry->usedMalloc = true;
+		++m_fallbackCount;
 	}
+	entry->segment = m_segment;
 
 	m_allocation += size;
 	m_maxAllocation = b2Max(m_maxAllocation, m_allocation);
@@ -65,19 +145,32 @@ void b2StackAllocator::Free(void* p)
 	b2Assert(p == entry->data);
 	if (entry->usedMalloc)
 	{
-		b2Free(p);
+		m_allocator->Free(p, entry->size);
 	}
 	else
 	{
-		m_index -= entry->size;
+		m_segments[entry->segment].index -= entry->size;
 	}
 	m_allocation -= entry->size;
 	--m_entryCount;
 
+	// Return to the segment of the previous entry.
+	m_segment = m_entryCount > 0 ? m_entries[m_entryCount - 1].segment : 0;
+
 	p = NULL;
 }
 
+int32 b2StackAllocator::GetAllocation() const
+{
+	return m_allocation;
+}
+
 int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
 }
+
+int32 b2StackAllocator::GetCapacity() const
+{
+	return m_capacity;
+}
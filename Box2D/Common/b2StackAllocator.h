@@ -20,39 +20,84 @@
 #define B2_STACK_ALLOCATOR_H
 
 #include <Box2D/Common/b2Settings.h>
+#include <Box2D/Common/b2Allocator.h>
 
 const int32 b2_stackSize = 100 * 1024;	// 100k
 const int32 b2_maxStackEntries = 32;
+const int32 b2_maxStackSegments = 16;
+const int32 b2_maxStackSegmentSize = 64 * 1024 * 1024;	// 64M
+const int32 b2_stackAlignment = 16;
 
 struct b2StackEntry
 {
 	char* data;
 	int32 size;
+	int32 segment;
 	bool usedMalloc;
 };
 
+struct b2StackSegment
+{
+	char* data;
+	int32 capacity;
+	int32 index;
+};
+
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// The stack is made of segments obtained from the heap allocator. When
+// the segments are full a larger one is added and kept, so the stack
+// stops touching the heap once it has grown to the working set. Segments
+// grow up to b2_maxStackSegmentSize. Only when all segments are in use,
+// or for a single allocation larger than that, does it fall back to
+// one-off heap blocks. Sizes are rounded up to b2_stackAlignment, so every
+// block is as aligned as the segment it comes from.
 class b2StackAllocator
 {
 public:
-	b2StackAllocator();
+	/// @param allocator supplies the segments. NULL means the default allocator.
+	/// @param initialCapacity the size of the first segment.
+	b2StackAllocator(b2Allocator* allocator = NULL, int32 initialCapacity = b2_stackSize);
 	~b2StackAllocator();
 
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	/// Get the number of bytes currently allocated.
+	int32 GetAllocation() const;
+
+	/// Get the largest number of bytes that were allocated at once.
 	int32 GetMaxAllocation() const;
 
+	/// Get the number of bytes reserved by the segments.
+	int32 GetCapacity() const;
+
+	/// Get the number of segments added to the stack since construction.
+	int32 GetGrowCount() const { return m_growCount; }
+
+	/// Get the number of allocations that fell back to the heap since construction.
+	int32 GetFallbackCount() const { return m_fallbackCount; }
+
 private:
 
-	char m_data[b2_stackSize];
-	int32 m_index;
+	bool PushSegment(int32 size);
+
+	b2Allocator* m_allocator;
+
+	b2StackSegment m_segments[b2_maxStackSegments];
+	int32 m_segmentCount;
+	int32 m_segment;
+
+	int32 m_initialCapacity;
+	int32 m_capacity;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
 
+	int32 m_growCount;
+	int32 m_fallbackCount;
+
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
 };
@@ -0,0 +1,51 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_TASK_EXECUTOR_H
+#define B2_TASK_EXECUTOR_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// A task over a range of independent items. Executing different ranges of the
+/// same task concurrently is safe.
+class b2RangeTask
+{
+public:
+	virtual ~b2RangeTask() {}
+
+	/// Process the items [begin, end).
+	virtual void Execute(int32 begin, int32 end) = 0;
+};
+
+/// Implement this to run the parallel passes of a world on your own worker
+/// threads. Box2D does not create threads. The executor is owned by you and
+/// must outlive the world.
+class b2TaskExecutor
+{
+public:
+	virtual ~b2TaskExecutor() {}
+
+	/// Execute a task over the items [0, count) and return when all of them are
+	/// done. The range may be split into sub-ranges of at least minRange items,
+	/// which may run on any thread. Calling task->Execute(0, count) on the
+	/// calling thread is a valid implementation.
+	virtual void ParallelFor(b2RangeTask* task, int32 count, int32 minRange) = 0;
+};
+
+#endif
@@ -17,7 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Contacts/b2ChainAndCircleContact.h>
-#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Allocator.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Collision/Shapes/b2ChainShape.h>
 #include <Box2D/Collision/Shapes/b2EdgeShape.h>
@@ -25,13 +25,13 @@
 #include <new>
 using namespace std;
 
-b2Contact* b2ChainAndCircleContact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
+b2Contact* b2ChainAndCircleContact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2Allocator* allocator)
 {
 	void* mem = allocator->Allocate(sizeof(b2ChainAndCircleContact));
 	return new (mem) b2ChainAndCircleContact(fixtureA, indexA, fixtureB, indexB);
 }
 
-void b2ChainAndCircleContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+void b2ChainAndCircleContact::Destroy(b2Contact* contact, b2Allocator* allocator)
 {
 	((b2ChainAndCircleContact*)contact)->~b2ChainAndCircleContact();
 	allocator->Free(contact, sizeof(b2ChainAndCircleContact));
@@ -50,5 +50,6 @@ void b2ChainAndCircleContact::Evaluate(b2Manifold* manifold, const b2Transform&
 	b2EdgeShape edge;
 	chain->GetChildEdge(&edge, m_indexA);
 	b2CollideEdgeAndCircle(	manifold, &edge, xfA,
-							(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+							(b2CircleShape*)m_fixtureB->GetShape(), xfB,
+							m_speculativeDistance);
 }
@@ -21,14 +21,14 @@
 
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 
-class b2BlockAllocator;
+class b2Allocator;
 
 class b2ChainAndCircleContact : public b2Contact
 {
 public:
 	static b2Contact* Create(	b2Fixture* fixtureA, int32 indexA,
-								b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator);
-	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
+								b2Fixture* fixtureB, int32 indexB, b2Allocator* allocator);
+	static void Destroy(b2Contact* contact, b2Allocator* allocator);
 
 	b2ChainAndCircleContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
 	~b2ChainAndCircleContact() {}
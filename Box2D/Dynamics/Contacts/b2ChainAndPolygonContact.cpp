@@ -17,7 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Contacts/b2ChainAndPolygonContact.h>
-#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Allocator.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Collision/Shapes/b2ChainShape.h>
 #include <Box2D/Collision/Shapes/b2EdgeShape.h>
@@ -25,13 +25,13 @@
 #include <new>
 using namespace std;
 
-b2Contact* b2ChainAndPolygonContact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
+b2Contact* b2ChainAndPolygonContact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2Allocator* allocator)
 {
 	void* mem = allocator->Allocate(sizeof(b2ChainAndPolygonContact));
 	return new (mem) b2ChainAndPolygonContact(fixtureA, indexA, fixtureB, indexB);
 }
 
-void b2ChainAndPolygonContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+void b2ChainAndPolygonContact::Destroy(b2Contact* contact, b2Allocator* allocator)
 {
 	((b2ChainAndPolygonContact*)contact)->~b2ChainAndPolygonContact();
 	allocator->Free(contact, sizeof(b2ChainAndPolygonContact));
@@ -50,5 +50,6 @@ void b2ChainAndPolygonContact::Evaluate(b2Manifold* manifold, const b2Transform&
 	b2EdgeShape edge;
 	chain->GetChildEdge(&edge, m_indexA);
 	b2CollideEdgeAndPolygon(	manifold, &edge, xfA,
-								(b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+								(b2PolygonShape*)m_fixtureB->GetShape(), xfB,
+								m_speculativeDistance);
 }
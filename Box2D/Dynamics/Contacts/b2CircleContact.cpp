@@ -20,19 +20,19 @@
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
-#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Allocator.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 
 #include <new>
 using namespace std;
 
-b2Contact* b2CircleContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2BlockAllocator* allocator)
+b2Contact* b2CircleContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2Allocator* allocator)
 {
 	void* mem = allocator->Allocate(sizeof(b2CircleContact));
 	return new (mem) b2CircleContact(fixtureA, fixtureB);
 }
 
-void b2CircleContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+void b2CircleContact::Destroy(b2Contact* contact, b2Allocator* allocator)
 {
 	((b2CircleContact*)contact)->~b2CircleContact();
 	allocator->Free(contact, sizeof(b2CircleContact));
@@ -49,5 +49,6 @@ void b2CircleContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, con
 {
 	b2CollideCircles(manifold,
 					(b2CircleShape*)m_fixtureA->GetShape(), xfA,
-					(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+					(b2CircleShape*)m_fixtureB->GetShape(), xfB,
+					m_speculativeDistance);
 }
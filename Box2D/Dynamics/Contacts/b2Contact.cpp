@@ -29,8 +29,9 @@
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
-#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Allocator.h>
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactEvents.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 
@@ -39,34 +40,43 @@ bool b2Contact::s_initialized = false;
 
 void b2Contact::InitializeRegisters()
 {
-	AddType(b2CircleContact::Create, b2CircleContact::Destroy, b2Shape::e_circle, b2Shape::e_circle);
-	AddType(b2PolygonAndCircleContact::Create, b2PolygonAndCircleContact::Destroy, b2Shape::e_polygon, b2Shape::e_circle);
-	AddType(b2PolygonContact::Create, b2PolygonContact::Destroy, b2Shape::e_polygon, b2Shape::e_polygon);
-	AddType(b2EdgeAndCircleContact::Create, b2EdgeAndCircleContact::Destroy, b2Shape::e_edge, b2Shape::e_circle);
-	AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, b2Shape::e_edge, b2Shape::e_polygon);
-	AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, b2Shape::e_chain, b2Shape::e_circle);
-	AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, b2Shape::e_chain, b2Shape::e_polygon);
+	AddType(b2CircleContact::Create, b2CircleContact::Destroy, UpdateBatch<b2CircleContact>,
+		b2Shape::e_circle, b2Shape::e_circle);
+	AddType(b2PolygonAndCircleContact::Create, b2PolygonAndCircleContact::Destroy, UpdateBatch<b2PolygonAndCircleContact>,
+		b2Shape::e_polygon, b2Shape::e_circle);
+	AddType(b2PolygonContact::Create, b2PolygonContact::Destroy, UpdateBatch<b2PolygonContact>,
+		b2Shape::e_polygon, b2Shape::e_polygon);
+	AddType(b2EdgeAndCircleContact::Create, b2EdgeAndCircleContact::Destroy, UpdateBatch<b2EdgeAndCircleContact>,
+		b2Shape::e_edge, b2Shape::e_circle);
+	AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, UpdateBatch<b2EdgeAndPolygonContact>,
+		b2Shape::e_edge, b2Shape::e_polygon);
+	AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, UpdateBatch<b2ChainAndCircleContact>,
+		b2Shape::e_chain, b2Shape::e_circle);
+	AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, UpdateBatch<b2ChainAndPolygonContact>,
+		b2Shape::e_chain, b2Shape::e_polygon);
 }
 
 void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
-						b2Shape::Type type1, b2Shape::Type type2)
+						b2ContactUpdateFcn* updateFcn, b2Shape::Type type1, b2Shape::Type type2)
 {
 	b2Assert(0 <= type1 && type1 < b2Shape::e_typeCount);
 	b2Assert(0 <= type2 && type2 < b2Shape::e_typeCount);
 	
 	s_registers[type1][type2].createFcn = createFcn;
 	s_registers[type1][type2].destroyFcn = destoryFcn;
+	s_registers[type1][type2].updateFcn = updateFcn;
 	s_registers[type1][type2].primary = true;
 
 	if (type1 != type2)
 	{
 		s_registers[type2][type1].createFcn = createFcn;
 		s_registers[type2][type1].destroyFcn = destoryFcn;
+		s_registers[type2][type1].updateFcn = updateFcn;
 		s_registers[type2][type1].primary = false;
 	}
 }
 
-b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
+b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2Allocator* allocator)
 {
 	if (s_initialized == false)
 	{
@@ -98,7 +108,7 @@ b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtu
 	}
 }
 
-void b2Contact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+void b2Contact::Destroy(b2Contact* contact, b2Allocator* allocator)
 {
 	b2Assert(s_initialized == true);
 
@@ -130,8 +140,12 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 
 	m_manifold.pointCount = 0;
 
-	m_prev = NULL;
-	m_next = NULL;
+	m_managerIndex = b2_nullContactIndex;
+	m_islandEpoch = 0;
+
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
 
 	m_nodeA.contact = NULL;
 	m_nodeA.prev = NULL;
@@ -144,14 +158,62 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_nodeB.other = NULL;
 
 	m_toiCount = 0;
+	m_toiIndex = b2_nullContactIndex;
+	m_speculativeDistance = 0.0f;
+	m_manifoldDistance = 0.0f;
 
 	m_friction = b2MixFriction(m_fixtureA->m_friction, m_fixtureB->m_friction);
 	m_restitution = b2MixRestitution(m_fixtureA->m_restitution, m_fixtureB->m_restitution);
 }
 
+void b2Contact::FlagForFiltering()
+{
+	m_fixtureA->m_body->m_world->m_contactManager.FlagForFiltering(this);
+}
+
+b2Contact* b2Contact::GetNext()
+{
+	const b2ContactManager& contactManager = m_fixtureA->m_body->m_world->m_contactManager;
+	int32 next = m_managerIndex + 1;
+	return next < contactManager.m_contactCount ? contactManager.m_contacts[next] : NULL;
+}
+
+const b2Contact* b2Contact::GetNext() const
+{
+	const b2ContactManager& contactManager = m_fixtureA->m_body->m_world->m_contactManager;
+	int32 next = m_managerIndex + 1;
+	return next < contactManager.m_contactCount ? contactManager.m_contacts[next] : NULL;
+}
+
+void b2Contact::Update(b2ContactListener* listener, b2ContactEventBuffer* events)
+{
+	b2Shape::Type typeA = m_fixtureA->GetType();
+	b2Shape::Type typeB = m_fixtureB->GetType();
+	b2Assert(s_registers[typeA][typeB].primary);
+
+	b2Contact* contact = this;
+	s_registers[typeA][typeB].updateFcn(&contact, 1, listener, events);
+}
+
+template <typename T>
+int32 b2Contact::UpdateBatch(b2Contact** contacts, int32 count, b2ContactListener* listener,
+							b2ContactEventBuffer* events)
+{
+	int32 reuseCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (contacts[i]->Update<T>(listener, events))
+		{
+			++reuseCount;
+		}
+	}
+	return reuseCount;
+}
+
 // Update the contact manifold and touching status.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
-void b2Contact::Update(b2ContactListener* listener)
+template <typename T>
+bool b2Contact::Update(b2ContactListener* listener, b2ContactEventBuffer* events)
 {
 	b2Manifold oldManifold = m_manifold;
 
@@ -159,6 +221,7 @@ void b2Contact::Update(b2ContactListener* listener)
 	m_flags |= e_enabledFlag;
 
 	bool touching = false;
+	bool reused = false;
 	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
 
 	bool sensorA = m_fixtureA->IsSensor();
@@ -170,24 +233,67 @@ void b2Contact::Update(b2ContactListener* listener)
 	const b2Transform& xfA = bodyA->GetTransform();
 	const b2Transform& xfB = bodyB->GetTransform();
 
-	// Is this contact a sensor?
+	// A fixture became a sensor since the contact was filtered. The contact
+	// stops touching and is destroyed by the next filtering pass.
 	if (sensor)
 	{
-		const b2Shape* shapeA = m_fixtureA->GetShape();
-		const b2Shape* shapeB = m_fixtureB->GetShape();
-		touching = b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB);
-
-		// Sensors don't generate manifolds.
 		m_manifold.pointCount = 0;
+		m_flags &= ~e_manifoldCacheFlag;
 	}
 	else
 	{
-		Evaluate(&m_manifold, xfA, xfB);
+		// The manifold is stored in the local frames of the bodies. If the bodies
+		// barely moved relative to each other, such as a stack sliding as a unit,
+		// the previous manifold and its impulses are still good.
+		b2Transform relativeXf = b2MulT(xfA, xfB);
+
+		float32 speculativeTime = bodyA->m_world->m_speculativeTime;
+		if (speculativeTime > 0.0f)
+		{
+			// Keep the points the shapes can reach during the step. This bounds
+			// the approach of any two points, including the rotation about the
+			// centers of mass.
+			float32 armA = bodyA->m_maxExtent + bodyA->Sweep().localCenter.Length();
+			float32 armB = bodyB->m_maxExtent + bodyB->Sweep().localCenter.Length();
+			float32 speed = b2Distance(bodyA->LinearVelocity(), bodyB->LinearVelocity()) +
+							b2Abs(bodyA->AngularVelocity()) * armA + b2Abs(bodyB->AngularVelocity()) * armB;
+			m_speculativeDistance = b2_speculativeDistance + speculativeTime * speed;
+		}
+		else
+		{
+			m_speculativeDistance = 0.0f;
+		}
+
+		// A manifold computed with a smaller margin misses the points the
+		// shapes can now reach.
+		if (m_speculativeDistance > m_manifoldDistance)
+		{
+			m_flags &= ~e_manifoldCacheFlag;
+		}
+
+		if (m_flags & e_manifoldCacheFlag)
+		{
+			b2Vec2 dp = relativeXf.p - m_relativeXf.p;
+			float32 ds = relativeXf.q.s - m_relativeXf.q.s;
+			float32 dc = relativeXf.q.c - m_relativeXf.q.c;
+			reused = b2Dot(dp, dp) < b2_manifoldLinearTolerance * b2_manifoldLinearTolerance &&
+					b2Abs(ds) < b2_manifoldAngularTolerance && b2Abs(dc) < b2_manifoldAngularTolerance;
+		}
+
+		if (reused == false)
+		{
+			// Call the collider directly. This avoids the virtual call.
+			static_cast<T*>(this)->T::Evaluate(&m_manifold, xfA, xfB);
+			m_relativeXf = relativeXf;
+			m_manifoldDistance = m_speculativeDistance;
+			m_flags |= e_manifoldCacheFlag;
+		}
+
 		touching = m_manifold.pointCount > 0;
 
 		// Match old contact ids to new contact ids and copy the
 		// stored impulses to warm start the solver.
-		for (int32 i = 0; i < m_manifold.pointCount; ++i)
+		for (int32 i = 0; i < m_manifold.pointCount && reused == false; ++i)
 		{
 			b2ManifoldPoint* mp2 = m_manifold.points + i;
 			mp2->normalImpulse = 0.0f;
@@ -223,18 +329,52 @@ void b2Contact::Update(b2ContactListener* listener)
 		m_flags &= ~e_touchingFlag;
 	}
 
-	if (wasTouching == false && touching == true && listener)
+	if (wasTouching == false && touching == true)
 	{
-		listener->BeginContact(this);
+		if (events)
+		{
+			events->AddBegin(this);
+		}
+
+		if (listener)
+		{
+			listener->BeginContact(this);
+		}
 	}
 
-	if (wasTouching == true && touching == false && listener)
+	if (wasTouching == true && touching == false)
 	{
-		listener->EndContact(this);
+		if (events)
+		{
+			events->AddEnd(this);
+		}
+
+		if (listener)
+		{
+			listener->EndContact(this);
+		}
 	}
 
 	if (sensor == false && touching && listener)
 	{
 		listener->PreSolve(this, &oldManifold);
 	}
+
+	// Solid touching contacts hold their bodies in one island. A contact
+	// disabled by PreSolve is not solved, so it does not link the bodies.
+	bool linked = touching && sensor == false && (m_flags & e_enabledFlag) == e_enabledFlag;
+	if (linked != (m_island != NULL))
+	{
+		b2IslandManager* islandManager = &bodyA->m_world->m_islandManager;
+		if (linked)
+		{
+			islandManager->LinkContact(this);
+		}
+		else
+		{
+			islandManager->UnlinkContact(this);
+		}
+	}
+
+	return reused;
 }
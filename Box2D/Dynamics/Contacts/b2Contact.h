@@ -28,9 +28,13 @@ class b2Body;
 class b2Contact;
 class b2Fixture;
 class b2World;
-class b2BlockAllocator;
+class b2Allocator;
 class b2StackAllocator;
+struct b2PersistentIsland;
 class b2ContactListener;
+class b2ContactEventBuffer;
+
+const int32 b2_nullContactIndex = -1;
 
 /// Friction mixing law. The idea is to allow either fixture to drive the restitution to zero.
 /// For example, anything slides on ice.
@@ -48,13 +52,16 @@ inline float32 b2MixRestitution(float32 restitution1, float32 restitution2)
 
 typedef b2Contact* b2ContactCreateFcn(	b2Fixture* fixtureA, int32 indexA,
 										b2Fixture* fixtureB, int32 indexB,
-										b2BlockAllocator* allocator);
-typedef void b2ContactDestroyFcn(b2Contact* contact, b2BlockAllocator* allocator);
+										b2Allocator* allocator);
+typedef void b2ContactDestroyFcn(b2Contact* contact, b2Allocator* allocator);
+typedef int32 b2ContactUpdateFcn(b2Contact** contacts, int32 count, b2ContactListener* listener,
+									b2ContactEventBuffer* events);
 
 struct b2ContactRegister
 {
 	b2ContactCreateFcn* createFcn;
 	b2ContactDestroyFcn* destroyFcn;
+	b2ContactUpdateFcn* updateFcn;
 	bool primary;
 };
 
@@ -97,7 +104,8 @@ public:
 	/// Has this contact been disabled?
 	bool IsEnabled() const;
 
-	/// Get the next contact in the world's contact list.
+	/// Get the next contact in the world's contact list. The order changes
+	/// when contacts are destroyed.
 	b2Contact* GetNext();
 	const b2Contact* GetNext() const;
 
@@ -144,13 +152,13 @@ protected:
 	friend class b2ContactSolver;
 	friend class b2Body;
 	friend class b2Fixture;
+	friend class b2IslandManager;
+	friend class b2ContactEventBuffer;
+	friend class b2TOIQueue;
 
 	// Flags stored in m_flags
 	enum
 	{
-		// Used when crawling contact graph when forming islands.
-		e_islandFlag		= 0x0001,
-
         // Set when the shapes are touching.
 		e_touchingFlag		= 0x0002,
 
@@ -164,33 +172,55 @@ protected:
 		e_bulletHitFlag		= 0x0010,
 
 		// This contact has a valid TOI in m_toi
-		e_toiFlag			= 0x0020
+		e_toiFlag			= 0x0020,
+
+		// The manifold was computed at the relative transform in m_relativeXf
+		// with the speculative distance in m_manifoldDistance
+		e_manifoldCacheFlag	= 0x0040
 	};
 
 	/// Flag this contact for filtering. Filtering will occur the next time step.
 	void FlagForFiltering();
 
 	static void AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destroyFcn,
-						b2Shape::Type typeA, b2Shape::Type typeB);
+						b2ContactUpdateFcn* updateFcn, b2Shape::Type typeA, b2Shape::Type typeB);
 	static void InitializeRegisters();
-	static b2Contact* Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator);
-	static void Destroy(b2Contact* contact, b2Shape::Type typeA, b2Shape::Type typeB, b2BlockAllocator* allocator);
-	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
+	static b2Contact* Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2Allocator* allocator);
+	static void Destroy(b2Contact* contact, b2Shape::Type typeA, b2Shape::Type typeB, b2Allocator* allocator);
+	static void Destroy(b2Contact* contact, b2Allocator* allocator);
 
 	b2Contact() : m_fixtureA(NULL), m_fixtureB(NULL) {}
 	b2Contact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
 	virtual ~b2Contact() {}
 
-	void Update(b2ContactListener* listener);
+	void Update(b2ContactListener* listener, b2ContactEventBuffer* events);
+
+	/// Update contacts that all have the shape pair type of the contact class T.
+	/// The collider of T is called directly instead of through the vtable.
+	/// @return the number of contacts that kept their previous manifold.
+	template <typename T>
+	static int32 UpdateBatch(b2Contact** contacts, int32 count, b2ContactListener* listener,
+							b2ContactEventBuffer* events);
+
+	/// @return true if the previous manifold was kept.
+	template <typename T>
+	bool Update(b2ContactListener* listener, b2ContactEventBuffer* events);
 
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
 	uint32 m_flags;
 
-	// World pool and list pointers.
-	b2Contact* m_prev;
-	b2Contact* m_next;
+	// Index in the contact manager's contact array.
+	int32 m_managerIndex;
+
+	// Used when crawling contact graph when forming islands.
+	uint32 m_islandEpoch;
+
+	// Enabled, touching solid contacts are linked into the island of their bodies.
+	b2PersistentIsland* m_island;
+	b2Contact* m_islandPrev;
+	b2Contact* m_islandNext;
 
 	// Nodes for connecting bodies.
 	b2ContactEdge m_nodeA;
@@ -204,9 +234,23 @@ protected:
 
 	b2Manifold m_manifold;
 
+	// The transform of fixture B's body relative to fixture A's body when
+	// the manifold was computed.
+	b2Transform m_relativeXf;
+
 	int32 m_toiCount;
 	float32 m_toi;
 
+	// Manifold points are kept up to this separation. This is zero unless the
+	// world uses speculative contacts.
+	float32 m_speculativeDistance;
+
+	// The speculative distance the cached manifold was computed with.
+	float32 m_manifoldDistance;
+
+	// Position in the world's TOI queue during SolveTOI.
+	int32 m_toiIndex;
+
 	float32 m_friction;
 	float32 m_restitution;
 };
@@ -253,16 +297,6 @@ inline bool b2Contact::IsTouching() const
 	return (m_flags & e_touchingFlag) == e_touchingFlag;
 }
 
-inline b2Contact* b2Contact::GetNext()
-{
-	return m_next;
-}
-
-inline const b2Contact* b2Contact::GetNext() const
-{
-	return m_next;
-}
-
 inline b2Fixture* b2Contact::GetFixtureA()
 {
 	return m_fixtureA;
@@ -293,10 +327,6 @@ inline int32 b2Contact::GetChildIndexB() const
 	return m_indexB;
 }
 
-inline void b2Contact::FlagForFiltering()
-{
-	m_flags |= e_filterFlag;
-}
 
 inline void b2Contact::SetFriction(float32 friction)
 {
@@ -41,6 +41,57 @@ struct b2ContactPositionConstraint
 	int32 pointCount;
 };
 
+struct b2PositionSolverManifold
+{
+	void Initialize(b2ContactPositionConstraint* pc, const b2Transform& xfA, const b2Transform& xfB, int32 index)
+	{
+		b2Assert(pc->pointCount > 0);
+
+		switch (pc->type)
+		{
+		case b2Manifold::e_circles:
+			{
+				b2Vec2 pointA = b2Mul(xfA, pc->localPoint);
+				b2Vec2 pointB = b2Mul(xfB, pc->localPoints[0]);
+				normal = pointB - pointA;
+				normal.Normalize();
+				point = 0.5f * (pointA + pointB);
+				separation = b2Dot(pointB - pointA, normal) - pc->radiusA - pc->radiusB;
+			}
+			break;
+
+		case b2Manifold::e_faceA:
+			{
+				normal = b2Mul(xfA.q, pc->localNormal);
+				b2Vec2 planePoint = b2Mul(xfA, pc->localPoint);
+
+				b2Vec2 clipPoint = b2Mul(xfB, pc->localPoints[index]);
+				separation = b2Dot(clipPoint - planePoint, normal) - pc->radiusA - pc->radiusB;
+				point = clipPoint;
+			}
+			break;
+
+		case b2Manifold::e_faceB:
+			{
+				normal = b2Mul(xfB.q, pc->localNormal);
+				b2Vec2 planePoint = b2Mul(xfB, pc->localPoint);
+
+				b2Vec2 clipPoint = b2Mul(xfA, pc->localPoints[index]);
+				separation = b2Dot(clipPoint - planePoint, normal) - pc->radiusA - pc->radiusB;
+				point = clipPoint;
+
+				// Ensure normal points from A to B
+				normal = -normal;
+			}
+			break;
+		}
+	}
+
+	b2Vec2 normal;
+	b2Vec2 point;
+	float32 separation;
+};
+
 b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 {
 	m_step = def->step;
@@ -75,10 +126,10 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		vc->restitution = contact->m_restitution;
 		vc->indexA = bodyA->m_islandIndex;
 		vc->indexB = bodyB->m_islandIndex;
-		vc->invMassA = bodyA->m_invMass;
-		vc->invMassB = bodyB->m_invMass;
-		vc->invIA = bodyA->m_invI;
-		vc->invIB = bodyB->m_invI;
+		vc->invMassA = bodyA->InvMass();
+		vc->invMassB = bodyB->InvMass();
+		vc->invIA = bodyA->InvI();
+		vc->invIB = bodyB->InvI();
 		vc->contactIndex = i;
 		vc->pointCount = pointCount;
 		vc->K.SetZero();
@@ -87,12 +138,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
 		pc->indexA = bodyA->m_islandIndex;
 		pc->indexB = bodyB->m_islandIndex;
-		pc->invMassA = bodyA->m_invMass;
-		pc->invMassB = bodyB->m_invMass;
-		pc->localCenterA = bodyA->m_sweep.localCenter;
-		pc->localCenterB = bodyB->m_sweep.localCenter;
-		pc->invIA = bodyA->m_invI;
-		pc->invIB = bodyB->m_invI;
+		pc->invMassA = bodyA->InvMass();
+		pc->invMassB = bodyB->InvMass();
+		pc->localCenterA = bodyA->Sweep().localCenter;
+		pc->localCenterB = bodyB->Sweep().localCenter;
+		pc->invIA = bodyA->InvI();
+		pc->invIB = bodyB->InvI();
 		pc->localNormal = manifold->localNormal;
 		pc->localPoint = manifold->localPoint;
 		pc->pointCount = pointCount;
@@ -121,6 +172,7 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 			vcp->normalMass = 0.0f;
 			vcp->tangentMass = 0.0f;
 			vcp->velocityBias = 0.0f;
+			vcp->relativeVelocity = 0.0f;
 
 			pc->localPoints[j] = cp->localPoint;
 		}
@@ -205,7 +257,20 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			// Setup a velocity bias for restitution.
 			vcp->velocityBias = 0.0f;
 			float32 vRel = b2Dot(vc->normal, vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA));
-			if (vRel < -b2_velocityThreshold)
+			vcp->relativeVelocity = vRel;
+			if (m_step.speculative)
+			{
+				// The shapes may close the gap this step, but no more. Restitution is
+				// applied after the velocity iterations, once it is known that the
+				// point was hit.
+				b2PositionSolverManifold psm;
+				psm.Initialize(pc, xfA, xfB, j);
+				if (psm.separation > 0.0f)
+				{
+					vcp->velocityBias = -psm.separation * m_step.inv_dt;
+				}
+			}
+			else if (vRel < -b2_velocityThreshold)
 			{
 				vcp->velocityBias = -vc->restitution * vRel;
 			}
@@ -285,8 +350,9 @@ void b2ContactSolver::WarmStart()
 	}
 }
 
-void b2ContactSolver::SolveVelocityConstraints()
+float32 b2ContactSolver::SolveVelocityConstraints()
 {
+	float32 residual = 0.0f;
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
@@ -310,6 +376,11 @@ void b2ContactSolver::SolveVelocityConstraints()
 
 		b2Assert(pointCount == 1 || pointCount == 2);
 
+		// Sum of the velocity changes along the constraint directions, for the
+		// residual. An impulse change dλ moves the relative velocity of a point
+		// by dλ times the inverse effective mass of the point.
+		float32 velocityDelta = 0.0f;
+
 		// Solve tangent constraints first because non-penetration is more important
 		// than friction.
 		for (int32 j = 0; j < pointCount; ++j)
@@ -329,6 +400,10 @@ void b2ContactSolver::SolveVelocityConstraints()
 			lambda = newImpulse - vcp->tangentImpulse;
 			vcp->tangentImpulse = newImpulse;
 
+			float32 rtA = b2Cross(vcp->rA, tangent);
+			float32 rtB = b2Cross(vcp->rB, tangent);
+			velocityDelta += b2Abs(lambda) * (mA + mB + iA * rtA * rtA + iB * rtB * rtB);
+
 			// Apply contact impulse
 			b2Vec2 P = lambda * tangent;
 
@@ -356,6 +431,10 @@ void b2ContactSolver::SolveVelocityConstraints()
 			lambda = newImpulse - vcp->normalImpulse;
 			vcp->normalImpulse = newImpulse;
 
+			float32 rnA = b2Cross(vcp->rA, normal);
+			float32 rnB = b2Cross(vcp->rB, normal);
+			velocityDelta += b2Abs(lambda) * (mA + mB + iA * rnA * rnA + iB * rnB * rnB);
+
 			// Apply contact impulse
 			b2Vec2 P = lambda * normal;
 			vA -= mA * P;
@@ -586,80 +665,243 @@ void b2ContactSolver::SolveVelocityConstraints()
 				// No solution, give up. This is hit sometimes, but it doesn't seem to matter.
 				break;
 			}
+
+			// The diagonal of K holds the inverse effective masses of the points.
+			velocityDelta += b2Abs(cp1->normalImpulse - a.x) * vc->K.ex.x + b2Abs(cp2->normalImpulse - a.y) * vc->K.ey.y;
 		}
 
 		m_velocities[indexA].v = vA;
 		m_velocities[indexA].w = wA;
 		m_velocities[indexB].v = vB;
 		m_velocities[indexB].w = wB;
+
+		residual = b2Max(residual, velocityDelta);
 	}
+
+	return residual;
 }
 
-void b2ContactSolver::StoreImpulses()
+struct b2Softness
+{
+	float32 biasRate;
+	float32 massScale;
+	float32 impulseScale;
+};
+
+// Soft constraint coefficients for a spring of the given frequency, advanced by
+// an implicit step of length h.
+static b2Softness b2MakeSoftness(float32 hertz, float32 h)
 {
+	float32 omega = 2.0f * b2_pi * hertz;
+	float32 a1 = 2.0f * b2_contactDampingRatio + h * omega;
+	float32 a2 = h * omega * a1;
+	float32 a3 = 1.0f / (1.0f + a2);
+
+	b2Softness softness;
+	softness.biasRate = omega / a1;
+	softness.massScale = a2 * a3;
+	softness.impulseScale = a3;
+	return softness;
+}
+
+void b2ContactSolver::SolveSoftVelocityConstraints(float32 h, bool useBias)
+{
+	float32 inv_h = 1.0f / h;
+
+	// Soft constraint coefficients. The stiffness is limited by the sub-step rate.
+	b2Softness soft = b2MakeSoftness(b2Min(b2_contactHertz, 0.25f * inv_h), h);
+	b2Softness staticSoft = b2MakeSoftness(b2Min(2.0f * b2_contactHertz, 0.25f * inv_h), h);
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
-		b2Manifold* manifold = m_contacts[vc->contactIndex]->GetManifold();
+		b2ContactPositionConstraint* pc = m_positionConstraints + i;
 
-		for (int32 j = 0; j < vc->pointCount; ++j)
+		int32 indexA = vc->indexA;
+		int32 indexB = vc->indexB;
+		float32 mA = vc->invMassA;
+		float32 iA = vc->invIA;
+		float32 mB = vc->invMassB;
+		float32 iB = vc->invIB;
+		int32 pointCount = vc->pointCount;
+
+		b2Vec2 vA = m_velocities[indexA].v;
+		float32 wA = m_velocities[indexA].w;
+		b2Vec2 vB = m_velocities[indexB].v;
+		float32 wB = m_velocities[indexB].w;
+
+		b2Transform xfA, xfB;
+		xfA.q.Set(m_positions[indexA].a);
+		xfB.q.Set(m_positions[indexB].a);
+		xfA.p = m_positions[indexA].c - b2Mul(xfA.q, pc->localCenterA);
+		xfB.p = m_positions[indexB].c - b2Mul(xfB.q, pc->localCenterB);
+
+		b2Vec2 normal = vc->normal;
+		b2Vec2 tangent = b2Cross(normal, 1.0f);
+		float32 friction = vc->friction;
+
+		// Contacts against static bodies are made stiffer.
+		const b2Softness& softness = (mA == 0.0f || mB == 0.0f) ? staticSoft : soft;
+
+		// Solve normal constraints
+		for (int32 j = 0; j < pointCount; ++j)
 		{
-			manifold->points[j].normalImpulse = vc->points[j].normalImpulse;
-			manifold->points[j].tangentImpulse = vc->points[j].tangentImpulse;
+			b2VelocityConstraintPoint* vcp = vc->points + j;
+
+			b2PositionSolverManifold psm;
+			psm.Initialize(pc, xfA, xfB, j);
+			float32 separation = psm.separation;
+
+			float32 bias = 0.0f;
+			float32 massScale = 1.0f;
+			float32 impulseScale = 0.0f;
+			if (separation > 0.0f)
+			{
+				// Speculative
+				bias = separation * inv_h;
+			}
+			else if (useBias)
+			{
+				// Leave the slop to keep the contact points persistent.
+				float32 C = b2Min(0.0f, separation + b2_linearSlop);
+				bias = b2Max(softness.biasRate * C, -b2_contactPushVelocity);
+				massScale = softness.massScale;
+				impulseScale = softness.impulseScale;
+			}
+
+			// Relative velocity at contact
+			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+			float32 vn = b2Dot(dv, normal);
+
+			// Compute normal impulse
+			float32 lambda = -vcp->normalMass * massScale * (vn + bias) - impulseScale * vcp->normalImpulse;
+
+			// Clamp the accumulated impulse
+			float32 newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - vcp->normalImpulse;
+			vcp->normalImpulse = newImpulse;
+
+			// Apply contact impulse
+			b2Vec2 P = lambda * normal;
+			vA -= mA * P;
+			wA -= iA * b2Cross(vcp->rA, P);
+
+			vB += mB * P;
+			wB += iB * b2Cross(vcp->rB, P);
 		}
+
+		// Solve tangent constraints
+		for (int32 j = 0; j < pointCount; ++j)
+		{
+			b2VelocityConstraintPoint* vcp = vc->points + j;
+
+			// Relative velocity at contact
+			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+
+			// Compute tangent force
+			float32 vt = b2Dot(dv, tangent);
+			float32 lambda = vcp->tangentMass * (-vt);
+
+			// b2Clamp the accumulated force
+			float32 maxFriction = friction * vcp->normalImpulse;
+			float32 newImpulse = b2Clamp(vcp->tangentImpulse + lambda, -maxFriction, maxFriction);
+			lambda = newImpulse - vcp->tangentImpulse;
+			vcp->tangentImpulse = newImpulse;
+
+			// Apply contact impulse
+			b2Vec2 P = lambda * tangent;
+
+			vA -= mA * P;
+			wA -= iA * b2Cross(vcp->rA, P);
+
+			vB += mB * P;
+			wB += iB * b2Cross(vcp->rB, P);
+		}
+
+		m_velocities[indexA].v = vA;
+		m_velocities[indexA].w = wA;
+		m_velocities[indexB].v = vB;
+		m_velocities[indexB].w = wB;
 	}
 }
 
-struct b2PositionSolverManifold
+void b2ContactSolver::ApplyRestitution()
 {
-	void Initialize(b2ContactPositionConstraint* pc, const b2Transform& xfA, const b2Transform& xfB, int32 index)
+	for (int32 i = 0; i < m_count; ++i)
 	{
-		b2Assert(pc->pointCount > 0);
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		if (vc->restitution == 0.0f)
+		{
+			continue;
+		}
 
-		switch (pc->type)
+		int32 indexA = vc->indexA;
+		int32 indexB = vc->indexB;
+		float32 mA = vc->invMassA;
+		float32 iA = vc->invIA;
+		float32 mB = vc->invMassB;
+		float32 iB = vc->invIB;
+		int32 pointCount = vc->pointCount;
+
+		b2Vec2 vA = m_velocities[indexA].v;
+		float32 wA = m_velocities[indexA].w;
+		b2Vec2 vB = m_velocities[indexB].v;
+		float32 wB = m_velocities[indexB].w;
+
+		b2Vec2 normal = vc->normal;
+
+		for (int32 j = 0; j < pointCount; ++j)
 		{
-		case b2Manifold::e_circles:
+			b2VelocityConstraintPoint* vcp = vc->points + j;
+
+			// Only points that were approaching and got hit bounce.
+			if (vcp->relativeVelocity > -b2_velocityThreshold || vcp->normalImpulse == 0.0f)
 			{
-				b2Vec2 pointA = b2Mul(xfA, pc->localPoint);
-				b2Vec2 pointB = b2Mul(xfB, pc->localPoints[0]);
-				normal = pointB - pointA;
-				normal.Normalize();
-				point = 0.5f * (pointA + pointB);
-				separation = b2Dot(pointB - pointA, normal) - pc->radiusA - pc->radiusB;
+				continue;
 			}
-			break;
 
-		case b2Manifold::e_faceA:
-			{
-				normal = b2Mul(xfA.q, pc->localNormal);
-				b2Vec2 planePoint = b2Mul(xfA, pc->localPoint);
+			// Relative velocity at contact
+			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+			float32 vn = b2Dot(dv, normal);
 
-				b2Vec2 clipPoint = b2Mul(xfB, pc->localPoints[index]);
-				separation = b2Dot(clipPoint - planePoint, normal) - pc->radiusA - pc->radiusB;
-				point = clipPoint;
-			}
-			break;
+			// Push the normal velocity up to the bounce velocity.
+			float32 lambda = -vcp->normalMass * (vn + vc->restitution * vcp->relativeVelocity);
 
-		case b2Manifold::e_faceB:
-			{
-				normal = b2Mul(xfB.q, pc->localNormal);
-				b2Vec2 planePoint = b2Mul(xfB, pc->localPoint);
+			// Clamp the accumulated impulse
+			float32 newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - vcp->normalImpulse;
+			vcp->normalImpulse = newImpulse;
 
-				b2Vec2 clipPoint = b2Mul(xfA, pc->localPoints[index]);
-				separation = b2Dot(clipPoint - planePoint, normal) - pc->radiusA - pc->radiusB;
-				point = clipPoint;
+			// Apply contact impulse
+			b2Vec2 P = lambda * normal;
+			vA -= mA * P;
+			wA -= iA * b2Cross(vcp->rA, P);
 
-				// Ensure normal points from A to B
-				normal = -normal;
-			}
-			break;
+			vB += mB * P;
+			wB += iB * b2Cross(vcp->rB, P);
 		}
+
+		m_velocities[indexA].v = vA;
+		m_velocities[indexA].w = wA;
+		m_velocities[indexB].v = vB;
+		m_velocities[indexB].w = wB;
 	}
+}
 
-	b2Vec2 normal;
-	b2Vec2 point;
-	float32 separation;
-};
+void b2ContactSolver::StoreImpulses()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		b2Manifold* manifold = m_contacts[vc->contactIndex]->GetManifold();
+
+		for (int32 j = 0; j < vc->pointCount; ++j)
+		{
+			manifold->points[j].normalImpulse = vc->points[j].normalImpulse;
+			manifold->points[j].tangentImpulse = vc->points[j].tangentImpulse;
+		}
+	}
+}
 
 // Sequential solver.
 bool b2ContactSolver::SolvePositionConstraints()
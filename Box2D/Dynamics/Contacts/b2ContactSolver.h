@@ -37,6 +37,7 @@ struct b2VelocityConstraintPoint
 	float32 normalMass;
 	float32 tangentMass;
 	float32 velocityBias;
+	float32 relativeVelocity;
 };
 
 struct b2ContactVelocityConstraint
@@ -74,7 +75,21 @@ public:
 	void InitializeVelocityConstraints();
 
 	void WarmStart();
-	void SolveVelocityConstraints();
+
+	/// Run one velocity iteration. Returns the largest change in relative velocity
+	/// along its normal and tangent that a single contact applied, which shows how
+	/// far the solver is from converging.
+	float32 SolveVelocityConstraints();
+
+	/// Solve the contacts as soft constraints over a sub-step of length h. This
+	/// uses the current positions to find the separations. Without the bias
+	/// the contacts are rigid, which relaxes the velocities.
+	void SolveSoftVelocityConstraints(float32 h, bool useBias);
+
+	/// Bounce the points that were hit during the step. Only used with
+	/// speculative contacts and the soft step solver.
+	void ApplyRestitution();
+
 	void StoreImpulses();
 
 	bool SolvePositionConstraints();
@@ -17,19 +17,19 @@
 */
 
 #include <Box2D/Dynamics/Contacts/b2EdgeAndCircleContact.h>
-#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Allocator.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 
 #include <new>
 using namespace std;
 
-b2Contact* b2EdgeAndCircleContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2BlockAllocator* allocator)
+b2Contact* b2EdgeAndCircleContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2Allocator* allocator)
 {
 	void* mem = allocator->Allocate(sizeof(b2EdgeAndCircleContact));
 	return new (mem) b2EdgeAndCircleContact(fixtureA, fixtureB);
 }
 
-void b2EdgeAndCircleContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+void b2EdgeAndCircleContact::Destroy(b2Contact* contact, b2Allocator* allocator)
 {
 	((b2EdgeAndCircleContact*)contact)->~b2EdgeAndCircleContact();
 	allocator->Free(contact, sizeof(b2EdgeAndCircleContact));
@@ -46,5 +46,6 @@ void b2EdgeAndCircleContact::Evaluate(b2Manifold* manifold, const b2Transform& x
 {
 	b2CollideEdgeAndCircle(	manifold,
 								(b2EdgeShape*)m_fixtureA->GetShape(), xfA,
-								(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+								(b2CircleShape*)m_fixtureB->GetShape(), xfB,
+								m_speculativeDistance);
 }
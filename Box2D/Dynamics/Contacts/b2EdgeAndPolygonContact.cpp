@@ -17,19 +17,19 @@
 */
 
 #include <Box2D/Dynamics/Contacts/b2EdgeAndPolygonContact.h>
-#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Allocator.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 
 #include <new>
 using namespace std;
 
-b2Contact* b2EdgeAndPolygonContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2BlockAllocator* allocator)
+b2Contact* b2EdgeAndPolygonContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2Allocator* allocator)
 {
 	void* mem = allocator->Allocate(sizeof(b2EdgeAndPolygonContact));
 	return new (mem) b2EdgeAndPolygonContact(fixtureA, fixtureB);
 }
 
-void b2EdgeAndPolygonContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+void b2EdgeAndPolygonContact::Destroy(b2Contact* contact, b2Allocator* allocator)
 {
 	((b2EdgeAndPolygonContact*)contact)->~b2EdgeAndPolygonContact();
 	allocator->Free(contact, sizeof(b2EdgeAndPolygonContact));
@@ -46,5 +46,6 @@ void b2EdgeAndPolygonContact::Evaluate(b2Manifold* manifold, const b2Transform&
 {
 	b2CollideEdgeAndPolygon(	manifold,
 								(b2EdgeShape*)m_fixtureA->GetShape(), xfA,
-								(b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+								(b2PolygonShape*)m_fixtureB->GetShape(), xfB,
+								m_speculativeDistance);
 }
@@ -17,19 +17,19 @@
 */
 
 #include <Box2D/Dynamics/Contacts/b2PolygonAndCircleContact.h>
-#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Allocator.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 
 #include <new>
 using namespace std;
 
-b2Contact* b2PolygonAndCircleContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2BlockAllocator* allocator)
+b2Contact* b2PolygonAndCircleContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2Allocator* allocator)
 {
 	void* mem = allocator->Allocate(sizeof(b2PolygonAndCircleContact));
 	return new (mem) b2PolygonAndCircleContact(fixtureA, fixtureB);
 }
 
-void b2PolygonAndCircleContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+void b2PolygonAndCircleContact::Destroy(b2Contact* contact, b2Allocator* allocator)
 {
 	((b2PolygonAndCircleContact*)contact)->~b2PolygonAndCircleContact();
 	allocator->Free(contact, sizeof(b2PolygonAndCircleContact));
@@ -46,5 +46,6 @@ void b2PolygonAndCircleContact::Evaluate(b2Manifold* manifold, const b2Transform
 {
 	b2CollidePolygonAndCircle(	manifold,
 								(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
-								(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+								(b2CircleShape*)m_fixtureB->GetShape(), xfB,
+								m_speculativeDistance);
 }
@@ -17,7 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Contacts/b2PolygonContact.h>
-#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Allocator.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
@@ -26,13 +26,13 @@
 #include <new>
 using namespace std;
 
-b2Contact* b2PolygonContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2BlockAllocator* allocator)
+b2Contact* b2PolygonContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2Allocator* allocator)
 {
 	void* mem = allocator->Allocate(sizeof(b2PolygonContact));
 	return new (mem) b2PolygonContact(fixtureA, fixtureB);
 }
 
-void b2PolygonContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+void b2PolygonContact::Destroy(b2Contact* contact, b2Allocator* allocator)
 {
 	((b2PolygonContact*)contact)->~b2PolygonContact();
 	allocator->Free(contact, sizeof(b2PolygonContact));
@@ -49,5 +49,6 @@ void b2PolygonContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, co
 {
 	b2CollidePolygons(	manifold,
 						(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
-						(b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+						(b2PolygonShape*)m_fixtureB->GetShape(), xfB,
+						m_speculativeDistance);
 }
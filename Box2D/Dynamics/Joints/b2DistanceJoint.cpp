@@ -63,12 +63,12 @@ void b2DistanceJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	m_indexA = m_bodyA->m_islandIndex;
 	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_localCenterA = m_bodyA->Sweep().localCenter;
+	m_localCenterB = m_bodyB->Sweep().localCenter;
+	m_invMassA = m_bodyA->InvMass();
+	m_invMassB = m_bodyB->InvMass();
+	m_invIA = m_bodyA->InvI();
+	m_invIB = m_bodyB->InvI();
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -104,6 +104,8 @@ public:
 protected:
 
 	friend class b2Joint;
+	friend class b2JointBatchSolver;
+	friend class b2JointTreeSolver;
 	b2DistanceJoint(const b2DistanceJointDef* data);
 
 	void InitVelocityConstraints(const b2SolverData& data);
@@ -25,6 +25,7 @@ class b2Body;
 class b2Joint;
 struct b2SolverData;
 class b2BlockAllocator;
+struct b2PersistentIsland;
 
 enum b2JointType
 {
@@ -150,6 +151,9 @@ protected:
 	friend class b2Body;
 	friend class b2Island;
 	friend class b2GearJoint;
+	friend class b2IslandManager;
+	friend class b2JointBatchSolver;
+	friend class b2JointTreeSolver;
 
 	static b2Joint* Create(const b2JointDef* def, b2BlockAllocator* allocator);
 	static void Destroy(b2Joint* joint, b2BlockAllocator* allocator);
@@ -173,7 +177,11 @@ protected:
 
 	int32 m_index;
 
-	bool m_islandFlag;
+	// Joints between active bodies are linked into the island of their bodies.
+	b2PersistentIsland* m_island;
+	b2Joint* m_islandPrev;
+	b2Joint* m_islandNext;
+
 	bool m_collideConnected;
 
 	void* m_userData;
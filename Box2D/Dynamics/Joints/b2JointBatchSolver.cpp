@@ -0,0 +1,736 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/Joints/b2JointBatchSolver.h>
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/Joints/b2RopeJoint.h>
+#include <Box2D/Dynamics/Joints/b2WeldJoint.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+#include <cstring>
+
+#ifdef B2_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+// The kernels do the same arithmetic as the SolveVelocityConstraints of the
+// joints, lane by lane, so a batched joint gets the same impulse as it would
+// alone. Only the order of the joints within an iteration changes.
+
+const int32 b2_batchWidth = 4;
+
+// A joint is only added to one of the newest batches of its type. This keeps
+// the grouping linear when many joints share a body.
+const int32 b2_batchSearch = 8;
+
+enum b2JointBatchType
+{
+	e_revoluteBatch,
+	e_distanceBatch,
+	e_ropeBatch,
+	e_weldBatch,
+	e_softWeldBatch,
+	e_batchTypeCount
+};
+
+struct b2JointBatch
+{
+	int32 type;
+	int32 count;
+	b2Joint* joints[b2_batchWidth];
+	int32 indexA[b2_batchWidth];
+	int32 indexB[b2_batchWidth];
+	float32 mA[b2_batchWidth], mB[b2_batchWidth];
+	float32 iA[b2_batchWidth], iB[b2_batchWidth];
+	float32 rAx[b2_batchWidth], rAy[b2_batchWidth];
+	float32 rBx[b2_batchWidth], rBy[b2_batchWidth];
+	float32 k[9][b2_batchWidth];		// constants of the joint type
+	float32 impulse[3][b2_batchWidth];
+};
+
+#ifdef B2_SIMD_SSE2
+
+typedef __m128 b2FloatW;
+
+static inline b2FloatW b2LoadW(const float32* a) { return _mm_loadu_ps(a); }
+static inline void b2StoreW(float32* a, b2FloatW b) { _mm_storeu_ps(a, b); }
+static inline b2FloatW b2SplatW(float32 a) { return _mm_set1_ps(a); }
+static inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+static inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+static inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+static inline b2FloatW b2NegW(b2FloatW a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+
+// These match b2Min and b2Max, including which operand is returned for NaN.
+static inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+static inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+
+// Lanes where a is negative take b, the others take c.
+static inline b2FloatW b2SelectNegativeW(b2FloatW a, b2FloatW b, b2FloatW c)
+{
+	__m128 mask = _mm_cmplt_ps(a, _mm_setzero_ps());
+	return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, c));
+}
+
+#else
+
+struct b2FloatW
+{
+	float32 x[b2_batchWidth];
+};
+
+static inline b2FloatW b2LoadW(const float32* a)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < b2_batchWidth; ++i) r.x[i] = a[i];
+	return r;
+}
+
+static inline void b2StoreW(float32* a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_batchWidth; ++i) a[i] = b.x[i];
+}
+
+static inline b2FloatW b2SplatW(float32 a)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < b2_batchWidth; ++i) r.x[i] = a;
+	return r;
+}
+
+static inline b2FloatW b2AddW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_batchWidth; ++i) a.x[i] += b.x[i];
+	return a;
+}
+
+static inline b2FloatW b2SubW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_batchWidth; ++i) a.x[i] -= b.x[i];
+	return a;
+}
+
+static inline b2FloatW b2MulW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_batchWidth; ++i) a.x[i] *= b.x[i];
+	return a;
+}
+
+static inline b2FloatW b2NegW(b2FloatW a)
+{
+	for (int32 i = 0; i < b2_batchWidth; ++i) a.x[i] = -a.x[i];
+	return a;
+}
+
+static inline b2FloatW b2MinW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_batchWidth; ++i) a.x[i] = b2Min(a.x[i], b.x[i]);
+	return a;
+}
+
+static inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_batchWidth; ++i) a.x[i] = b2Max(a.x[i], b.x[i]);
+	return a;
+}
+
+static inline b2FloatW b2SelectNegativeW(b2FloatW a, b2FloatW b, b2FloatW c)
+{
+	for (int32 i = 0; i < b2_batchWidth; ++i) c.x[i] = a.x[i] < 0.0f ? b.x[i] : c.x[i];
+	return c;
+}
+
+#endif
+
+// The velocities of one side of a batch.
+struct b2BodyW
+{
+	b2FloatW vx, vy, w;
+};
+
+// v + cross(w, r)
+static inline void b2PointVelocityW(const b2BodyW& b, b2FloatW rx, b2FloatW ry, b2FloatW* px, b2FloatW* py)
+{
+	*px = b2AddW(b.vx, b2MulW(b2NegW(b.w), ry));
+	*py = b2AddW(b.vy, b2MulW(b.w, rx));
+}
+
+// Apply the impulse P to body B and -P to body A, with the angular impulse
+// cross(r, P) + z.
+static inline void b2ApplyImpulseW(const b2JointBatch* batch, b2BodyW* A, b2BodyW* B,
+								   b2FloatW Px, b2FloatW Py, const b2FloatW* z)
+{
+	b2FloatW rAx = b2LoadW(batch->rAx), rAy = b2LoadW(batch->rAy);
+	b2FloatW rBx = b2LoadW(batch->rBx), rBy = b2LoadW(batch->rBy);
+	b2FloatW mA = b2LoadW(batch->mA), mB = b2LoadW(batch->mB);
+	b2FloatW iA = b2LoadW(batch->iA), iB = b2LoadW(batch->iB);
+
+	b2FloatW LA = b2SubW(b2MulW(rAx, Py), b2MulW(rAy, Px));
+	b2FloatW LB = b2SubW(b2MulW(rBx, Py), b2MulW(rBy, Px));
+	if (z)
+	{
+		LA = b2AddW(LA, *z);
+		LB = b2AddW(LB, *z);
+	}
+
+	A->vx = b2SubW(A->vx, b2MulW(mA, Px));
+	A->vy = b2SubW(A->vy, b2MulW(mA, Py));
+	A->w = b2SubW(A->w, b2MulW(iA, LA));
+
+	B->vx = b2AddW(B->vx, b2MulW(mB, Px));
+	B->vy = b2AddW(B->vy, b2MulW(mB, Py));
+	B->w = b2AddW(B->w, b2MulW(iB, LB));
+}
+
+// Cdot = vB + cross(wB, rB) - vA - cross(wA, rA)
+static inline void b2RelativeVelocityW(const b2JointBatch* batch, const b2BodyW& A, const b2BodyW& B,
+									   b2FloatW* Cx, b2FloatW* Cy)
+{
+	b2FloatW rAx = b2LoadW(batch->rAx), rAy = b2LoadW(batch->rAy);
+	b2FloatW rBx = b2LoadW(batch->rBx), rBy = b2LoadW(batch->rBy);
+
+	*Cx = b2SubW(b2SubW(b2AddW(B.vx, b2MulW(b2NegW(B.w), rBy)), A.vx), b2MulW(b2NegW(A.w), rAy));
+	*Cy = b2SubW(b2SubW(b2AddW(B.vy, b2MulW(B.w, rBx)), A.vy), b2MulW(A.w, rAx));
+}
+
+// See b2RevoluteJoint::SolveVelocityConstraints. The motor of a lane is off
+// when its maximum impulse is zero.
+static void b2SolveRevoluteBatch(b2JointBatch* batch, b2BodyW* A, b2BodyW* B)
+{
+	// Solve motor constraint.
+	{
+		b2FloatW motorMass = b2LoadW(batch->k[5]);
+		b2FloatW motorSpeed = b2LoadW(batch->k[6]);
+		b2FloatW maxImpulse = b2LoadW(batch->k[7]);
+
+		b2FloatW Cdot = b2SubW(b2SubW(B->w, A->w), motorSpeed);
+		b2FloatW impulse = b2MulW(b2NegW(motorMass), Cdot);
+		b2FloatW oldImpulse = b2LoadW(batch->impulse[2]);
+		b2FloatW newImpulse = b2MaxW(b2NegW(maxImpulse), b2MinW(b2AddW(oldImpulse, impulse), maxImpulse));
+		b2StoreW(batch->impulse[2], newImpulse);
+		impulse = b2SubW(newImpulse, oldImpulse);
+
+		A->w = b2SubW(A->w, b2MulW(b2LoadW(batch->iA), impulse));
+		B->w = b2AddW(B->w, b2MulW(b2LoadW(batch->iB), impulse));
+	}
+
+	// Solve point-to-point constraint
+	b2FloatW Cx, Cy;
+	b2RelativeVelocityW(batch, *A, *B, &Cx, &Cy);
+
+	// b2Mat33::Solve22 with the determinant inverted up front.
+	b2FloatW det = b2LoadW(batch->k[0]);
+	b2FloatW a11 = b2LoadW(batch->k[1]), a12 = b2LoadW(batch->k[2]);
+	b2FloatW a21 = b2LoadW(batch->k[3]), a22 = b2LoadW(batch->k[4]);
+	b2FloatW bx = b2NegW(Cx), by = b2NegW(Cy);
+	b2FloatW Px = b2MulW(det, b2SubW(b2MulW(a22, bx), b2MulW(a12, by)));
+	b2FloatW Py = b2MulW(det, b2SubW(b2MulW(a11, by), b2MulW(a21, bx)));
+
+	b2StoreW(batch->impulse[0], b2AddW(b2LoadW(batch->impulse[0]), Px));
+	b2StoreW(batch->impulse[1], b2AddW(b2LoadW(batch->impulse[1]), Py));
+
+	b2ApplyImpulseW(batch, A, B, Px, Py, NULL);
+}
+
+// See b2DistanceJoint::SolveVelocityConstraints.
+static void b2SolveDistanceBatch(b2JointBatch* batch, b2BodyW* A, b2BodyW* B)
+{
+	b2FloatW ux = b2LoadW(batch->k[0]), uy = b2LoadW(batch->k[1]);
+	b2FloatW mass = b2LoadW(batch->k[2]);
+	b2FloatW bias = b2LoadW(batch->k[3]);
+	b2FloatW gamma = b2LoadW(batch->k[4]);
+
+	b2FloatW vpAx, vpAy, vpBx, vpBy;
+	b2PointVelocityW(*A, b2LoadW(batch->rAx), b2LoadW(batch->rAy), &vpAx, &vpAy);
+	b2PointVelocityW(*B, b2LoadW(batch->rBx), b2LoadW(batch->rBy), &vpBx, &vpBy);
+	b2FloatW Cdot = b2AddW(b2MulW(ux, b2SubW(vpBx, vpAx)), b2MulW(uy, b2SubW(vpBy, vpAy)));
+
+	b2FloatW oldImpulse = b2LoadW(batch->impulse[0]);
+	b2FloatW impulse = b2MulW(b2NegW(mass), b2AddW(b2AddW(Cdot, bias), b2MulW(gamma, oldImpulse)));
+	b2StoreW(batch->impulse[0], b2AddW(oldImpulse, impulse));
+
+	b2ApplyImpulseW(batch, A, B, b2MulW(impulse, ux), b2MulW(impulse, uy), NULL);
+}
+
+// See b2RopeJoint::SolveVelocityConstraints.
+static void b2SolveRopeBatch(b2JointBatch* batch, b2BodyW* A, b2BodyW* B, float32 inv_dt)
+{
+	b2FloatW ux = b2LoadW(batch->k[0]), uy = b2LoadW(batch->k[1]);
+	b2FloatW mass = b2LoadW(batch->k[2]);
+	b2FloatW C = b2LoadW(batch->k[3]);
+
+	b2FloatW vpAx, vpAy, vpBx, vpBy;
+	b2PointVelocityW(*A, b2LoadW(batch->rAx), b2LoadW(batch->rAy), &vpAx, &vpAy);
+	b2PointVelocityW(*B, b2LoadW(batch->rBx), b2LoadW(batch->rBy), &vpBx, &vpBy);
+	b2FloatW Cdot = b2AddW(b2MulW(ux, b2SubW(vpBx, vpAx)), b2MulW(uy, b2SubW(vpBy, vpAy)));
+
+	// Predictive constraint.
+	Cdot = b2SelectNegativeW(C, b2AddW(Cdot, b2MulW(b2SplatW(inv_dt), C)), Cdot);
+
+	b2FloatW impulse = b2MulW(b2NegW(mass), Cdot);
+	b2FloatW oldImpulse = b2LoadW(batch->impulse[0]);
+	b2FloatW newImpulse = b2MinW(b2SplatW(0.0f), b2AddW(oldImpulse, impulse));
+	b2StoreW(batch->impulse[0], newImpulse);
+	impulse = b2SubW(newImpulse, oldImpulse);
+
+	b2ApplyImpulseW(batch, A, B, b2MulW(impulse, ux), b2MulW(impulse, uy), NULL);
+}
+
+// See b2WeldJoint::SolveVelocityConstraints without a spring.
+static void b2SolveWeldBatch(b2JointBatch* batch, b2BodyW* A, b2BodyW* B)
+{
+	b2FloatW Cx, Cy;
+	b2RelativeVelocityW(batch, *A, *B, &Cx, &Cy);
+	b2FloatW Cz = b2SubW(B->w, A->w);
+
+	// impulse = -(Cdot.x * ex + Cdot.y * ey + Cdot.z * ez)
+	b2FloatW Px = b2NegW(b2AddW(b2AddW(b2MulW(Cx, b2LoadW(batch->k[0])), b2MulW(Cy, b2LoadW(batch->k[3]))),
+		b2MulW(Cz, b2LoadW(batch->k[6]))));
+	b2FloatW Py = b2NegW(b2AddW(b2AddW(b2MulW(Cx, b2LoadW(batch->k[1])), b2MulW(Cy, b2LoadW(batch->k[4]))),
+		b2MulW(Cz, b2LoadW(batch->k[7]))));
+	b2FloatW Pz = b2NegW(b2AddW(b2AddW(b2MulW(Cx, b2LoadW(batch->k[2])), b2MulW(Cy, b2LoadW(batch->k[5]))),
+		b2MulW(Cz, b2LoadW(batch->k[8]))));
+
+	b2StoreW(batch->impulse[0], b2AddW(b2LoadW(batch->impulse[0]), Px));
+	b2StoreW(batch->impulse[1], b2AddW(b2LoadW(batch->impulse[1]), Py));
+	b2StoreW(batch->impulse[2], b2AddW(b2LoadW(batch->impulse[2]), Pz));
+
+	b2ApplyImpulseW(batch, A, B, Px, Py, &Pz);
+}
+
+// See b2WeldJoint::SolveVelocityConstraints with a spring.
+static void b2SolveSoftWeldBatch(b2JointBatch* batch, b2BodyW* A, b2BodyW* B)
+{
+	b2FloatW Cdot2 = b2SubW(B->w, A->w);
+
+	b2FloatW angularMass = b2LoadW(batch->k[4]);
+	b2FloatW bias = b2LoadW(batch->k[5]);
+	b2FloatW gamma = b2LoadW(batch->k[6]);
+	b2FloatW oldImpulse = b2LoadW(batch->impulse[2]);
+	b2FloatW impulse2 = b2MulW(b2NegW(angularMass), b2AddW(b2AddW(Cdot2, bias), b2MulW(gamma, oldImpulse)));
+	b2StoreW(batch->impulse[2], b2AddW(oldImpulse, impulse2));
+
+	A->w = b2SubW(A->w, b2MulW(b2LoadW(batch->iA), impulse2));
+	B->w = b2AddW(B->w, b2MulW(b2LoadW(batch->iB), impulse2));
+
+	b2FloatW Cx, Cy;
+	b2RelativeVelocityW(batch, *A, *B, &Cx, &Cy);
+
+	// impulse1 = -b2Mul22(m_mass, Cdot1)
+	b2FloatW Px = b2NegW(b2AddW(b2MulW(b2LoadW(batch->k[0]), Cx), b2MulW(b2LoadW(batch->k[2]), Cy)));
+	b2FloatW Py = b2NegW(b2AddW(b2MulW(b2LoadW(batch->k[1]), Cx), b2MulW(b2LoadW(batch->k[3]), Cy)));
+
+	b2StoreW(batch->impulse[0], b2AddW(b2LoadW(batch->impulse[0]), Px));
+	b2StoreW(batch->impulse[1], b2AddW(b2LoadW(batch->impulse[1]), Py));
+
+	b2ApplyImpulseW(batch, A, B, Px, Py, NULL);
+}
+
+// Returns the batch type of a joint, or -1 if it is solved on its own.
+static int32 b2GetBatchType(b2Joint* joint)
+{
+	switch (joint->GetType())
+	{
+	case e_revoluteJoint:
+		return ((b2RevoluteJoint*)joint)->IsLimitEnabled() ? -1 : e_revoluteBatch;
+
+	case e_distanceJoint:
+		return e_distanceBatch;
+
+	case e_ropeJoint:
+		return e_ropeBatch;
+
+	case e_weldJoint:
+		return ((b2WeldJoint*)joint)->GetFrequency() > 0.0f ? e_softWeldBatch : e_weldBatch;
+
+	default:
+		return -1;
+	}
+}
+
+// Dynamic bodies may only appear once in a batch. Other bodies are not
+// changed by the joints, so they may be shared.
+static bool b2CanBatch(const b2JointBatch* batch, b2Joint* joint)
+{
+	b2Body* bodyA = joint->GetBodyA();
+	b2Body* bodyB = joint->GetBodyB();
+	bool dynamicA = bodyA->GetType() == b2_dynamicBody;
+	bool dynamicB = bodyB->GetType() == b2_dynamicBody;
+
+	for (int32 i = 0; i < batch->count; ++i)
+	{
+		b2Body* otherA = batch->joints[i]->GetBodyA();
+		b2Body* otherB = batch->joints[i]->GetBodyB();
+		if (dynamicA && (bodyA == otherA || bodyA == otherB))
+		{
+			return false;
+		}
+
+		if (dynamicB && (bodyB == otherA || bodyB == otherB))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+b2JointBatchSolver::b2JointBatchSolver(b2StackAllocator* allocator)
+{
+	m_allocator = allocator;
+	m_batches = NULL;
+	m_batchCount = 0;
+	m_joints = NULL;
+	m_jointCount = 0;
+}
+
+b2JointBatchSolver::~b2JointBatchSolver()
+{
+	if (m_joints)
+	{
+		m_allocator->Free(m_joints);
+	}
+
+	if (m_batches)
+	{
+		m_allocator->Free(m_batches);
+	}
+}
+
+void b2JointBatchSolver::Initialize(b2Joint** joints, int32 jointCount)
+{
+	b2Assert(m_batches == NULL);
+
+	if (jointCount == 0)
+	{
+		return;
+	}
+
+	m_batches = (b2JointBatch*)m_allocator->Allocate(jointCount * sizeof(b2JointBatch));
+	m_joints = (b2Joint**)m_allocator->Allocate(jointCount * sizeof(b2Joint*));
+	b2Assert(((size_t)m_batches & (sizeof(b2Joint*) - 1)) == 0);
+	b2Assert(((size_t)m_joints & (sizeof(b2Joint*) - 1)) == 0);
+	m_batchCount = 0;
+	m_jointCount = 0;
+
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		if (b2GetBatchType(joints[i]) == -1)
+		{
+			m_joints[m_jointCount++] = joints[i];
+		}
+	}
+
+	for (int32 type = 0; type < e_batchTypeCount; ++type)
+	{
+		int32 firstBatch = m_batchCount;
+		for (int32 i = 0; i < jointCount; ++i)
+		{
+			b2Joint* joint = joints[i];
+			if (b2GetBatchType(joint) != type)
+			{
+				continue;
+			}
+
+			b2JointBatch* batch = NULL;
+			int32 lastSearch = b2Max(firstBatch, m_batchCount - b2_batchSearch);
+			for (int32 j = m_batchCount - 1; j >= lastSearch; --j)
+			{
+				if (m_batches[j].count < b2_batchWidth && b2CanBatch(m_batches + j, joint))
+				{
+					batch = m_batches + j;
+					break;
+				}
+			}
+
+			if (batch == NULL)
+			{
+				batch = m_batches + m_batchCount++;
+				memset(batch, 0, sizeof(b2JointBatch));
+				batch->type = type;
+			}
+
+			batch->joints[batch->count++] = joint;
+		}
+	}
+}
+
+void b2JointBatchSolver::InitializeVelocityConstraints(const b2SolverData& data)
+{
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2JointBatch* batch = m_batches + i;
+		for (int32 j = 0; j < batch->count; ++j)
+		{
+			switch (batch->type)
+			{
+			case e_revoluteBatch:
+				{
+					b2RevoluteJoint* joint = (b2RevoluteJoint*)batch->joints[j];
+					batch->indexA[j] = joint->m_indexA;
+					batch->indexB[j] = joint->m_indexB;
+					batch->mA[j] = joint->m_invMassA;
+					batch->mB[j] = joint->m_invMassB;
+					batch->iA[j] = joint->m_invIA;
+					batch->iB[j] = joint->m_invIB;
+					batch->rAx[j] = joint->m_rA.x;
+					batch->rAy[j] = joint->m_rA.y;
+					batch->rBx[j] = joint->m_rB.x;
+					batch->rBy[j] = joint->m_rB.y;
+
+					const b2Mat33& K = joint->m_mass;
+					float32 det = K.ex.x * K.ey.y - K.ey.x * K.ex.y;
+					if (det != 0.0f)
+					{
+						det = 1.0f / det;
+					}
+					batch->k[0][j] = det;
+					batch->k[1][j] = K.ex.x;
+					batch->k[2][j] = K.ey.x;
+					batch->k[3][j] = K.ex.y;
+					batch->k[4][j] = K.ey.y;
+
+					bool fixedRotation = (joint->m_invIA + joint->m_invIB == 0.0f);
+					bool motor = joint->m_enableMotor && fixedRotation == false;
+					batch->k[5][j] = motor ? joint->m_motorMass : 0.0f;
+					batch->k[6][j] = joint->m_motorSpeed;
+					batch->k[7][j] = motor ? data.step.dt * joint->m_maxMotorTorque : 0.0f;
+
+					batch->impulse[0][j] = joint->m_impulse.x;
+					batch->impulse[1][j] = joint->m_impulse.y;
+					batch->impulse[2][j] = joint->m_motorImpulse;
+				}
+				break;
+
+			case e_distanceBatch:
+				{
+					b2DistanceJoint* joint = (b2DistanceJoint*)batch->joints[j];
+					batch->indexA[j] = joint->m_indexA;
+					batch->indexB[j] = joint->m_indexB;
+					batch->mA[j] = joint->m_invMassA;
+					batch->mB[j] = joint->m_invMassB;
+					batch->iA[j] = joint->m_invIA;
+					batch->iB[j] = joint->m_invIB;
+					batch->rAx[j] = joint->m_rA.x;
+					batch->rAy[j] = joint->m_rA.y;
+					batch->rBx[j] = joint->m_rB.x;
+					batch->rBy[j] = joint->m_rB.y;
+
+					batch->k[0][j] = joint->m_u.x;
+					batch->k[1][j] = joint->m_u.y;
+					batch->k[2][j] = joint->m_mass;
+					batch->k[3][j] = joint->m_bias;
+					batch->k[4][j] = joint->m_gamma;
+
+					batch->impulse[0][j] = joint->m_impulse;
+				}
+				break;
+
+			case e_ropeBatch:
+				{
+					b2RopeJoint* joint = (b2RopeJoint*)batch->joints[j];
+					batch->indexA[j] = joint->m_indexA;
+					batch->indexB[j] = joint->m_indexB;
+					batch->mA[j] = joint->m_invMassA;
+					batch->mB[j] = joint->m_invMassB;
+					batch->iA[j] = joint->m_invIA;
+					batch->iB[j] = joint->m_invIB;
+					batch->rAx[j] = joint->m_rA.x;
+					batch->rAy[j] = joint->m_rA.y;
+					batch->rBx[j] = joint->m_rB.x;
+					batch->rBy[j] = joint->m_rB.y;
+
+					batch->k[0][j] = joint->m_u.x;
+					batch->k[1][j] = joint->m_u.y;
+					batch->k[2][j] = joint->m_mass;
+					batch->k[3][j] = joint->m_length - joint->m_maxLength;
+
+					batch->impulse[0][j] = joint->m_impulse;
+				}
+				break;
+
+			case e_weldBatch:
+			case e_softWeldBatch:
+				{
+					b2WeldJoint* joint = (b2WeldJoint*)batch->joints[j];
+					batch->indexA[j] = joint->m_indexA;
+					batch->indexB[j] = joint->m_indexB;
+					batch->mA[j] = joint->m_invMassA;
+					batch->mB[j] = joint->m_invMassB;
+					batch->iA[j] = joint->m_invIA;
+					batch->iB[j] = joint->m_invIB;
+					batch->rAx[j] = joint->m_rA.x;
+					batch->rAy[j] = joint->m_rA.y;
+					batch->rBx[j] = joint->m_rB.x;
+					batch->rBy[j] = joint->m_rB.y;
+
+					const b2Mat33& M = joint->m_mass;
+					if (batch->type == e_weldBatch)
+					{
+						batch->k[0][j] = M.ex.x;
+						batch->k[1][j] = M.ex.y;
+						batch->k[2][j] = M.ex.z;
+						batch->k[3][j] = M.ey.x;
+						batch->k[4][j] = M.ey.y;
+						batch->k[5][j] = M.ey.z;
+						batch->k[6][j] = M.ez.x;
+						batch->k[7][j] = M.ez.y;
+						batch->k[8][j] = M.ez.z;
+					}
+					else
+					{
+						batch->k[0][j] = M.ex.x;
+						batch->k[1][j] = M.ex.y;
+						batch->k[2][j] = M.ey.x;
+						batch->k[3][j] = M.ey.y;
+						batch->k[4][j] = M.ez.z;
+						batch->k[5][j] = joint->m_bias;
+						batch->k[6][j] = joint->m_gamma;
+					}
+
+					batch->impulse[0][j] = joint->m_impulse.x;
+					batch->impulse[1][j] = joint->m_impulse.y;
+					batch->impulse[2][j] = joint->m_impulse.z;
+				}
+				break;
+			}
+		}
+	}
+}
+
+void b2JointBatchSolver::SolveVelocityConstraints(const b2SolverData& data)
+{
+	b2Velocity* velocities = data.velocities;
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2JointBatch* batch = m_batches + i;
+
+		// Gather the velocities. Unused lanes stay at rest.
+		float32 vA[3][b2_batchWidth] = {{0.0f}};
+		float32 vB[3][b2_batchWidth] = {{0.0f}};
+		for (int32 j = 0; j < batch->count; ++j)
+		{
+			const b2Velocity& a = velocities[batch->indexA[j]];
+			const b2Velocity& b = velocities[batch->indexB[j]];
+			vA[0][j] = a.v.x;
+			vA[1][j] = a.v.y;
+			vA[2][j] = a.w;
+			vB[0][j] = b.v.x;
+			vB[1][j] = b.v.y;
+			vB[2][j] = b.w;
+		}
+
+		b2BodyW A, B;
+		A.vx = b2LoadW(vA[0]);
+		A.vy = b2LoadW(vA[1]);
+		A.w = b2LoadW(vA[2]);
+		B.vx = b2LoadW(vB[0]);
+		B.vy = b2LoadW(vB[1]);
+		B.w = b2LoadW(vB[2]);
+
+		switch (batch->type)
+		{
+		case e_revoluteBatch:
+			b2SolveRevoluteBatch(batch, &A, &B);
+			break;
+
+		case e_distanceBatch:
+			b2SolveDistanceBatch(batch, &A, &B);
+			break;
+
+		case e_ropeBatch:
+			b2SolveRopeBatch(batch, &A, &B, data.step.inv_dt);
+			break;
+
+		case e_weldBatch:
+			b2SolveWeldBatch(batch, &A, &B);
+			break;
+
+		case e_softWeldBatch:
+			b2SolveSoftWeldBatch(batch, &A, &B);
+			break;
+		}
+
+		b2StoreW(vA[0], A.vx);
+		b2StoreW(vA[1], A.vy);
+		b2StoreW(vA[2], A.w);
+		b2StoreW(vB[0], B.vx);
+		b2StoreW(vB[1], B.vy);
+		b2StoreW(vB[2], B.w);
+
+		// Scatter the velocities. A body that is not dynamic may be in several
+		// lanes, but its velocity is unchanged.
+		for (int32 j = 0; j < batch->count; ++j)
+		{
+			b2Velocity& a = velocities[batch->indexA[j]];
+			b2Velocity& b = velocities[batch->indexB[j]];
+			a.v.Set(vA[0][j], vA[1][j]);
+			a.w = vA[2][j];
+			b.v.Set(vB[0][j], vB[1][j]);
+			b.w = vB[2][j];
+		}
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		m_joints[i]->SolveVelocityConstraints(data);
+	}
+}
+
+void b2JointBatchSolver::StoreImpulses()
+{
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		const b2JointBatch* batch = m_batches + i;
+		for (int32 j = 0; j < batch->count; ++j)
+		{
+			switch (batch->type)
+			{
+			case e_revoluteBatch:
+				{
+					b2RevoluteJoint* joint = (b2RevoluteJoint*)batch->joints[j];
+					joint->m_impulse.x = batch->impulse[0][j];
+					joint->m_impulse.y = batch->impulse[1][j];
+					joint->m_motorImpulse = batch->impulse[2][j];
+				}
+				break;
+
+			case e_distanceBatch:
+				((b2DistanceJoint*)batch->joints[j])->m_impulse = batch->impulse[0][j];
+				break;
+
+			case e_ropeBatch:
+				((b2RopeJoint*)batch->joints[j])->m_impulse = batch->impulse[0][j];
+				break;
+
+			case e_weldBatch:
+			case e_softWeldBatch:
+				{
+					b2WeldJoint* joint = (b2WeldJoint*)batch->joints[j];
+					joint->m_impulse.x = batch->impulse[0][j];
+					joint->m_impulse.y = batch->impulse[1][j];
+					joint->m_impulse.z = batch->impulse[2][j];
+				}
+				break;
+			}
+		}
+	}
+}
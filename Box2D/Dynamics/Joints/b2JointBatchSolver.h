@@ -0,0 +1,64 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_JOINT_BATCH_SOLVER_H
+#define B2_JOINT_BATCH_SOLVER_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+class b2Joint;
+class b2StackAllocator;
+struct b2JointBatch;
+
+/// Solves the velocity constraints of the joints of an island grouped by type.
+/// Revolute joints without a limit, distance, rope and weld joints are packed
+/// four to a batch, structure of arrays, so that no dynamic body appears twice in a
+/// batch. Each batch is then solved by one kernel, with SSE2 where available.
+/// The other joints are solved one at a time through their virtual functions.
+class b2JointBatchSolver
+{
+public:
+	b2JointBatchSolver(b2StackAllocator* allocator);
+	~b2JointBatchSolver();
+
+	/// Group the joints into batches.
+	void Initialize(b2Joint** joints, int32 jointCount);
+
+	/// Load the batches from the joints. Call this after the joints have
+	/// initialized their velocity constraints.
+	void InitializeVelocityConstraints(const b2SolverData& data);
+
+	void SolveVelocityConstraints(const b2SolverData& data);
+
+	/// Copy the impulses back to the joints for warm starting.
+	void StoreImpulses();
+
+private:
+
+	b2StackAllocator* m_allocator;
+
+	b2JointBatch* m_batches;
+	int32 m_batchCount;
+
+	b2Joint** m_joints;		// joints solved one at a time
+	int32 m_jointCount;
+};
+
+#endif
@@ -0,0 +1,769 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Joints/b2JointTreeSolver.h>
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+// The velocity constraints of the island are
+//
+// [M  J^T] [ v2] = [M * v1]
+// [J  0  ] [-P ]   [  0   ]
+//
+// where M is the mass of the bodies, J the Jacobian of the joints and P
+// the joint impulses. Bodies and joints are the nodes of this system. When
+// the joints form a tree so do the nodes, and the matrix can be factored
+// as L * D * L^T from the leaves to the roots without fill in (Baraff 1996).
+//
+// Static and kinematic bodies don't get a node, their velocity moves to
+// the right hand side. A joint to such a body would be a leaf with a zero
+// diagonal block, so it is folded into the node of its other body instead.
+// The roots are bodies and every parent comes before its children.
+//
+// The positions are left to the joints. With exact velocities the joints
+// only drift by the curvature of their paths over a step.
+
+// A body node holds the body and its joints to static and kinematic bodies.
+const int32 b2_maxTreeNodeDim = 8;
+
+struct b2JointTreeNode
+{
+	bool body;
+	int32 dim;
+	int32 parent;	// node index of the parent, -1 for a root
+	int32 item;		// island body index or tree joint index
+	float32 D[b2_maxTreeNodeDim * b2_maxTreeNodeDim];	// diagonal block, inverted by Factor
+	float32 H[2 * b2_maxTreeNodeDim];	// dim x parent dim block, replaced by D^-1 * H
+	float32 x[b2_maxTreeNodeDim];		// right hand side, then solution
+};
+
+struct b2JointTreeJoint
+{
+	b2Joint* joint;
+	int32 dim;
+	int32 indexA;
+	int32 indexB;
+	bool dynamicA;
+	bool dynamicB;
+	int32 node;		// the joint node, or the body node it is folded into
+	int32 offset;	// first row of the joint in its node
+	b2Vec2 localAnchorA;	// relative to the body centers
+	b2Vec2 localAnchorB;
+	b2Vec2 u;
+	float32 JA[6];	// dim x 3
+	float32 JB[6];
+	float32 bias[2];
+	float32 impulse[2];
+};
+
+// Invert a small block in place with Gauss-Jordan elimination. Returns false
+// if the block is singular.
+static bool b2InvertBlock(float32* D, int32 n)
+{
+	int32 pivots[b2_maxTreeNodeDim];
+
+	float32 scale = 0.0f;
+	for (int32 k = 0; k < n * n; ++k)
+	{
+		scale = b2Max(scale, b2Abs(D[k]));
+	}
+
+	for (int32 k = 0; k < n; ++k)
+	{
+		// Partial pivoting keeps the indefinite blocks stable.
+		int32 p = k;
+		for (int32 r = k + 1; r < n; ++r)
+		{
+			if (b2Abs(D[n * r + k]) > b2Abs(D[n * p + k]))
+			{
+				p = r;
+			}
+		}
+
+		if (b2Abs(D[n * p + k]) <= b2_epsilon * scale)
+		{
+			return false;
+		}
+
+		pivots[k] = p;
+		if (p != k)
+		{
+			for (int32 c = 0; c < n; ++c)
+			{
+				b2Swap(D[n * k + c], D[n * p + c]);
+			}
+		}
+
+		float32 inv = 1.0f / D[n * k + k];
+		D[n * k + k] = 1.0f;
+		for (int32 c = 0; c < n; ++c)
+		{
+			D[n * k + c] *= inv;
+		}
+
+		for (int32 r = 0; r < n; ++r)
+		{
+			if (r == k)
+			{
+				continue;
+			}
+
+			float32 f = D[n * r + k];
+			D[n * r + k] = 0.0f;
+			for (int32 c = 0; c < n; ++c)
+			{
+				D[n * r + c] -= f * D[n * k + c];
+			}
+		}
+	}
+
+	// Undo the row swaps on the columns of the inverse.
+	for (int32 k = n - 1; k >= 0; --k)
+	{
+		int32 p = pivots[k];
+		if (p != k)
+		{
+			for (int32 r = 0; r < n; ++r)
+			{
+				b2Swap(D[n * r + k], D[n * r + p]);
+			}
+		}
+	}
+
+	return true;
+}
+
+b2JointTreeSolver::b2JointTreeSolver(b2StackAllocator* allocator)
+{
+	m_allocator = allocator;
+	m_positions = NULL;
+	m_velocities = NULL;
+	m_bodies = NULL;
+	m_nodes = NULL;
+	m_nodeCount = 0;
+	m_joints = NULL;
+	m_jointCount = 0;
+}
+
+b2JointTreeSolver::~b2JointTreeSolver()
+{
+	if (m_joints)
+	{
+		m_allocator->Free(m_joints);
+	}
+
+	if (m_nodes)
+	{
+		m_allocator->Free(m_nodes);
+	}
+}
+
+bool b2JointTreeSolver::Initialize(const b2SolverData& data, b2Body** bodies, int32 bodyCount,
+								   b2Joint** joints, int32 jointCount)
+{
+	b2Assert(m_nodes == NULL);
+
+	m_positions = data.positions;
+	m_velocities = data.velocities;
+	m_bodies = bodies;
+
+	m_nodes = (b2JointTreeNode*)m_allocator->Allocate((bodyCount + jointCount) * sizeof(b2JointTreeNode));
+	m_joints = (b2JointTreeJoint*)m_allocator->Allocate(jointCount * sizeof(b2JointTreeJoint));
+	b2Assert(((size_t)m_nodes & (sizeof(b2Joint*) - 1)) == 0);
+	b2Assert(((size_t)m_joints & (sizeof(b2Joint*) - 1)) == 0);
+	m_nodeCount = 0;
+	m_jointCount = jointCount;
+
+	// Scratch space: the set of each body for finding loops, the joints of
+	// each body and the stack of the depth first search.
+	int32* sets = (int32*)m_allocator->Allocate(bodyCount * sizeof(int32));
+	int32* jointStart = (int32*)m_allocator->Allocate((bodyCount + 1) * sizeof(int32));
+	int32* bodyJoints = (int32*)m_allocator->Allocate(2 * jointCount * sizeof(int32));
+	int32* bodyNodes = (int32*)m_allocator->Allocate(bodyCount * sizeof(int32));
+	int32* stack = (int32*)m_allocator->Allocate(2 * (bodyCount + jointCount) * sizeof(int32));
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		sets[i] = i;
+		jointStart[i] = 0;
+		bodyNodes[i] = -1;
+	}
+	jointStart[bodyCount] = 0;
+
+	bool isTree = true;
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		b2Joint* joint = joints[i];
+		b2JointTreeJoint* tj = m_joints + i;
+		tj->joint = joint;
+		tj->indexA = joint->m_bodyA->m_islandIndex;
+		tj->indexB = joint->m_bodyB->m_islandIndex;
+		tj->dynamicA = joint->m_bodyA->GetType() == b2_dynamicBody;
+		tj->dynamicB = joint->m_bodyB->GetType() == b2_dynamicBody;
+		tj->node = -1;
+		tj->offset = 0;
+
+		b2Vec2 centerA = joint->m_bodyA->Sweep().localCenter;
+		b2Vec2 centerB = joint->m_bodyB->Sweep().localCenter;
+
+		if (joint->m_type == e_revoluteJoint)
+		{
+			b2RevoluteJoint* revolute = (b2RevoluteJoint*)joint;
+			if (revolute->m_enableMotor || revolute->m_enableLimit)
+			{
+				isTree = false;
+				break;
+			}
+
+			tj->dim = 2;
+			tj->localAnchorA = revolute->m_localAnchorA - centerA;
+			tj->localAnchorB = revolute->m_localAnchorB - centerB;
+			tj->impulse[0] = revolute->m_impulse.x;
+			tj->impulse[1] = revolute->m_impulse.y;
+		}
+		else if (joint->m_type == e_distanceJoint)
+		{
+			b2DistanceJoint* distance = (b2DistanceJoint*)joint;
+			if (distance->m_frequencyHz > 0.0f || distance->m_length < b2_linearSlop)
+			{
+				isTree = false;
+				break;
+			}
+
+			tj->dim = 1;
+			tj->localAnchorA = distance->m_localAnchorA - centerA;
+			tj->localAnchorB = distance->m_localAnchorB - centerB;
+			tj->impulse[0] = distance->m_impulse;
+			tj->impulse[1] = 0.0f;
+			tj->u.Set(1.0f, 0.0f);
+		}
+		else
+		{
+			isTree = false;
+			break;
+		}
+
+		// Fixed rotation bodies have no finite inertia to put in the system.
+		if ((tj->dynamicA && joint->m_bodyA->InvI() == 0.0f) ||
+			(tj->dynamicB && joint->m_bodyB->InvI() == 0.0f) ||
+			(tj->dynamicA == false && tj->dynamicB == false))
+		{
+			isTree = false;
+			break;
+		}
+
+		if (tj->dynamicA && tj->dynamicB)
+		{
+			// Joining two bodies of the same set closes a loop.
+			int32 setA = tj->indexA;
+			while (sets[setA] != setA)
+			{
+				sets[setA] = sets[sets[setA]];
+				setA = sets[setA];
+			}
+
+			int32 setB = tj->indexB;
+			while (sets[setB] != setB)
+			{
+				sets[setB] = sets[sets[setB]];
+				setB = sets[setB];
+			}
+
+			if (setA == setB)
+			{
+				isTree = false;
+				break;
+			}
+
+			sets[setA] = setB;
+		}
+
+		if (tj->dynamicA)
+		{
+			++jointStart[tj->indexA + 1];
+		}
+
+		if (tj->dynamicB)
+		{
+			++jointStart[tj->indexB + 1];
+		}
+	}
+
+	if (isTree)
+	{
+		// Gather the joints of each body.
+		for (int32 i = 0; i < bodyCount; ++i)
+		{
+			jointStart[i + 1] += jointStart[i];
+		}
+
+		int32* fill = sets;
+		for (int32 i = 0; i < bodyCount; ++i)
+		{
+			fill[i] = jointStart[i];
+		}
+
+		for (int32 i = 0; i < jointCount; ++i)
+		{
+			b2JointTreeJoint* tj = m_joints + i;
+			if (tj->dynamicA)
+			{
+				bodyJoints[fill[tj->indexA]++] = i;
+			}
+
+			if (tj->dynamicB)
+			{
+				bodyJoints[fill[tj->indexB]++] = i;
+			}
+		}
+
+		// Number the nodes depth first so that parents come before children.
+		// The stack holds pairs of (item, parent node). Bodies are pushed as
+		// their index, joints as -(index + 1). A tree is rooted at a grounded
+		// body where possible, otherwise a subtree held only by the ground
+		// would leave its parent joint with a singular block.
+		for (int32 root = 0; root < 2 * bodyCount && isTree; ++root)
+		{
+			int32 rootBody = root < bodyCount ? root : root - bodyCount;
+			if (bodyNodes[rootBody] != -1 || jointStart[rootBody] == jointStart[rootBody + 1])
+			{
+				continue;
+			}
+
+			if (root < bodyCount)
+			{
+				bool grounded = false;
+				for (int32 j = jointStart[rootBody]; j < jointStart[rootBody + 1]; ++j)
+				{
+					const b2JointTreeJoint* tj = m_joints + bodyJoints[j];
+					grounded = grounded || tj->dynamicA == false || tj->dynamicB == false;
+				}
+
+				if (grounded == false)
+				{
+					continue;
+				}
+			}
+
+			int32 stackCount = 0;
+			stack[stackCount++] = rootBody;
+			stack[stackCount++] = -1;
+
+			while (stackCount > 0)
+			{
+				int32 parent = stack[--stackCount];
+				int32 item = stack[--stackCount];
+
+				int32 nodeIndex = m_nodeCount++;
+				b2JointTreeNode* node = m_nodes + nodeIndex;
+				node->parent = parent;
+
+				if (item >= 0)
+				{
+					node->body = true;
+					node->dim = 3;
+					node->item = item;
+					bodyNodes[item] = nodeIndex;
+
+					int32 parentJoint = parent >= 0 ? m_nodes[parent].item : -1;
+					for (int32 j = jointStart[item]; j < jointStart[item + 1]; ++j)
+					{
+						int32 jointIndex = bodyJoints[j];
+						b2JointTreeJoint* tj = m_joints + jointIndex;
+						if (tj->dynamicA == false || tj->dynamicB == false)
+						{
+							// Fold the joint into this node.
+							tj->node = nodeIndex;
+							tj->offset = node->dim;
+							node->dim += tj->dim;
+						}
+						else if (jointIndex != parentJoint)
+						{
+							stack[stackCount++] = -(jointIndex + 1);
+							stack[stackCount++] = nodeIndex;
+						}
+					}
+
+					if (node->dim > b2_maxTreeNodeDim)
+					{
+						isTree = false;
+						break;
+					}
+				}
+				else
+				{
+					int32 jointIndex = -(item + 1);
+					b2JointTreeJoint* tj = m_joints + jointIndex;
+					node->body = false;
+					node->dim = tj->dim;
+					node->item = jointIndex;
+					tj->node = nodeIndex;
+
+					int32 parentBody = m_nodes[parent].item;
+					int32 child = tj->indexA == parentBody ? tj->indexB : tj->indexA;
+					stack[stackCount++] = child;
+					stack[stackCount++] = nodeIndex;
+				}
+			}
+		}
+
+		b2Assert(isTree == false || m_nodeCount <= bodyCount + jointCount);
+	}
+
+	m_allocator->Free(stack);
+	m_allocator->Free(bodyNodes);
+	m_allocator->Free(bodyJoints);
+	m_allocator->Free(jointStart);
+	m_allocator->Free(sets);
+
+	// The velocity system must be solvable. Redundant joints make it singular.
+	return isTree && Build();
+}
+
+// Compute the Jacobians at the current positions, then load and factor the
+// system. Returns false if the system is singular.
+bool b2JointTreeSolver::Build()
+{
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2JointTreeJoint* tj = m_joints + i;
+
+		b2Vec2 cA = m_positions[tj->indexA].c;
+		b2Vec2 cB = m_positions[tj->indexB].c;
+		b2Rot qA(m_positions[tj->indexA].a);
+		b2Rot qB(m_positions[tj->indexB].a);
+		b2Vec2 rA = b2Mul(qA, tj->localAnchorA);
+		b2Vec2 rB = b2Mul(qB, tj->localAnchorB);
+
+		if (tj->dim == 2)
+		{
+			// Point-to-point constraint
+			// J = [-I -r1_skew I r2_skew ]
+			tj->JA[0] = -1.0f; tj->JA[1] = 0.0f; tj->JA[2] = rA.y;
+			tj->JA[3] = 0.0f; tj->JA[4] = -1.0f; tj->JA[5] = -rA.x;
+			tj->JB[0] = 1.0f; tj->JB[1] = 0.0f; tj->JB[2] = -rB.y;
+			tj->JB[3] = 0.0f; tj->JB[4] = 1.0f; tj->JB[5] = rB.x;
+		}
+		else
+		{
+			// Distance constraint
+			// J = [-u -cross(r1, u) u cross(r2, u)]
+			b2Vec2 d = cB + rB - cA - rA;
+			float32 length = d.Length();
+			if (length > b2_linearSlop)
+			{
+				tj->u = (1.0f / length) * d;
+			}
+
+			b2Vec2 u = tj->u;
+			tj->JA[0] = -u.x; tj->JA[1] = -u.y; tj->JA[2] = -b2Cross(rA, u);
+			tj->JB[0] = u.x; tj->JB[1] = u.y; tj->JB[2] = b2Cross(rB, u);
+		}
+
+		// The velocity of a body without a node goes to the right hand side.
+		tj->bias[1] = 0.0f;
+		for (int32 k = 0; k < tj->dim; ++k)
+		{
+			float32 bias = 0.0f;
+			if (tj->dynamicA == false)
+			{
+				b2Velocity vA = m_velocities[tj->indexA];
+				bias -= tj->JA[3 * k + 0] * vA.v.x + tj->JA[3 * k + 1] * vA.v.y + tj->JA[3 * k + 2] * vA.w;
+			}
+
+			if (tj->dynamicB == false)
+			{
+				b2Velocity vB = m_velocities[tj->indexB];
+				bias -= tj->JB[3 * k + 0] * vB.v.x + tj->JB[3 * k + 1] * vB.v.y + tj->JB[3 * k + 2] * vB.w;
+			}
+			tj->bias[k] = bias;
+		}
+	}
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		int32 n = node->dim;
+		for (int32 k = 0; k < n * n; ++k)
+		{
+			node->D[k] = 0.0f;
+		}
+
+		if (node->body)
+		{
+			b2Body* b = m_bodies[node->item];
+			node->D[0] = b->Mass();
+			node->D[n + 1] = b->Mass();
+			node->D[2 * n + 2] = b->I();
+		}
+
+		if (node->parent < 0)
+		{
+			continue;
+		}
+
+		// Couple a joint and a body with the block of J for the body.
+		const b2JointTreeNode* parent = m_nodes + node->parent;
+		int32 m = parent->dim;
+		const b2JointTreeJoint* tj = m_joints + (node->body ? parent->item : node->item);
+		int32 bodyIndex = node->body ? node->item : parent->item;
+		const float32* J = tj->indexA == bodyIndex ? tj->JA : tj->JB;
+
+		for (int32 k = 0; k < n * m; ++k)
+		{
+			node->H[k] = 0.0f;
+		}
+
+		for (int32 k = 0; k < tj->dim; ++k)
+		{
+			for (int32 c = 0; c < 3; ++c)
+			{
+				if (node->body)
+				{
+					// H = J^T
+					node->H[m * c + k] = J[3 * k + c];
+				}
+				else
+				{
+					// H = J
+					node->H[m * k + c] = J[3 * k + c];
+				}
+			}
+		}
+	}
+
+	// A joint folded into a body node couples to the body in the diagonal block.
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		const b2JointTreeJoint* tj = m_joints + i;
+		if (tj->dynamicA && tj->dynamicB)
+		{
+			continue;
+		}
+
+		b2JointTreeNode* node = m_nodes + tj->node;
+		const float32* J = tj->dynamicA ? tj->JA : tj->JB;
+		int32 n = node->dim;
+		for (int32 k = 0; k < tj->dim; ++k)
+		{
+			for (int32 c = 0; c < 3; ++c)
+			{
+				node->D[n * (tj->offset + k) + c] = J[3 * k + c];
+				node->D[n * c + tj->offset + k] = J[3 * k + c];
+			}
+		}
+	}
+
+	return Factor();
+}
+
+// Eliminate the nodes from the leaves to the roots. Each node is left with
+// its inverted diagonal block and H = D^-1 * H.
+bool b2JointTreeSolver::Factor()
+{
+	float32 T[2 * b2_maxTreeNodeDim];
+
+	for (int32 i = m_nodeCount - 1; i >= 0; --i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		int32 n = node->dim;
+		if (b2InvertBlock(node->D, n) == false)
+		{
+			return false;
+		}
+
+		if (node->parent < 0)
+		{
+			continue;
+		}
+
+		b2JointTreeNode* parent = m_nodes + node->parent;
+		int32 m = parent->dim;
+
+		// T = D^-1 * H
+		for (int32 r = 0; r < n; ++r)
+		{
+			for (int32 c = 0; c < m; ++c)
+			{
+				float32 sum = 0.0f;
+				for (int32 k = 0; k < n; ++k)
+				{
+					sum += node->D[n * r + k] * node->H[m * k + c];
+				}
+				T[m * r + c] = sum;
+			}
+		}
+
+		// D_parent -= H^T * T
+		for (int32 r = 0; r < m; ++r)
+		{
+			for (int32 c = 0; c < m; ++c)
+			{
+				float32 sum = 0.0f;
+				for (int32 k = 0; k < n; ++k)
+				{
+					sum += node->H[m * k + r] * T[m * k + c];
+				}
+				parent->D[m * r + c] -= sum;
+			}
+		}
+
+		for (int32 k = 0; k < n * m; ++k)
+		{
+			node->H[k] = T[k];
+		}
+	}
+
+	return true;
+}
+
+// Solve the factored system for the right hand side in x.
+void b2JointTreeSolver::Solve()
+{
+	float32 y[b2_maxTreeNodeDim];
+
+	// Leaves to roots: move the right hand side of each node into its parent.
+	for (int32 i = m_nodeCount - 1; i >= 0; --i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		int32 n = node->dim;
+
+		if (node->parent >= 0)
+		{
+			b2JointTreeNode* parent = m_nodes + node->parent;
+			int32 m = parent->dim;
+			for (int32 c = 0; c < m; ++c)
+			{
+				float32 sum = 0.0f;
+				for (int32 k = 0; k < n; ++k)
+				{
+					sum += node->H[m * k + c] * node->x[k];
+				}
+				parent->x[c] -= sum;
+			}
+		}
+
+		for (int32 r = 0; r < n; ++r)
+		{
+			float32 sum = 0.0f;
+			for (int32 k = 0; k < n; ++k)
+			{
+				sum += node->D[n * r + k] * node->x[k];
+			}
+			y[r] = sum;
+		}
+
+		for (int32 r = 0; r < n; ++r)
+		{
+			node->x[r] = y[r];
+		}
+	}
+
+	// Roots to leaves: substitute the solution of the parent.
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		if (node->parent < 0)
+		{
+			continue;
+		}
+
+		const b2JointTreeNode* parent = m_nodes + node->parent;
+		int32 n = node->dim;
+		int32 m = parent->dim;
+		for (int32 r = 0; r < n; ++r)
+		{
+			float32 sum = 0.0f;
+			for (int32 c = 0; c < m; ++c)
+			{
+				sum += node->H[m * r + c] * parent->x[c];
+			}
+			node->x[r] -= sum;
+		}
+	}
+}
+
+void b2JointTreeSolver::SolveVelocityConstraints()
+{
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2JointTreeNode* node = m_nodes + i;
+		if (node->body)
+		{
+			b2Body* b = m_bodies[node->item];
+			b2Velocity v = m_velocities[node->item];
+			node->x[0] = b->Mass() * v.v.x;
+			node->x[1] = b->Mass() * v.v.y;
+			node->x[2] = b->I() * v.w;
+		}
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		const b2JointTreeJoint* tj = m_joints + i;
+		b2JointTreeNode* node = m_nodes + tj->node;
+		for (int32 k = 0; k < tj->dim; ++k)
+		{
+			node->x[tj->offset + k] = tj->bias[k];
+		}
+	}
+
+	Solve();
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		const b2JointTreeNode* node = m_nodes + i;
+		if (node->body)
+		{
+			b2Velocity& v = m_velocities[node->item];
+			v.v.Set(node->x[0], node->x[1]);
+			v.w = node->x[2];
+		}
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2JointTreeJoint* tj = m_joints + i;
+		const b2JointTreeNode* node = m_nodes + tj->node;
+		for (int32 k = 0; k < tj->dim; ++k)
+		{
+			tj->impulse[k] -= node->x[tj->offset + k];
+		}
+	}
+}
+
+void b2JointTreeSolver::StoreImpulses()
+{
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		const b2JointTreeJoint* tj = m_joints + i;
+		if (tj->dim == 2)
+		{
+			// The impulse acts on body B.
+			b2RevoluteJoint* revolute = (b2RevoluteJoint*)tj->joint;
+			revolute->m_impulse.Set(tj->impulse[0], tj->impulse[1], 0.0f);
+		}
+		else
+		{
+			b2DistanceJoint* distance = (b2DistanceJoint*)tj->joint;
+			distance->m_impulse = tj->impulse[0];
+		}
+	}
+}
@@ -0,0 +1,74 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_JOINT_TREE_SOLVER_H
+#define B2_JOINT_TREE_SOLVER_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+class b2Body;
+class b2Joint;
+class b2StackAllocator;
+struct b2JointTreeNode;
+struct b2JointTreeJoint;
+
+/// A direct solver for the joints of an island when they form a tree.
+/// The bodies and joints are the nodes of a sparse linear system that is
+/// factored from the leaves to the root, in linear time (Baraff 1996). One solve
+/// satisfies all the joint velocities exactly, so long chains don't need many
+/// iterations. Only rigid revolute and distance joints without motors or limits
+/// are handled. The joint positions are left to the joints.
+class b2JointTreeSolver
+{
+public:
+	b2JointTreeSolver(b2StackAllocator* allocator);
+	~b2JointTreeSolver();
+
+	/// Build the tree and factor the velocity constraints. Returns false if the
+	/// joints don't form a tree of supported joints. The joints must then be
+	/// solved iteratively.
+	bool Initialize(const b2SolverData& data, b2Body** bodies, int32 bodyCount,
+					b2Joint** joints, int32 jointCount);
+
+	/// Make the velocities satisfy the joints exactly. The impulses add up over
+	/// the iterations.
+	void SolveVelocityConstraints();
+
+	/// Copy the impulses to the joints for the reaction forces.
+	void StoreImpulses();
+
+private:
+
+	bool Build();
+	bool Factor();
+	void Solve();
+
+	b2StackAllocator* m_allocator;
+	b2Position* m_positions;
+	b2Velocity* m_velocities;
+	b2Body** m_bodies;
+
+	b2JointTreeNode* m_nodes;
+	int32 m_nodeCount;
+
+	b2JointTreeJoint* m_joints;
+	int32 m_jointCount;
+};
+
+#endif
@@ -96,9 +96,9 @@ float32 b2MouseJoint::GetDampingRatio() const
 void b2MouseJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIB = m_bodyB->m_invI;
+	m_localCenterB = m_bodyB->Sweep().localCenter;
+	m_invMassB = m_bodyB->InvMass();
+	m_invIB = m_bodyB->InvI();
 
 	b2Vec2 cB = data.positions[m_indexB].c;
 	float32 aB = data.positions[m_indexB].a;
@@ -127,12 +127,12 @@ void b2PrismaticJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	m_indexA = m_bodyA->m_islandIndex;
 	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_localCenterA = m_bodyA->Sweep().localCenter;
+	m_localCenterB = m_bodyB->Sweep().localCenter;
+	m_invMassA = m_bodyA->InvMass();
+	m_invMassB = m_bodyB->InvMass();
+	m_invIA = m_bodyA->InvI();
+	m_invIB = m_bodyB->InvI();
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -528,17 +528,17 @@ float32 b2PrismaticJoint::GetJointSpeed() const
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
 
-	b2Vec2 rA = b2Mul(bA->m_xf.q, m_localAnchorA - bA->m_sweep.localCenter);
-	b2Vec2 rB = b2Mul(bB->m_xf.q, m_localAnchorB - bB->m_sweep.localCenter);
-	b2Vec2 p1 = bA->m_sweep.c + rA;
-	b2Vec2 p2 = bB->m_sweep.c + rB;
+	b2Vec2 rA = b2Mul(bA->Xf().q, m_localAnchorA - bA->Sweep().localCenter);
+	b2Vec2 rB = b2Mul(bB->Xf().q, m_localAnchorB - bB->Sweep().localCenter);
+	b2Vec2 p1 = bA->Sweep().c + rA;
+	b2Vec2 p2 = bB->Sweep().c + rB;
 	b2Vec2 d = p2 - p1;
-	b2Vec2 axis = b2Mul(bA->m_xf.q, m_localXAxisA);
+	b2Vec2 axis = b2Mul(bA->Xf().q, m_localXAxisA);
 
-	b2Vec2 vA = bA->m_linearVelocity;
-	b2Vec2 vB = bB->m_linearVelocity;
-	float32 wA = bA->m_angularVelocity;
-	float32 wB = bB->m_angularVelocity;
+	b2Vec2 vA = bA->LinearVelocity();
+	b2Vec2 vB = bB->LinearVelocity();
+	float32 wA = bA->AngularVelocity();
+	float32 wB = bB->AngularVelocity();
 
 	float32 speed = b2Dot(d, b2Cross(wA, axis)) + b2Dot(axis, vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA));
 	return speed;
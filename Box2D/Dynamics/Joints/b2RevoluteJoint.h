@@ -157,6 +157,8 @@ public:
 protected:
 	
 	friend class b2Joint;
+	friend class b2JointBatchSolver;
+	friend class b2JointTreeSolver;
 	friend class b2GearJoint;
 
 	b2RevoluteJoint(const b2RevoluteJointDef* def);
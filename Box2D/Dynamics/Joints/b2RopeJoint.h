@@ -82,6 +82,7 @@ public:
 protected:
 
 	friend class b2Joint;
+	friend class b2JointBatchSolver;
 	b2RopeJoint(const b2RopeJointDef* data);
 
 	void InitVelocityConstraints(const b2SolverData& data);
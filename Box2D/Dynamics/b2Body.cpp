@@ -21,6 +21,10 @@
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
 
 b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 {
@@ -56,58 +60,72 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 
 	m_world = world;
 
-	m_xf.p = bd->position;
-	m_xf.q.Set(bd->angle);
+	m_store = &world->m_bodyStore;
+	m_storeIndex = m_store->Add(this);
 
-	m_sweep.localCenter.SetZero();
-	m_sweep.c0 = m_xf.p;
-	m_sweep.c = m_xf.p;
-	m_sweep.a0 = bd->angle;
-	m_sweep.a = bd->angle;
-	m_sweep.alpha0 = 0.0f;
+	Xf().p = bd->position;
+	Xf().q.Set(bd->angle);
+
+	Sweep().localCenter.SetZero();
+	Sweep().c0 = Xf().p;
+	Sweep().c = Xf().p;
+	Sweep().a0 = bd->angle;
+	Sweep().a = bd->angle;
+	Sweep().alpha0 = 0.0f;
 
 	m_jointList = NULL;
 	m_contactList = NULL;
 	m_prev = NULL;
 	m_next = NULL;
 
-	m_linearVelocity = bd->linearVelocity;
-	m_angularVelocity = bd->angularVelocity;
+	LinearVelocity() = bd->linearVelocity;
+	AngularVelocity() = bd->angularVelocity;
 
 	m_linearDamping = bd->linearDamping;
 	m_angularDamping = bd->angularDamping;
 	m_gravityScale = bd->gravityScale;
 
-	m_force.SetZero();
-	m_torque = 0.0f;
-
-	m_sleepTime = 0.0f;
+	Force().SetZero();
+	Torque() = 0.0f;
 
 	m_type = bd->type;
 
 	if (m_type == b2_dynamicBody)
 	{
-		m_mass = 1.0f;
-		m_invMass = 1.0f;
+		Mass() = 1.0f;
+		InvMass() = 1.0f;
 	}
 	else
 	{
-		m_mass = 0.0f;
-		m_invMass = 0.0f;
+		Mass() = 0.0f;
+		InvMass() = 0.0f;
 	}
 
-	m_I = 0.0f;
-	m_invI = 0.0f;
+	I() = 0.0f;
+	InvI() = 0.0f;
 
 	m_userData = bd->userData;
 
 	m_fixtureList = NULL;
 	m_fixtureCount = 0;
+
+	m_minExtent = 0.0f;
+	m_maxExtent = 0.0f;
+
+	m_islandIndex = 0;
+	m_islandEpoch = 0;
+
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
+
+	m_store->UpdateAwake(this);
 }
 
 b2Body::~b2Body()
 {
 	// shapes and joints are destroyed in b2World::Destroy
+	m_store->Remove(m_storeIndex);
 }
 
 void b2Body::SetType(b2BodyType type)
@@ -129,17 +147,21 @@ void b2Body::SetType(b2BodyType type)
 
 	if (m_type == b2_staticBody)
 	{
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_sweep.a0 = m_sweep.a;
-		m_sweep.c0 = m_sweep.c;
+		LinearVelocity().SetZero();
+		AngularVelocity() = 0.0f;
+		Sweep().a0 = Sweep().a;
+		Sweep().c0 = Sweep().c;
 		SynchronizeFixtures();
 	}
 
 	SetAwake(true);
+	UpdateAwakeSets();
 
-	m_force.SetZero();
-	m_torque = 0.0f;
+	// Static bodies don't belong to islands.
+	m_world->m_islandManager.ResetBody(this);
+
+	Force().SetZero();
+	Torque() = 0.0f;
 
 	// Since the body type changed, we need to flag contacts for filtering.
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
@@ -162,10 +184,13 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 	b2Fixture* fixture = new (memory) b2Fixture;
 	fixture->Create(allocator, this, def);
 
+	m_world->m_proxyBytes += fixture->m_shape->GetChildCount() * sizeof(b2FixtureProxy);
+	m_world->m_maxProxyBytes = b2Max(m_world->m_maxProxyBytes, m_world->m_proxyBytes);
+
 	if (m_flags & e_activeFlag)
 	{
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
-		fixture->CreateProxies(broadPhase, m_xf);
+		fixture->CreateProxies(broadPhase, Xf());
 	}
 
 	fixture->m_next = m_fixtureList;
@@ -174,6 +199,8 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 
 	fixture->m_body = this;
 
+	ResetExtents();
+
 	// Adjust mass properties if needed.
 	if (fixture->m_density > 0.0f)
 	{
@@ -248,9 +275,11 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 	if (m_flags & e_activeFlag)
 	{
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+		m_world->m_sensorManager.DestroyPairs(fixture);
 		fixture->DestroyProxies(broadPhase);
 	}
 
+	m_world->m_proxyBytes -= fixture->m_shape->GetChildCount() * sizeof(b2FixtureProxy);
 	fixture->Destroy(allocator);
 	fixture->m_body = NULL;
 	fixture->m_next = NULL;
@@ -259,25 +288,127 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 
 	--m_fixtureCount;
 
+	ResetExtents();
+
 	// Reset the mass data.
 	ResetMassData();
 }
 
+// Get the smallest distance from the core of a shape to its surface and the largest
+// distance from the origin to its surface. Edges and chains have no interior,
+// so only their skin counts.
+static void b2GetShapeExtents(const b2Shape* shape, float32* minExtent, float32* maxExtent)
+{
+	float32 radius = shape->m_radius;
+	const b2Vec2* vertices = NULL;
+	int32 count = 0;
+	*minExtent = radius;
+
+	switch (shape->GetType())
+	{
+	case b2Shape::e_circle:
+		{
+			const b2CircleShape* circle = (const b2CircleShape*)shape;
+			*maxExtent = circle->m_p.Length() + radius;
+			return;
+		}
+
+	case b2Shape::e_polygon:
+		{
+			const b2PolygonShape* poly = (const b2PolygonShape*)shape;
+			vertices = poly->m_vertices;
+			count = poly->m_vertexCount;
+
+			// The polygon is convex, so its inner radius is the smallest
+			// distance from the centroid to an edge.
+			float32 inner = b2_maxFloat;
+			for (int32 i = 0; i < count; ++i)
+			{
+				float32 distance = b2Dot(poly->m_normals[i], vertices[i] - poly->m_centroid);
+				inner = b2Min(inner, distance);
+			}
+			*minExtent += inner;
+		}
+		break;
+
+	case b2Shape::e_edge:
+		{
+			const b2EdgeShape* edge = (const b2EdgeShape*)shape;
+			vertices = &edge->m_vertex1;
+			count = 2;
+		}
+		break;
+
+	case b2Shape::e_chain:
+		{
+			const b2ChainShape* chain = (const b2ChainShape*)shape;
+			vertices = chain->m_vertices;
+			count = chain->m_count;
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+
+	float32 maxDistanceSqr = 0.0f;
+	for (int32 i = 0; i < count; ++i)
+	{
+		maxDistanceSqr = b2Max(maxDistanceSqr, vertices[i].LengthSquared());
+	}
+	*maxExtent = b2Sqrt(maxDistanceSqr) + radius;
+}
+
+void b2Body::ResetExtents()
+{
+	float32 minExtent = b2_maxFloat;
+	float32 maxExtent = 0.0f;
+	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+	{
+		float32 fixtureMin, fixtureMax;
+		b2GetShapeExtents(f->m_shape, &fixtureMin, &fixtureMax);
+		minExtent = b2Min(minExtent, fixtureMin);
+		maxExtent = b2Max(maxExtent, fixtureMax);
+	}
+
+	m_minExtent = m_fixtureList ? minExtent : 0.0f;
+	m_maxExtent = maxExtent;
+}
+
+void b2Body::UpdateFastFlag()
+{
+	// Bound the distance travelled by any point of the body. The rotation is
+	// about the center of mass.
+	const b2Sweep& sweep = Sweep();
+	float32 arm = m_maxExtent + sweep.localCenter.Length();
+	float32 motion = b2Distance(sweep.c0, sweep.c) + b2Abs(sweep.a - sweep.a0) * arm;
+
+	if (motion > b2_ccdMotionFraction * m_minExtent)
+	{
+		m_flags |= e_fastFlag;
+	}
+	else
+	{
+		m_flags &= ~e_fastFlag;
+	}
+}
+
 void b2Body::ResetMassData()
 {
 	// Compute mass data from shapes. Each shape has its own density.
-	m_mass = 0.0f;
-	m_invMass = 0.0f;
-	m_I = 0.0f;
-	m_invI = 0.0f;
-	m_sweep.localCenter.SetZero();
+	Mass() = 0.0f;
+	InvMass() = 0.0f;
+	I() = 0.0f;
+	InvI() = 0.0f;
+	Sweep().localCenter.SetZero();
 
 	// Static and kinematic bodies have zero mass.
 	if (m_type == b2_staticBody || m_type == b2_kinematicBody)
 	{
-		m_sweep.c0 = m_xf.p;
-		m_sweep.c = m_xf.p;
-		m_sweep.a0 = m_sweep.a;
+		Sweep().c0 = Xf().p;
+		Sweep().c = Xf().p;
+		Sweep().a0 = Sweep().a;
 		return;
 	}
 
@@ -294,45 +425,45 @@ void b2Body::ResetMassData()
 
 		b2MassData massData;
 		f->GetMassData(&massData);
-		m_mass += massData.mass;
+		Mass() += massData.mass;
 		localCenter += massData.mass * massData.center;
-		m_I += massData.I;
+		I() += massData.I;
 	}
 
 	// Compute center of mass.
-	if (m_mass > 0.0f)
+	if (Mass() > 0.0f)
 	{
-		m_invMass = 1.0f / m_mass;
-		localCenter *= m_invMass;
+		InvMass() = 1.0f / Mass();
+		localCenter *= InvMass();
 	}
 	else
 	{
 		// Force all dynamic bodies to have a positive mass.
-		m_mass = 1.0f;
-		m_invMass = 1.0f;
+		Mass() = 1.0f;
+		InvMass() = 1.0f;
 	}
 
-	if (m_I > 0.0f && (m_flags & e_fixedRotationFlag) == 0)
+	if (I() > 0.0f && (m_flags & e_fixedRotationFlag) == 0)
 	{
 		// Center the inertia about the center of mass.
-		m_I -= m_mass * b2Dot(localCenter, localCenter);
-		b2Assert(m_I > 0.0f);
-		m_invI = 1.0f / m_I;
+		I() -= Mass() * b2Dot(localCenter, localCenter);
+		b2Assert(I() > 0.0f);
+		InvI() = 1.0f / I();
 
 	}
 	else
 	{
-		m_I = 0.0f;
-		m_invI = 0.0f;
+		I() = 0.0f;
+		InvI() = 0.0f;
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter = localCenter;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = Sweep().c;
+	Sweep().localCenter = localCenter;
+	Sweep().c0 = Sweep().c = b2Mul(Xf(), Sweep().localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	LinearVelocity() += b2Cross(AngularVelocity(), Sweep().c - oldCenter);
 }
 
 void b2Body::SetMassData(const b2MassData* massData)
@@ -348,32 +479,32 @@ void b2Body::SetMassData(const b2MassData* massData)
 		return;
 	}
 
-	m_invMass = 0.0f;
-	m_I = 0.0f;
-	m_invI = 0.0f;
+	InvMass() = 0.0f;
+	I() = 0.0f;
+	InvI() = 0.0f;
 
-	m_mass = massData->mass;
-	if (m_mass <= 0.0f)
+	Mass() = massData->mass;
+	if (Mass() <= 0.0f)
 	{
-		m_mass = 1.0f;
+		Mass() = 1.0f;
 	}
 
-	m_invMass = 1.0f / m_mass;
+	InvMass() = 1.0f / Mass();
 
 	if (massData->I > 0.0f && (m_flags & b2Body::e_fixedRotationFlag) == 0)
 	{
-		m_I = massData->I - m_mass * b2Dot(massData->center, massData->center);
-		b2Assert(m_I > 0.0f);
-		m_invI = 1.0f / m_I;
+		I() = massData->I - Mass() * b2Dot(massData->center, massData->center);
+		b2Assert(I() > 0.0f);
+		InvI() = 1.0f / I();
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter =  massData->center;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = Sweep().c;
+	Sweep().localCenter =  massData->center;
+	Sweep().c0 = Sweep().c = b2Mul(Xf(), Sweep().localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	LinearVelocity() += b2Cross(AngularVelocity(), Sweep().c - oldCenter);
 }
 
 bool b2Body::ShouldCollide(const b2Body* other) const
@@ -407,19 +538,19 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 		return;
 	}
 
-	m_xf.q.Set(angle);
-	m_xf.p = position;
+	Xf().q.Set(angle);
+	Xf().p = position;
 
-	m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
-	m_sweep.a = angle;
+	Sweep().c = b2Mul(Xf(), Sweep().localCenter);
+	Sweep().a = angle;
 
-	m_sweep.c0 = m_sweep.c;
-	m_sweep.a0 = angle;
+	Sweep().c0 = Sweep().c;
+	Sweep().a0 = angle;
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
-		f->Synchronize(broadPhase, m_xf, m_xf);
+		f->Synchronize(broadPhase, Xf(), Xf());
 	}
 
 	m_world->m_contactManager.FindNewContacts();
@@ -427,14 +558,40 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 
 void b2Body::SynchronizeFixtures()
 {
-	b2Transform xf1;
-	xf1.q.Set(m_sweep.a0);
-	xf1.p = m_sweep.c0 - b2Mul(xf1.q, m_sweep.localCenter);
+	b2Transform xf1, xf2;
+	const b2Sweep& sweep = Sweep();
+	float32 speculativeTime = m_world->m_speculativeTime;
+	if (speculativeTime > 0.0f)
+	{
+		// Speculative contacts need their pairs before the shapes can touch,
+		// so the proxies cover the motion of the next step instead of the
+		// motion of this one.
+		xf1 = Xf();
+		xf2.q.Set(sweep.a + speculativeTime * AngularVelocity());
+		xf2.p = sweep.c + speculativeTime * LinearVelocity() - b2Mul(xf2.q, sweep.localCenter);
+	}
+	else
+	{
+		xf1.q.Set(sweep.a0);
+		xf1.p = sweep.c0 - b2Mul(xf1.q, sweep.localCenter);
+		xf2 = Xf();
+	}
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
-		f->Synchronize(broadPhase, xf1, m_xf);
+		f->Synchronize(broadPhase, xf1, xf2);
+	}
+}
+
+void b2Body::UpdateAwakeSets()
+{
+	m_store->UpdateAwake(this);
+
+	b2ContactManager* contactManager = &m_world->m_contactManager;
+	for (b2ContactEdge* ce = m_contactList; ce; ce = ce->next)
+	{
+		contactManager->UpdateAwakeContact(ce->contact);
 	}
 }
 
@@ -455,7 +612,7 @@ void b2Body::SetActive(bool flag)
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
-			f->CreateProxies(broadPhase, m_xf);
+			f->CreateProxies(broadPhase, Xf());
 		}
 
 		// Contacts are created the next time step.
@@ -468,6 +625,7 @@ void b2Body::SetActive(bool flag)
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
+			m_world->m_sensorManager.DestroyPairs(f);
 			f->DestroyProxies(broadPhase);
 		}
 
@@ -481,6 +639,9 @@ void b2Body::SetActive(bool flag)
 		}
 		m_contactList = NULL;
 	}
+
+	// Inactive bodies don't belong to islands and their joints are ignored.
+	m_world->m_islandManager.ResetBody(this);
 }
 
 void b2Body::Dump()
@@ -490,10 +651,10 @@ void b2Body::Dump()
 	b2Log("{\n");
 	b2Log("  b2BodyDef bd;\n");
 	b2Log("  bd.type = b2BodyType(%d);\n", m_type);
-	b2Log("  bd.position.Set(%.15lef, %.15lef);\n", m_xf.p.x, m_xf.p.y);
-	b2Log("  bd.angle = %.15lef;\n", m_sweep.a);
-	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", m_linearVelocity.x, m_linearVelocity.y);
-	b2Log("  bd.angularVelocity = %.15lef;\n", m_angularVelocity);
+	b2Log("  bd.position.Set(%.15lef, %.15lef);\n", Xf().p.x, Xf().p.y);
+	b2Log("  bd.angle = %.15lef;\n", Sweep().a);
+	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", LinearVelocity().x, LinearVelocity().y);
+	b2Log("  bd.angularVelocity = %.15lef;\n", AngularVelocity());
 	b2Log("  bd.linearDamping = %.15lef;\n", m_linearDamping);
 	b2Log("  bd.angularDamping = %.15lef;\n", m_angularDamping);
 	b2Log("  bd.allowSleep = bool(%d);\n", m_flags & e_autoSleepFlag);
@@ -21,6 +21,7 @@
 
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Dynamics/b2BodyStore.h>
 #include <memory>
 
 class b2Fixture;
@@ -31,6 +32,7 @@ class b2World;
 struct b2FixtureDef;
 struct b2JointEdge;
 struct b2ContactEdge;
+struct b2PersistentIsland;
 
 /// The body type.
 /// static: zero mass, zero velocity, may be manually moved
@@ -162,21 +164,21 @@ public:
 
 	/// Get the body transform for the body's origin.
 	/// @return the world transform of the body's origin.
-	const b2Transform& GetTransform() const;
+	b2Transform GetTransform() const;
 
 	/// Get the world body origin position.
 	/// @return the world position of the body's origin.
-	const b2Vec2& GetPosition() const;
+	b2Vec2 GetPosition() const;
 
 	/// Get the angle in radians.
 	/// @return the current world rotation angle in radians.
 	float32 GetAngle() const;
 
 	/// Get the world position of the center of mass.
-	const b2Vec2& GetWorldCenter() const;
+	b2Vec2 GetWorldCenter() const;
 
 	/// Get the local position of the center of mass.
-	const b2Vec2& GetLocalCenter() const;
+	b2Vec2 GetLocalCenter() const;
 
 	/// Set the linear velocity of the center of mass.
 	/// @param v the new linear velocity of the center of mass.
@@ -385,6 +387,9 @@ private:
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2Contact;
+	friend class b2BodyStore;
+	friend class b2IslandManager;
+	friend class b2SensorManager;
 	
 	friend class b2DistanceJoint;
 	friend class b2GearJoint;
@@ -396,17 +401,18 @@ private:
 	friend class b2WeldJoint;
 	friend class b2FrictionJoint;
 	friend class b2RopeJoint;
+	friend class b2JointTreeSolver;
 
 	// m_flags
 	enum
 	{
-		e_islandFlag		= 0x0001,
 		e_awakeFlag			= 0x0002,
 		e_autoSleepFlag		= 0x0004,
 		e_bulletFlag		= 0x0008,
 		e_fixedRotationFlag	= 0x0010,
 		e_activeFlag		= 0x0020,
-		e_toiFlag			= 0x0040
+		e_toiFlag			= 0x0040,
+		e_fastFlag			= 0x0080
 	};
 
 	b2Body(const b2BodyDef* bd, b2World* world);
@@ -415,26 +421,64 @@ private:
 	void SynchronizeFixtures();
 	void SynchronizeTransform();
 
+	// Tell the body store and the contact manager that this body was put to
+	// sleep, woken up or changed type.
+	void UpdateAwakeSets();
+
 	// This is used to prevent connected bodies from colliding.
 	// It may lie, depending on the collideConnected flag.
 	bool ShouldCollide(const b2Body* other) const;
 
 	void Advance(float32 t);
 
+	// Compute the extents of the fixtures. Call this when fixtures are added or removed.
+	void ResetExtents();
+
+	// Flag the body for continuous collision if its swept motion is large
+	// compared to its smallest extent.
+	void UpdateFastFlag();
+
+	// The solver state lives in the world's body store.
+	b2Transform& Xf() { return m_store->m_transforms[m_storeIndex]; }	// the body origin transform
+	const b2Transform& Xf() const { return m_store->m_transforms[m_storeIndex]; }
+	b2Sweep& Sweep() { return m_store->m_sweeps[m_storeIndex]; }	// the swept motion for CCD
+	const b2Sweep& Sweep() const { return m_store->m_sweeps[m_storeIndex]; }
+
+	b2Vec2& LinearVelocity() { return m_store->m_linearVelocities[m_storeIndex]; }
+	const b2Vec2& LinearVelocity() const { return m_store->m_linearVelocities[m_storeIndex]; }
+	float32& AngularVelocity() { return m_store->m_angularVelocities[m_storeIndex]; }
+	float32 AngularVelocity() const { return m_store->m_angularVelocities[m_storeIndex]; }
+
+	b2Vec2& Force() { return m_store->m_forces[m_storeIndex]; }
+	const b2Vec2& Force() const { return m_store->m_forces[m_storeIndex]; }
+	float32& Torque() { return m_store->m_torques[m_storeIndex]; }
+	float32 Torque() const { return m_store->m_torques[m_storeIndex]; }
+
+	float32& Mass() { return m_store->m_masses[m_storeIndex]; }
+	float32 Mass() const { return m_store->m_masses[m_storeIndex]; }
+	float32& InvMass() { return m_store->m_invMasses[m_storeIndex]; }
+	float32 InvMass() const { return m_store->m_invMasses[m_storeIndex]; }
+
+	// Rotational inertia about the center of mass.
+	float32& I() { return m_store->m_Is[m_storeIndex]; }
+	float32 I() const { return m_store->m_Is[m_storeIndex]; }
+	float32& InvI() { return m_store->m_invIs[m_storeIndex]; }
+	float32 InvI() const { return m_store->m_invIs[m_storeIndex]; }
+
 	b2BodyType m_type;
 
 	uint16 m_flags;
 
 	int32 m_islandIndex;
+	uint32 m_islandEpoch;
 
-	b2Transform m_xf;		// the body origin transform
-	b2Sweep m_sweep;		// the swept motion for CCD
+	// Persistent island membership. Static and inactive bodies have no island.
+	b2PersistentIsland* m_island;
+	b2Body* m_islandPrev;
+	b2Body* m_islandNext;
 
-	b2Vec2 m_linearVelocity;
-	float32 m_angularVelocity;
-
-	b2Vec2 m_force;
-	float32 m_torque;
+	b2BodyStore* m_store;
+	int32 m_storeIndex;
 
 	b2World* m_world;
 	b2Body* m_prev;
@@ -443,20 +487,18 @@ private:
 	b2Fixture* m_fixtureList;
 	int32 m_fixtureCount;
 
+	// The smallest distance from a shape's core to its surface and the
+	// largest distance from the body origin to a shape's surface.
+	float32 m_minExtent;
+	float32 m_maxExtent;
+
 	b2JointEdge* m_jointList;
 	b2ContactEdge* m_contactList;
 
-	float32 m_mass, m_invMass;
-
-	// Rotational inertia about the center of mass.
-	float32 m_I, m_invI;
-
 	float32 m_linearDamping;
 	float32 m_angularDamping;
 	float32 m_gravityScale;
 
-	float32 m_sleepTime;
-
 	void* m_userData;
 };
 
@@ -465,29 +507,29 @@ inline b2BodyType b2Body::GetType() const
 	return m_type;
 }
 
-inline const b2Transform& b2Body::GetTransform() const
+inline b2Transform b2Body::GetTransform() const
 {
-	return m_xf;
+	return Xf();
 }
 
-inline const b2Vec2& b2Body::GetPosition() const
+inline b2Vec2 b2Body::GetPosition() const
 {
-	return m_xf.p;
+	return Xf().p;
 }
 
 inline float32 b2Body::GetAngle() const
 {
-	return m_sweep.a;
+	return Sweep().a;
 }
 
-inline const b2Vec2& b2Body::GetWorldCenter() const
+inline b2Vec2 b2Body::GetWorldCenter() const
 {
-	return m_sweep.c;
+	return Sweep().c;
 }
 
-inline const b2Vec2& b2Body::GetLocalCenter() const
+inline b2Vec2 b2Body::GetLocalCenter() const
 {
-	return m_sweep.localCenter;
+	return Sweep().localCenter;
 }
 
 inline void b2Body::SetLinearVelocity(const b2Vec2& v)
@@ -502,12 +544,12 @@ inline void b2Body::SetLinearVelocity(const b2Vec2& v)
 		SetAwake(true);
 	}
 
-	m_linearVelocity = v;
+	LinearVelocity() = v;
 }
 
 inline b2Vec2 b2Body::GetLinearVelocity() const
 {
-	return m_linearVelocity;
+	return LinearVelocity();
 }
 
 inline void b2Body::SetAngularVelocity(float32 w)
@@ -522,54 +564,54 @@ inline void b2Body::SetAngularVelocity(float32 w)
 		SetAwake(true);
 	}
 
-	m_angularVelocity = w;
+	AngularVelocity() = w;
 }
 
 inline float32 b2Body::GetAngularVelocity() const
 {
-	return m_angularVelocity;
+	return AngularVelocity();
 }
 
 inline float32 b2Body::GetMass() const
 {
-	return m_mass;
+	return Mass();
 }
 
 inline float32 b2Body::GetInertia() const
 {
-	return m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
+	return I() + Mass() * b2Dot(Sweep().localCenter, Sweep().localCenter);
 }
 
 inline void b2Body::GetMassData(b2MassData* data) const
 {
-	data->mass = m_mass;
-	data->I = m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
-	data->center = m_sweep.localCenter;
+	data->mass = Mass();
+	data->I = I() + Mass() * b2Dot(Sweep().localCenter, Sweep().localCenter);
+	data->center = Sweep().localCenter;
 }
 
 inline b2Vec2 b2Body::GetWorldPoint(const b2Vec2& localPoint) const
 {
-	return b2Mul(m_xf, localPoint);
+	return b2Mul(Xf(), localPoint);
 }
 
 inline b2Vec2 b2Body::GetWorldVector(const b2Vec2& localVector) const
 {
-	return b2Mul(m_xf.q, localVector);
+	return b2Mul(Xf().q, localVector);
 }
 
 inline b2Vec2 b2Body::GetLocalPoint(const b2Vec2& worldPoint) const
 {
-	return b2MulT(m_xf, worldPoint);
+	return b2MulT(Xf(), worldPoint);
 }
 
 inline b2Vec2 b2Body::GetLocalVector(const b2Vec2& worldVector) const
 {
-	return b2MulT(m_xf.q, worldVector);
+	return b2MulT(Xf().q, worldVector);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromWorldPoint(const b2Vec2& worldPoint) const
 {
-	return m_linearVelocity + b2Cross(m_angularVelocity, worldPoint - m_sweep.c);
+	return LinearVelocity() + b2Cross(AngularVelocity(), worldPoint - Sweep().c);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromLocalPoint(const b2Vec2& localPoint) const
@@ -631,17 +673,21 @@ inline void b2Body::SetAwake(bool flag)
 		if ((m_flags & e_awakeFlag) == 0)
 		{
 			m_flags |= e_awakeFlag;
-			m_sleepTime = 0.0f;
+			UpdateAwakeSets();
 		}
 	}
 	else
 	{
+		bool wasAwake = (m_flags & e_awakeFlag) == e_awakeFlag;
 		m_flags &= ~e_awakeFlag;
-		m_sleepTime = 0.0f;
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_force.SetZero();
-		m_torque = 0.0f;
+		LinearVelocity().SetZero();
+		AngularVelocity() = 0.0f;
+		Force().SetZero();
+		Torque() = 0.0f;
+		if (wasAwake)
+		{
+			UpdateAwakeSets();
+		}
 	}
 }
 
@@ -754,8 +800,8 @@ inline void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point)
 		SetAwake(true);
 	}
 
-	m_force += force;
-	m_torque += b2Cross(point - m_sweep.c, force);
+	Force() += force;
+	Torque() += b2Cross(point - Sweep().c, force);
 }
 
 inline void b2Body::ApplyForceToCenter(const b2Vec2& force)
@@ -770,7 +816,7 @@ inline void b2Body::ApplyForceToCenter(const b2Vec2& force)
 		SetAwake(true);
 	}
 
-	m_force += force;
+	Force() += force;
 }
 
 inline void b2Body::ApplyTorque(float32 torque)
@@ -785,7 +831,7 @@ inline void b2Body::ApplyTorque(float32 torque)
 		SetAwake(true);
 	}
 
-	m_torque += torque;
+	Torque() += torque;
 }
 
 inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& point)
@@ -799,8 +845,8 @@ inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& poin
 	{
 		SetAwake(true);
 	}
-	m_linearVelocity += m_invMass * impulse;
-	m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
+	LinearVelocity() += InvMass() * impulse;
+	AngularVelocity() += InvI() * b2Cross(point - Sweep().c, impulse);
 }
 
 inline void b2Body::ApplyAngularImpulse(float32 impulse)
@@ -814,23 +860,23 @@ inline void b2Body::ApplyAngularImpulse(float32 impulse)
 	{
 		SetAwake(true);
 	}
-	m_angularVelocity += m_invI * impulse;
+	AngularVelocity() += InvI() * impulse;
 }
 
 inline void b2Body::SynchronizeTransform()
 {
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	Xf().q.Set(Sweep().a);
+	Xf().p = Sweep().c - b2Mul(Xf().q, Sweep().localCenter);
 }
 
 inline void b2Body::Advance(float32 alpha)
 {
 	// Advance to the new safe time. This doesn't sync the broad-phase.
-	m_sweep.Advance(alpha);
-	m_sweep.c = m_sweep.c0;
-	m_sweep.a = m_sweep.a0;
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	Sweep().Advance(alpha);
+	Sweep().c = Sweep().c0;
+	Sweep().a = Sweep().a0;
+	Xf().q.Set(Sweep().a);
+	Xf().p = Sweep().c - b2Mul(Xf().q, Sweep().localCenter);
 }
 
 inline b2World* b2Body::GetWorld()
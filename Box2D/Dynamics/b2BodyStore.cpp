@@ -0,0 +1,229 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2BodyStore.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <cstring>
+using namespace std;
+
+const int32 b2_bodyStoreAlignment = 16;
+
+// Reserve an array in the buffer and return its offset.
+static int32 b2Reserve(int32* size, int32 bytes)
+{
+	int32 offset = *size;
+	*size += (bytes + b2_bodyStoreAlignment - 1) & ~(b2_bodyStoreAlignment - 1);
+	return offset;
+}
+
+b2BodyStore::b2BodyStore(b2Allocator* allocator)
+{
+	m_allocator = allocator;
+	m_buffer = NULL;
+	m_bufferSize = 0;
+	m_maxBufferSize = 0;
+	m_count = 0;
+	m_awakeCount = 0;
+	m_capacity = 0;
+
+	m_bodies = NULL;
+	m_transforms = NULL;
+	m_sweeps = NULL;
+	m_linearVelocities = NULL;
+	m_angularVelocities = NULL;
+	m_forces = NULL;
+	m_torques = NULL;
+	m_masses = NULL;
+	m_invMasses = NULL;
+	m_Is = NULL;
+	m_invIs = NULL;
+}
+
+b2BodyStore::~b2BodyStore()
+{
+	m_allocator->Free(m_buffer, m_bufferSize);
+}
+
+// All of the arrays live in one buffer.
+void b2BodyStore::Resize(int32 capacity)
+{
+	b2Assert(capacity >= m_count);
+
+	int32 size = 0;
+	int32 bodies = b2Reserve(&size, capacity * sizeof(b2Body*));
+	int32 transforms = b2Reserve(&size, capacity * sizeof(b2Transform));
+	int32 sweeps = b2Reserve(&size, capacity * sizeof(b2Sweep));
+	int32 linearVelocities = b2Reserve(&size, capacity * sizeof(b2Vec2));
+	int32 angularVelocities = b2Reserve(&size, capacity * sizeof(float32));
+	int32 forces = b2Reserve(&size, capacity * sizeof(b2Vec2));
+	int32 torques = b2Reserve(&size, capacity * sizeof(float32));
+	int32 masses = b2Reserve(&size, capacity * sizeof(float32));
+	int32 invMasses = b2Reserve(&size, capacity * sizeof(float32));
+	int32 Is = b2Reserve(&size, capacity * sizeof(float32));
+	int32 invIs = b2Reserve(&size, capacity * sizeof(float32));
+
+	int8* buffer = (int8*)m_allocator->Allocate(size);
+
+	b2Body** newBodies = (b2Body**)(buffer + bodies);
+	b2Transform* newTransforms = (b2Transform*)(buffer + transforms);
+	b2Sweep* newSweeps = (b2Sweep*)(buffer + sweeps);
+	b2Vec2* newLinearVelocities = (b2Vec2*)(buffer + linearVelocities);
+	float32* newAngularVelocities = (float32*)(buffer + angularVelocities);
+	b2Vec2* newForces = (b2Vec2*)(buffer + forces);
+	float32* newTorques = (float32*)(buffer + torques);
+	float32* newMasses = (float32*)(buffer + masses);
+	float32* newInvMasses = (float32*)(buffer + invMasses);
+	float32* newIs = (float32*)(buffer + Is);
+	float32* newInvIs = (float32*)(buffer + invIs);
+
+	if (m_count > 0)
+	{
+		memcpy(newBodies, m_bodies, m_count * sizeof(b2Body*));
+		memcpy(newTransforms, m_transforms, m_count * sizeof(b2Transform));
+		memcpy(newSweeps, m_sweeps, m_count * sizeof(b2Sweep));
+		memcpy(newLinearVelocities, m_linearVelocities, m_count * sizeof(b2Vec2));
+		memcpy(newAngularVelocities, m_angularVelocities, m_count * sizeof(float32));
+		memcpy(newForces, m_forces, m_count * sizeof(b2Vec2));
+		memcpy(newTorques, m_torques, m_count * sizeof(float32));
+		memcpy(newMasses, m_masses, m_count * sizeof(float32));
+		memcpy(newInvMasses, m_invMasses, m_count * sizeof(float32));
+		memcpy(newIs, m_Is, m_count * sizeof(float32));
+		memcpy(newInvIs, m_invIs, m_count * sizeof(float32));
+	}
+
+	m_allocator->Free(m_buffer, m_bufferSize);
+
+	m_buffer = buffer;
+	m_bufferSize = size;
+	m_maxBufferSize = b2Max(m_maxBufferSize, m_bufferSize);
+	m_capacity = capacity;
+
+	m_bodies = newBodies;
+	m_transforms = newTransforms;
+	m_sweeps = newSweeps;
+	m_linearVelocities = newLinearVelocities;
+	m_angularVelocities = newAngularVelocities;
+	m_forces = newForces;
+	m_torques = newTorques;
+	m_masses = newMasses;
+	m_invMasses = newInvMasses;
+	m_Is = newIs;
+	m_invIs = newInvIs;
+}
+
+int32 b2BodyStore::Add(b2Body* body)
+{
+	if (m_count == m_capacity)
+	{
+		Resize(m_capacity > 0 ? 2 * m_capacity : 64);
+	}
+
+	int32 index = m_count;
+	m_bodies[index] = body;
+	++m_count;
+	return index;
+}
+
+void b2BodyStore::Swap(int32 i, int32 j)
+{
+	if (i == j)
+	{
+		return;
+	}
+
+	b2Swap(m_bodies[i], m_bodies[j]);
+	b2Swap(m_transforms[i], m_transforms[j]);
+	b2Swap(m_sweeps[i], m_sweeps[j]);
+	b2Swap(m_linearVelocities[i], m_linearVelocities[j]);
+	b2Swap(m_angularVelocities[i], m_angularVelocities[j]);
+	b2Swap(m_forces[i], m_forces[j]);
+	b2Swap(m_torques[i], m_torques[j]);
+	b2Swap(m_masses[i], m_masses[j]);
+	b2Swap(m_invMasses[i], m_invMasses[j]);
+	b2Swap(m_Is[i], m_Is[j]);
+	b2Swap(m_invIs[i], m_invIs[j]);
+	m_bodies[i]->m_storeIndex = i;
+	m_bodies[j]->m_storeIndex = j;
+}
+
+void b2BodyStore::Remove(int32 index)
+{
+	b2Assert(0 <= index && index < m_count);
+
+	// Move the body to the end of its part, then move the last body into its slot.
+	if (index < m_awakeCount)
+	{
+		Swap(index, m_awakeCount - 1);
+		--m_awakeCount;
+		index = m_awakeCount;
+	}
+
+	Swap(index, m_count - 1);
+	--m_count;
+}
+
+void b2BodyStore::UpdateAwake(b2Body* body)
+{
+	int32 index = body->m_storeIndex;
+	b2Assert(0 <= index && index < m_count && m_bodies[index] == body);
+
+	bool awake = body->IsAwake() && body->m_type != b2_staticBody;
+	if (awake == (index < m_awakeCount))
+	{
+		return;
+	}
+
+	if (awake)
+	{
+		Swap(index, m_awakeCount);
+		++m_awakeCount;
+	}
+	else
+	{
+		Swap(index, m_awakeCount - 1);
+		--m_awakeCount;
+
+		// The TOI passes only touch awake bodies, so make sure this body
+		// does not carry a partial sweep into a later step.
+		m_sweeps[m_awakeCount].alpha0 = 0.0f;
+	}
+}
+
+void b2BodyStore::Compact()
+{
+	int32 capacity = 64;
+	while (capacity < m_count)
+	{
+		capacity *= 2;
+	}
+
+	if (capacity < m_capacity)
+	{
+		Resize(capacity);
+	}
+}
+
+int32 b2BodyStore::GetBytes() const
+{
+	return m_bufferSize;
+}
+
+int32 b2BodyStore::GetPeakBytes() const
+{
+	return m_maxBufferSize;
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_BODY_STORE_H
+#define B2_BODY_STORE_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Common/b2Allocator.h>
+
+class b2Body;
+
+/// The state the solver touches every step, stored in parallel arrays
+/// indexed by body. The world owns one of these and b2Body reads and writes
+/// through it, so per-body passes run over packed arrays instead of pulling
+/// whole bodies through the cache.
+/// The bodies that are awake and not static are kept at the front, so the
+/// per-step passes only touch [0, m_awakeCount). Indices change when a body
+/// is removed, falls asleep or wakes up.
+class b2BodyStore
+{
+public:
+	b2BodyStore(b2Allocator* allocator);
+	~b2BodyStore();
+
+	/// Add a body and return its index. The state is not initialized.
+	int32 Add(b2Body* body);
+
+	/// Remove the body at an index.
+	void Remove(int32 index);
+
+	/// Move a body into or out of the awake part to match its flags and type.
+	/// A body leaving the awake part has its sweep reset to the start of the step.
+	void UpdateAwake(b2Body* body);
+
+	/// Shrink the arrays to fit the bodies.
+	void Compact();
+
+	/// Get the heap bytes held by the arrays.
+	int32 GetBytes() const;
+
+	/// Get the largest value GetBytes has reached.
+	int32 GetPeakBytes() const;
+
+	b2Body** m_bodies;
+	b2Transform* m_transforms;
+	b2Sweep* m_sweeps;
+	b2Vec2* m_linearVelocities;
+	float32* m_angularVelocities;
+	b2Vec2* m_forces;
+	float32* m_torques;
+	float32* m_masses;
+	float32* m_invMasses;
+	float32* m_Is;
+	float32* m_invIs;
+
+	int32 m_count;
+	int32 m_awakeCount;
+	int32 m_capacity;
+
+private:
+
+	void Resize(int32 capacity);
+	void Swap(int32 i, int32 j);
+
+	b2Allocator* m_allocator;
+	void* m_buffer;
+	int32 m_bufferSize;
+	int32 m_maxBufferSize;
+};
+
+#endif
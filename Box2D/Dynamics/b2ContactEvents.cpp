@@ -0,0 +1,133 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/b2ContactEvents.h>
+#include <Box2D/Dynamics/b2SensorManager.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Common/b2Allocator.h>
+#include <cstring>
+using namespace std;
+
+b2ContactEventBuffer::b2ContactEventBuffer(int32 capacity, b2Allocator* allocator)
+{
+	b2Assert(capacity > 0);
+	m_allocator = allocator ? allocator : b2GetDefaultAllocator();
+
+	m_beginCount = 0;
+	m_beginCapacity = capacity;
+	m_beginEvents = (b2ContactTouchEvent*)m_allocator->Allocate(capacity * sizeof(b2ContactTouchEvent));
+
+	m_endCount = 0;
+	m_endCapacity = capacity;
+	m_endEvents = (b2ContactTouchEvent*)m_allocator->Allocate(capacity * sizeof(b2ContactTouchEvent));
+
+	m_overlapBeginCount = 0;
+	m_overlapBeginCapacity = capacity;
+	m_overlapBeginEvents = (b2ContactTouchEvent*)m_allocator->Allocate(capacity * sizeof(b2ContactTouchEvent));
+
+	m_overlapEndCount = 0;
+	m_overlapEndCapacity = capacity;
+	m_overlapEndEvents = (b2ContactTouchEvent*)m_allocator->Allocate(capacity * sizeof(b2ContactTouchEvent));
+
+	m_impactCount = 0;
+	m_impactCapacity = capacity;
+	m_impactEvents = (b2ContactImpactEvent*)m_allocator->Allocate(capacity * sizeof(b2ContactImpactEvent));
+
+	m_impactThreshold = b2_maxFloat;
+}
+
+b2ContactEventBuffer::~b2ContactEventBuffer()
+{
+	m_allocator->Free(m_beginEvents, m_beginCapacity * sizeof(b2ContactTouchEvent));
+	m_allocator->Free(m_endEvents, m_endCapacity * sizeof(b2ContactTouchEvent));
+	m_allocator->Free(m_overlapBeginEvents, m_overlapBeginCapacity * sizeof(b2ContactTouchEvent));
+	m_allocator->Free(m_overlapEndEvents, m_overlapEndCapacity * sizeof(b2ContactTouchEvent));
+	m_allocator->Free(m_impactEvents, m_impactCapacity * sizeof(b2ContactImpactEvent));
+}
+
+void b2ContactEventBuffer::Clear()
+{
+	m_beginCount = 0;
+	m_endCount = 0;
+	m_overlapBeginCount = 0;
+	m_overlapEndCount = 0;
+	m_impactCount = 0;
+}
+
+template <typename T>
+T* b2ContactEventBuffer::Push(T*& array, int32& count, int32& capacity)
+{
+	if (count == capacity)
+	{
+		T* oldArray = array;
+		int32 oldCapacity = capacity;
+		capacity *= 2;
+		array = (T*)m_allocator->Allocate(capacity * sizeof(T));
+		memcpy(array, oldArray, count * sizeof(T));
+		m_allocator->Free(oldArray, oldCapacity * sizeof(T));
+	}
+
+	return array + count++;
+}
+
+void b2ContactEventBuffer::AddBegin(const b2Contact* contact)
+{
+	b2ContactTouchEvent* e = Push(m_beginEvents, m_beginCount, m_beginCapacity);
+	e->fixtureA = contact->m_fixtureA;
+	e->fixtureB = contact->m_fixtureB;
+	e->indexA = contact->m_indexA;
+	e->indexB = contact->m_indexB;
+}
+
+void b2ContactEventBuffer::AddEnd(const b2Contact* contact)
+{
+	b2ContactTouchEvent* e = Push(m_endEvents, m_endCount, m_endCapacity);
+	e->fixtureA = contact->m_fixtureA;
+	e->fixtureB = contact->m_fixtureB;
+	e->indexA = contact->m_indexA;
+	e->indexB = contact->m_indexB;
+}
+
+void b2ContactEventBuffer::AddOverlapBegin(const b2SensorPair* pair)
+{
+	b2ContactTouchEvent* e = Push(m_overlapBeginEvents, m_overlapBeginCount, m_overlapBeginCapacity);
+	e->fixtureA = pair->fixtureA;
+	e->fixtureB = pair->fixtureB;
+	e->indexA = pair->indexA;
+	e->indexB = pair->indexB;
+}
+
+void b2ContactEventBuffer::AddOverlapEnd(const b2SensorPair* pair)
+{
+	b2ContactTouchEvent* e = Push(m_overlapEndEvents, m_overlapEndCount, m_overlapEndCapacity);
+	e->fixtureA = pair->fixtureA;
+	e->fixtureB = pair->fixtureB;
+	e->indexA = pair->indexA;
+	e->indexB = pair->indexB;
+}
+
+void b2ContactEventBuffer::AddImpact(const b2Contact* contact, const b2Vec2& point, const b2Vec2& normal, float32 maxImpulse)
+{
+	b2ContactImpactEvent* e = Push(m_impactEvents, m_impactCount, m_impactCapacity);
+	e->fixtureA = contact->m_fixtureA;
+	e->fixtureB = contact->m_fixtureB;
+	e->point = point;
+	e->normal = normal;
+	e->maxImpulse = maxImpulse;
+}
@@ -0,0 +1,196 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_CONTACT_EVENTS_H
+#define B2_CONTACT_EVENTS_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Allocator;
+class b2Contact;
+class b2Fixture;
+struct b2SensorPair;
+
+/// Recorded when two fixtures begin or cease to touch, or when a sensor
+/// begins or ceases to overlap another fixture.
+struct b2ContactTouchEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	int32 indexA;		///< the child index of fixture A
+	int32 indexB;		///< the child index of fixture B
+};
+
+/// Recorded after the solver for a touching contact that took a large enough impulse.
+struct b2ContactImpactEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	b2Vec2 point;		///< the world point that took the largest normal impulse
+	b2Vec2 normal;		///< the world normal, pointing from A to B
+	float32 maxImpulse;	///< the largest normal impulse of the contact points
+};
+
+/// A contact event buffer collects contact and sensor events during b2World::Step as plain
+/// records instead of calling b2ContactListener from inside the step. Register
+/// it with b2World::SetContactEventBuffer and read the records after the step.
+/// The records accumulate until you call Clear. The arrays are allocated up
+/// front and only grow when a step produces more events than they hold.
+/// A buffer does not replace the listener. Set the listener to NULL to skip the
+/// virtual calls; PreSolve is only available through the listener.
+/// @warning the fixture pointers of an end event recorded by b2World::DestroyBody
+/// or b2World::DestroyFixture refer to destroyed fixtures. Only compare them.
+class b2ContactEventBuffer
+{
+public:
+	/// @param capacity the number of records of each kind to allocate up front.
+	/// @param allocator the heap for the arrays. NULL means the default allocator.
+	b2ContactEventBuffer(int32 capacity = 256, b2Allocator* allocator = NULL);
+	~b2ContactEventBuffer();
+
+	/// Impact events are recorded for contacts whose largest normal impulse
+	/// exceeds this value. Resting contacts carry an impulse every step, so no
+	/// impacts are recorded until a threshold is set. The default is b2_maxFloat.
+	void SetImpactThreshold(float32 impulse);
+	float32 GetImpactThreshold() const;
+
+	/// Get the fixture pairs that began to touch.
+	const b2ContactTouchEvent* GetBeginEvents() const;
+	int32 GetBeginEventCount() const;
+
+	/// Get the fixture pairs that ceased to touch.
+	const b2ContactTouchEvent* GetEndEvents() const;
+	int32 GetEndEventCount() const;
+
+	/// Get the sensor pairs that began to overlap.
+	const b2ContactTouchEvent* GetOverlapBeginEvents() const;
+	int32 GetOverlapBeginEventCount() const;
+
+	/// Get the sensor pairs that ceased to overlap.
+	const b2ContactTouchEvent* GetOverlapEndEvents() const;
+	int32 GetOverlapEndEventCount() const;
+
+	/// Get the impacts.
+	const b2ContactImpactEvent* GetImpactEvents() const;
+	int32 GetImpactEventCount() const;
+
+	/// Remove all records. The memory is kept.
+	void Clear();
+
+private:
+	friend class b2Contact;
+	friend class b2ContactManager;
+	friend class b2Island;
+	friend class b2SensorManager;
+
+	void AddBegin(const b2Contact* contact);
+	void AddEnd(const b2Contact* contact);
+	void AddOverlapBegin(const b2SensorPair* pair);
+	void AddOverlapEnd(const b2SensorPair* pair);
+	void AddImpact(const b2Contact* contact, const b2Vec2& point, const b2Vec2& normal, float32 maxImpulse);
+
+	template <typename T>
+	T* Push(T*& array, int32& count, int32& capacity);
+
+	b2Allocator* m_allocator;
+
+	b2ContactTouchEvent* m_beginEvents;
+	int32 m_beginCount;
+	int32 m_beginCapacity;
+
+	b2ContactTouchEvent* m_endEvents;
+	int32 m_endCount;
+	int32 m_endCapacity;
+
+	b2ContactTouchEvent* m_overlapBeginEvents;
+	int32 m_overlapBeginCount;
+	int32 m_overlapBeginCapacity;
+
+	b2ContactTouchEvent* m_overlapEndEvents;
+	int32 m_overlapEndCount;
+	int32 m_overlapEndCapacity;
+
+	b2ContactImpactEvent* m_impactEvents;
+	int32 m_impactCount;
+	int32 m_impactCapacity;
+
+	float32 m_impactThreshold;
+};
+
+inline void b2ContactEventBuffer::SetImpactThreshold(float32 impulse)
+{
+	m_impactThreshold = impulse;
+}
+
+inline float32 b2ContactEventBuffer::GetImpactThreshold() const
+{
+	return m_impactThreshold;
+}
+
+inline const b2ContactTouchEvent* b2ContactEventBuffer::GetBeginEvents() const
+{
+	return m_beginEvents;
+}
+
+inline int32 b2ContactEventBuffer::GetBeginEventCount() const
+{
+	return m_beginCount;
+}
+
+inline const b2ContactTouchEvent* b2ContactEventBuffer::GetEndEvents() const
+{
+	return m_endEvents;
+}
+
+inline int32 b2ContactEventBuffer::GetEndEventCount() const
+{
+	return m_endCount;
+}
+
+inline const b2ContactTouchEvent* b2ContactEventBuffer::GetOverlapBeginEvents() const
+{
+	return m_overlapBeginEvents;
+}
+
+inline int32 b2ContactEventBuffer::GetOverlapBeginEventCount() const
+{
+	return m_overlapBeginCount;
+}
+
+inline const b2ContactTouchEvent* b2ContactEventBuffer::GetOverlapEndEvents() const
+{
+	return m_overlapEndEvents;
+}
+
+inline int32 b2ContactEventBuffer::GetOverlapEndEventCount() const
+{
+	return m_overlapEndCount;
+}
+
+inline const b2ContactImpactEvent* b2ContactEventBuffer::GetImpactEvents() const
+{
+	return m_impactEvents;
+}
+
+inline int32 b2ContactEventBuffer::GetImpactEventCount() const
+{
+	return m_impactCount;
+}
+
+#endif
@@ -18,20 +18,139 @@
 
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactEvents.h>
+#include <Box2D/Dynamics/b2SensorManager.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
+#include <Box2D/Dynamics/b2IslandManager.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <cstring>
+using namespace std;
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
-b2ContactManager::b2ContactManager()
+b2ContactManager::b2ContactManager(b2Allocator* allocator) : m_broadPhase(allocator)
 {
-	m_contactList = NULL;
+	m_heapAllocator = allocator ? allocator : b2GetDefaultAllocator();
+	m_contactCapacity = 64;
+	m_maxContactCapacity = m_contactCapacity;
 	m_contactCount = 0;
+	m_awakeContactCount = 0;
+	m_contacts = (b2Contact**)m_heapAllocator->Allocate(m_contactCapacity * sizeof(b2Contact*));
+	m_contactKeys = (b2ContactKey*)m_heapAllocator->Allocate(m_contactCapacity * sizeof(b2ContactKey));
+	m_updateContacts = (b2Contact**)m_heapAllocator->Allocate(m_contactCapacity * sizeof(b2Contact*));
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
+	m_contactEvents = NULL;
 	m_allocator = NULL;
+	m_islandManager = NULL;
+	m_sensorManager = NULL;
+	m_contactUpdateCount = 0;
+	m_manifoldReuseCount = 0;
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	// The contacts themselves live in the block allocator.
+	m_heapAllocator->Free(m_updateContacts, m_contactCapacity * sizeof(b2Contact*));
+	m_heapAllocator->Free(m_contactKeys, m_contactCapacity * sizeof(b2ContactKey));
+	m_heapAllocator->Free(m_contacts, m_contactCapacity * sizeof(b2Contact*));
+}
+
+void b2ContactManager::ResizeContacts(int32 capacity)
+{
+	b2Assert(capacity >= m_contactCount);
+	b2Contact** oldContacts = m_contacts;
+	int32 oldCapacity = m_contactCapacity;
+	m_contactCapacity = capacity;
+	m_maxContactCapacity = b2Max(m_maxContactCapacity, m_contactCapacity);
+	m_contacts = (b2Contact**)m_heapAllocator->Allocate(m_contactCapacity * sizeof(b2Contact*));
+	memcpy(m_contacts, oldContacts, m_contactCount * sizeof(b2Contact*));
+	m_heapAllocator->Free(oldContacts, oldCapacity * sizeof(b2Contact*));
+
+	b2ContactKey* oldKeys = m_contactKeys;
+	m_contactKeys = (b2ContactKey*)m_heapAllocator->Allocate(m_contactCapacity * sizeof(b2ContactKey));
+	memcpy(m_contactKeys, oldKeys, m_contactCount * sizeof(b2ContactKey));
+	m_heapAllocator->Free(oldKeys, oldCapacity * sizeof(b2ContactKey));
+
+	// The update buffer only holds contacts during Collide.
+	m_heapAllocator->Free(m_updateContacts, oldCapacity * sizeof(b2Contact*));
+	m_updateContacts = (b2Contact**)m_heapAllocator->Allocate(m_contactCapacity * sizeof(b2Contact*));
+}
+
+void b2ContactManager::SwapContacts(int32 i, int32 j)
+{
+	b2Contact* ci = m_contacts[i];
+	b2Contact* cj = m_contacts[j];
+	m_contacts[i] = cj;
+	m_contacts[j] = ci;
+	cj->m_managerIndex = i;
+	ci->m_managerIndex = j;
+
+	b2ContactKey key = m_contactKeys[i];
+	m_contactKeys[i] = m_contactKeys[j];
+	m_contactKeys[j] = key;
+}
+
+void b2ContactManager::UpdateAwakeContact(b2Contact* c)
+{
+	int32 index = c->m_managerIndex;
+	b2Assert(0 <= index && index < m_contactCount && m_contacts[index] == c);
+
+	// Collide needs to visit the contact if a body is active or the
+	// contact must be filtered.
+	const b2Body* bodyA = c->m_fixtureA->m_body;
+	const b2Body* bodyB = c->m_fixtureB->m_body;
+	bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+	bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+	bool filter = (c->m_flags & b2Contact::e_filterFlag) == b2Contact::e_filterFlag;
+
+	bool awake = index < m_awakeContactCount;
+	if ((activeA || activeB || filter) == awake)
+	{
+		return;
+	}
+
+	if (awake)
+	{
+		SwapContacts(index, m_awakeContactCount - 1);
+		--m_awakeContactCount;
+	}
+	else
+	{
+		SwapContacts(index, m_awakeContactCount);
+		++m_awakeContactCount;
+
+		// Sleeping contacts are skipped by the TOI passes, so their cached
+		// TOI is stale.
+		c->m_flags &= ~b2Contact::e_toiFlag;
+		c->m_toiCount = 0;
+		c->m_toi = 1.0f;
+	}
+}
+
+void b2ContactManager::FlagForFiltering(b2Contact* c)
+{
+	c->m_flags |= b2Contact::e_filterFlag;
+	m_contactKeys[c->m_managerIndex].filter = true;
+
+	// Filtering happens in Collide, which only visits awake contacts.
+	UpdateAwakeContact(c);
+}
+
+void b2ContactManager::Compact()
+{
+	int32 capacity = 64;
+	while (capacity < m_contactCount)
+	{
+		capacity *= 2;
+	}
+
+	if (capacity < m_contactCapacity)
+	{
+		ResizeContacts(capacity);
+	}
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -41,26 +160,33 @@ void b2ContactManager::Destroy(b2Contact* c)
 	b2Body* bodyA = fixtureA->GetBody();
 	b2Body* bodyB = fixtureB->GetBody();
 
-	if (m_contactListener && c->IsTouching())
+	if (m_contactEvents && c->IsTouching())
 	{
-		m_contactListener->EndContact(c);
+		m_contactEvents->AddEnd(c);
 	}
 
-	// Remove from the world.
-	if (c->m_prev)
+	if (m_contactListener && c->IsTouching())
 	{
-		c->m_prev->m_next = c->m_next;
+		m_contactListener->EndContact(c);
 	}
 
-	if (c->m_next)
-	{
-		c->m_next->m_prev = c->m_prev;
-	}
+	m_islandManager->UnlinkContact(c);
 
-	if (c == m_contactList)
+	// Remove from the world. Move the contact to the end of its part of the
+	// array, then move the last contact into its slot.
+	int32 index = c->m_managerIndex;
+	b2Assert(0 <= index && index < m_contactCount && m_contacts[index] == c);
+	if (index < m_awakeContactCount)
 	{
-		m_contactList = c->m_next;
+		SwapContacts(index, m_awakeContactCount - 1);
+		--m_awakeContactCount;
+		index = m_awakeContactCount;
 	}
+	b2Contact* last = m_contacts[m_contactCount - 1];
+	m_contacts[index] = last;
+	m_contactKeys[index] = m_contactKeys[m_contactCount - 1];
+	last->m_managerIndex = index;
+	c->m_managerIndex = b2_nullContactIndex;
 
 	// Remove from body 1
 	if (c->m_nodeA.prev)
@@ -102,71 +228,123 @@ void b2ContactManager::Destroy(b2Contact* c)
 // This is the top level collision call for the time step. Here
 // all the narrow phase collision is processed for the world
 // contact list.
+// The shape pair type of a contact indexes the contact registers.
+inline int32 b2GetContactType(const b2Contact* c)
+{
+	return c->GetFixtureA()->GetType() * b2Shape::e_typeCount + c->GetFixtureB()->GetType();
+}
+
 void b2ContactManager::Collide()
 {
-	// Update awake contacts.
-	b2Contact* c = m_contactList;
-	while (c)
+	const int32 typeCount = b2Shape::e_typeCount * b2Shape::e_typeCount;
+	int32 counts[typeCount];
+	memset(counts, 0, sizeof(counts));
+	m_manifoldReuseCount = 0;
+
+	// Filter the awake contacts and keep the ones that persist. Destroying a
+	// contact or putting it to sleep moves another awake contact into the
+	// current slot, so the index only advances past contacts that stay awake.
+	b2ContactKey* keys = m_contactKeys;
+	int32 i = 0;
+	while (i < m_awakeContactCount)
 	{
-		b2Fixture* fixtureA = c->GetFixtureA();
-		b2Fixture* fixtureB = c->GetFixtureB();
-		int32 indexA = c->GetChildIndexA();
-		int32 indexB = c->GetChildIndexB();
-		b2Body* bodyA = fixtureA->GetBody();
-		b2Body* bodyB = fixtureB->GetBody();
-		 
+		b2ContactKey key = keys[i];
+
 		// Is this contact flagged for filtering?
-		if (c->m_flags & b2Contact::e_filterFlag)
+		if (key.filter)
 		{
+			b2Contact* c = m_contacts[i];
+			b2Fixture* fixtureA = c->GetFixtureA();
+			b2Fixture* fixtureB = c->GetFixtureB();
+			b2Body* bodyA = fixtureA->GetBody();
+			b2Body* bodyB = fixtureB->GetBody();
+
+			// A fixture became a sensor. The broad-phase creates a sensor
+			// pair for the proxies instead.
+			if (fixtureA->IsSensor() || fixtureB->IsSensor())
+			{
+				Destroy(c);
+				continue;
+			}
+
 			// Should these bodies collide?
 			if (bodyB->ShouldCollide(bodyA) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
 			// Check user filtering.
 			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
 			// Clear the filtering flag.
 			c->m_flags &= ~b2Contact::e_filterFlag;
+			keys[i].filter = false;
+
+			// At least one body must be awake and it must be dynamic or kinematic.
+			// Contacts that are not flagged for filtering leave the awake part as
+			// soon as their bodies stop being active.
+			bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+			bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+			if (activeA == false && activeB == false)
+			{
+				UpdateAwakeContact(c);
+				continue;
+			}
 		}
 
-		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
-		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+		bool overlap = m_broadPhase.TestOverlap(key.proxyIdA, key.proxyIdB);
 
-		// At least one body must be awake and it must be dynamic or kinematic.
-		if (activeA == false && activeB == false)
+		// Here we destroy contacts that cease to overlap in the broad-phase.
+		if (overlap == false)
 		{
-			c = c->GetNext();
+			Destroy(m_contacts[i]);
 			continue;
 		}
 
-		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
-		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
-		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		// The contact persists.
+		++counts[key.type];
+		++i;
+	}
 
-		// Here we destroy contacts that cease to overlap in the broad-phase.
-		if (overlap == false)
+	// The persisting contacts are now the awake contacts. Group them by
+	// shape pair type with a counting sort.
+	int32 updateCount = m_awakeContactCount;
+	int32 starts[typeCount];
+	int32 next[typeCount];
+	int32 offset = 0;
+	for (int32 type = 0; type < typeCount; ++type)
+	{
+		starts[type] = offset;
+		next[type] = offset;
+		offset += counts[type];
+	}
+
+	for (int32 j = 0; j < updateCount; ++j)
+	{
+		m_updateContacts[next[keys[j].type]++] = m_contacts[j];
+	}
+
+	// Run each group through the collider of its type. The contacts in a group
+	// share the same code path, which keeps the branches and the instruction
+	// cache warm.
+	for (int32 type = 0; type < typeCount; ++type)
+	{
+		if (counts[type] == 0)
 		{
-			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
-			Destroy(cNuke);
 			continue;
 		}
 
-		// The contact persists.
-		c->Update(m_contactListener);
-		c = c->GetNext();
+		const b2ContactRegister& reg = b2Contact::s_registers[type / b2Shape::e_typeCount][type % b2Shape::e_typeCount];
+		b2Assert(reg.primary);
+		m_manifoldReuseCount += reg.updateFcn(m_updateContacts + starts[type], counts[type], m_contactListener, m_contactEvents);
 	}
+
+	m_contactUpdateCount = updateCount;
 }
 
 void b2ContactManager::FindNewContacts()
@@ -194,6 +372,13 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	// Sensors don't create contacts.
+	if (fixtureA->IsSensor() || fixtureB->IsSensor())
+	{
+		m_sensorManager->AddPair(proxyA, proxyB);
+		return;
+	}
+
 	// TODO_ERIN use a hash table to remove a potential bottleneck when both
 	// bodies have a lot of contacts.
 	// Does a contact already exist?
@@ -251,13 +436,18 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	bodyB = fixtureB->GetBody();
 
 	// Insert into the world.
-	c->m_prev = NULL;
-	c->m_next = m_contactList;
-	if (m_contactList != NULL)
+	if (m_contactCount == m_contactCapacity)
 	{
-		m_contactList->m_prev = c;
+		ResizeContacts(2 * m_contactCapacity);
 	}
-	m_contactList = c;
+	c->m_managerIndex = m_contactCount;
+	m_contacts[m_contactCount] = c;
+
+	b2ContactKey* key = m_contactKeys + m_contactCount;
+	key->proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+	key->proxyIdB = fixtureB->m_proxies[indexB].proxyId;
+	key->type = b2GetContactType(c);
+	key->filter = false;
 
 	// Connect to island graph.
 
@@ -285,9 +475,11 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 	bodyB->m_contactList = &c->m_nodeB;
 
+	++m_contactCount;
+
 	// Wake up the bodies
 	bodyA->SetAwake(true);
 	bodyB->SetAwake(true);
 
-	++m_contactCount;
+	UpdateAwakeContact(c);
 }
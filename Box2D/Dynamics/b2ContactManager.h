@@ -24,13 +24,40 @@
 class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
-class b2BlockAllocator;
+class b2ContactEventBuffer;
+class b2Allocator;
+class b2IslandManager;
+class b2SensorManager;
 
 // Delegate of b2World.
+// Broad-phase pairs with a sensor fixture are handed to the sensor manager.
+// The contacts are kept in a dense array. A contact pointer is a stable
+// handle, while the array index of a contact changes when another contact
+// is destroyed (the last contact is moved into the hole).
+// The array is split in two. The first m_awakeContactCount contacts have
+// at least one awake, non-static body or are flagged for filtering. Only
+// these are visited by Collide. Contacts move across the split when their
+// bodies fall asleep, wake up or change type.
+// Collide groups the contacts it updates by shape pair type, so that each
+// collider runs over a batch of contacts. A contact whose bodies kept their
+// relative transform keeps its manifold instead of running the collider.
+// The proxies, type and filter flag of each contact are copied into a key
+// array parallel to the contact array. The filter, overlap and grouping
+// passes of Collide only read the keys. Only the narrow phase touches the
+// contacts themselves.
+struct b2ContactKey
+{
+	int32 proxyIdA;
+	int32 proxyIdB;
+	int32 type;
+	bool filter;
+};
+
 class b2ContactManager
 {
 public:
-	b2ContactManager();
+	b2ContactManager(b2Allocator* allocator = NULL);
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -40,13 +67,40 @@ public:
 	void Destroy(b2Contact* c);
 
 	void Collide();
-            
+
+	// Move a contact into or out of the awake set to match its bodies.
+	void UpdateAwakeContact(b2Contact* c);
+
+	// Flag a contact for filtering in the next Collide.
+	void FlagForFiltering(b2Contact* c);
+
+	// Shrink the contact array to fit.
+	void Compact();
+
 	b2BroadPhase m_broadPhase;
-	b2Contact* m_contactList;
+	b2Contact** m_contacts;
+	b2ContactKey* m_contactKeys;
+	b2Contact** m_updateContacts;
 	int32 m_contactCount;
+	int32 m_awakeContactCount;
+	int32 m_contactCapacity;
+	int32 m_maxContactCapacity;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
-	b2BlockAllocator* m_allocator;
+	b2ContactEventBuffer* m_contactEvents;
+	b2Allocator* m_allocator;
+	b2IslandManager* m_islandManager;
+	b2SensorManager* m_sensorManager;
+	b2Allocator* m_heapAllocator;
+
+	// Narrow phase statistics of the last Collide.
+	int32 m_contactUpdateCount;
+	int32 m_manifoldReuseCount;
+
+private:
+
+	void ResizeContacts(int32 capacity);
+	void SwapContacts(int32 i, int32 j);
 };
 
 #endif
@@ -36,6 +36,7 @@ b2Fixture::b2Fixture()
 	m_proxyCount = 0;
 	m_shape = NULL;
 	m_density = 0.0f;
+	m_sensorList = NULL;
 }
 
 void b2Fixture::Create(b2BlockAllocator* allocator, b2Body* body, const b2FixtureDef* def)
@@ -50,6 +51,7 @@ void b2Fixture::Create(b2BlockAllocator* allocator, b2Body* body, const b2Fixtur
 	m_filter = def->filter;
 
 	m_isSensor = def->isSensor;
+	m_sensorList = NULL;
 
 	m_shape = def->shape->Clone(allocator);
 
@@ -209,6 +211,8 @@ void b2Fixture::Refilter()
 		return;
 	}
 
+	world->m_sensorManager.FlagForFiltering(this);
+
 	// Touch each proxy so that new pairs may be created
 	b2BroadPhase* broadPhase = &world->m_contactManager.m_broadPhase;
 	for (int32 i = 0; i < m_proxyCount; ++i)
@@ -223,6 +227,10 @@ void b2Fixture::SetSensor(bool sensor)
 	{
 		m_body->SetAwake(true);
 		m_isSensor = sensor;
+
+		// Filtering destroys the contacts or sensor pairs of the old kind.
+		// Touching the proxies creates the pairs of the new kind.
+		Refilter();
 	}
 }
 
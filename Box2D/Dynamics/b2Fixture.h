@@ -27,6 +27,7 @@ class b2BlockAllocator;
 class b2Body;
 class b2BroadPhase;
 class b2Fixture;
+struct b2SensorEdge;
 
 /// This holds contact filtering data.
 struct b2Filter
@@ -117,7 +118,9 @@ public:
 	b2Shape* GetShape();
 	const b2Shape* GetShape() const;
 
-	/// Set if this fixture is a sensor.
+	/// Set if this fixture is a sensor. Sensors don't create contacts. Their overlaps
+	/// are reported through b2ContactListener::BeginOverlap and EndOverlap.
+	/// The contacts or sensor pairs of this fixture are replaced in the next time step.
 	void SetSensor(bool sensor);
 
 	/// Is this fixture a sensor (non-solid)?
@@ -201,6 +204,7 @@ protected:
 	friend class b2World;
 	friend class b2Contact;
 	friend class b2ContactManager;
+	friend class b2SensorManager;
 
 	b2Fixture();
 
@@ -232,6 +236,9 @@ protected:
 
 	bool m_isSensor;
 
+	// The sensor pairs of this fixture.
+	b2SensorEdge* m_sensorList;
+
 	void* m_userData;
 };
 
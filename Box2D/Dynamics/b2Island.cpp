@@ -19,11 +19,14 @@
 #include <Box2D/Collision/b2Distance.h>
 #include <Box2D/Dynamics/b2Island.h>
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactEvents.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Dynamics/Joints/b2JointBatchSolver.h>
+#include <Box2D/Dynamics/Joints/b2JointTreeSolver.h>
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Timer.h>
 
@@ -150,7 +153,8 @@ b2Island::b2Island(
 	int32 contactCapacity,
 	int32 jointCapacity,
 	b2StackAllocator* allocator,
-	b2ContactListener* listener)
+	b2ContactListener* listener,
+	b2ContactEventBuffer* events)
 {
 	m_bodyCapacity = bodyCapacity;
 	m_contactCapacity = contactCapacity;
@@ -158,13 +162,17 @@ b2Island::b2Island(
 	m_bodyCount = 0;
 	m_contactCount = 0;
 	m_jointCount = 0;
+	m_maxSleepMotion = b2_maxFloat;
+	m_minSleepMotion = b2_maxFloat;
 
 	m_allocator = allocator;
 	m_listener = listener;
+	m_events = events;
 
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
 	m_joints = (b2Joint**)m_allocator->Allocate(jointCapacity * sizeof(b2Joint*));
+	m_storeIndices = (int32*)m_allocator->Allocate(m_bodyCapacity * sizeof(int32));
 
 	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
 	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
@@ -175,6 +183,7 @@ b2Island::~b2Island()
 	// Warning: the order should reverse the constructor order.
 	m_allocator->Free(m_positions);
 	m_allocator->Free(m_velocities);
+	m_allocator->Free(m_storeIndices);
 	m_allocator->Free(m_joints);
 	m_allocator->Free(m_contacts);
 	m_allocator->Free(m_bodies);
@@ -186,25 +195,41 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 	float32 h = step.dt;
 
+	// The body state lives in the world's body store. Look up the store
+	// indices once so the loops below read the state arrays directly.
+	b2BodyStore* store = m_bodies[0]->m_store;
+	b2Sweep* sweeps = store->m_sweeps;
+	b2Transform* transforms = store->m_transforms;
+	b2Vec2* linearVelocities = store->m_linearVelocities;
+	float32* angularVelocities = store->m_angularVelocities;
+	int32* indices = m_storeIndices;
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		indices[i] = m_bodies[i]->m_storeIndex;
+	}
+
 	// Integrate velocities and apply damping. Initialize the body state.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
+		int32 index = indices[i];
+		b2Sweep& sweep = sweeps[index];
 
-		b2Vec2 c = b->m_sweep.c;
-		float32 a = b->m_sweep.a;
-		b2Vec2 v = b->m_linearVelocity;
-		float32 w = b->m_angularVelocity;
+		b2Vec2 c = sweep.c;
+		float32 a = sweep.a;
+		b2Vec2 v = linearVelocities[index];
+		float32 w = angularVelocities[index];
 
 		// Store positions for continuous collision.
-		b->m_sweep.c0 = b->m_sweep.c;
-		b->m_sweep.a0 = b->m_sweep.a;
+		sweep.c0 = c;
+		sweep.a0 = a;
 
-		if (b->m_type == b2_dynamicBody)
+		// The soft step solver integrates the velocities in each sub-step.
+		if (b->m_type == b2_dynamicBody && step.subStepCount == 0)
 		{
 			// Integrate velocities.
-			v += h * (b->m_gravityScale * gravity + b->m_invMass * b->m_force);
-			w += h * b->m_invI * b->m_torque;
+			v += h * (b->m_gravityScale * gravity + store->m_invMasses[index] * store->m_forces[index]);
+			w += h * store->m_invIs[index] * store->m_torques[index];
 
 			// Apply damping.
 			// ODE: dv/dt + c * v = 0
@@ -241,80 +266,165 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	contactSolverDef.allocator = m_allocator;
 
 	b2ContactSolver contactSolver(&contactSolverDef);
-	contactSolver.InitializeVelocityConstraints();
 
-	if (step.warmStarting)
+	bool positionSolved;
+	if (step.subStepCount > 0)
 	{
-		contactSolver.WarmStart();
+		positionSolved = SolveSubSteps(profile, step, gravity, &contactSolver, &solverData);
 	}
-	
-	for (int32 i = 0; i < m_jointCount; ++i)
+	else
 	{
-		m_joints[i]->InitVelocityConstraints(solverData);
+		positionSolved = SolveIterations(profile, step, &contactSolver, &solverData);
 	}
 
-	profile->solveInit = timer.GetMilliseconds();
+	// Copy state buffers back to the bodies. Measure the motion of the bodies
+	// on the way, the caller decides whether the island goes to sleep.
+	const float32 invLinTolSqr = 1.0f / (b2_linearSleepTolerance * b2_linearSleepTolerance);
+	const float32 invAngTolSqr = 1.0f / (b2_angularSleepTolerance * b2_angularSleepTolerance);
+	float32 maxMotion = 0.0f;
+	float32 minMotion = b2_maxFloat;
 
-	// Solve velocity constraints
-	timer.Reset();
-	for (int32 i = 0; i < step.velocityIterations; ++i)
+	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
+		b2Body* body = m_bodies[i];
+		int32 index = indices[i];
+		b2Sweep& sweep = sweeps[index];
+		b2Vec2 v = m_velocities[i].v;
+		float32 w = m_velocities[i].w;
+		sweep.c = m_positions[i].c;
+		sweep.a = m_positions[i].a;
+		linearVelocities[index] = v;
+		angularVelocities[index] = w;
+
+		b2Transform& xf = transforms[index];
+		xf.q.Set(sweep.a);
+		xf.p = sweep.c - b2Mul(xf.q, sweep.localCenter);
+
+		if (body->m_type == b2_staticBody)
 		{
-			m_joints[j]->SolveVelocityConstraints(solverData);
+			continue;
 		}
 
-		contactSolver.SolveVelocityConstraints();
+		float32 motion = b2Max(invLinTolSqr * b2Dot(v, v), invAngTolSqr * w * w);
+		if ((body->m_flags & b2Body::e_autoSleepFlag) == 0)
+		{
+			motion = b2_maxFloat;
+		}
+
+		maxMotion = b2Max(maxMotion, motion);
+		minMotion = b2Min(minMotion, motion);
 	}
 
-	// Store impulses for warm starting
-	contactSolver.StoreImpulses();
-	profile->solveVelocity = timer.GetMilliseconds();
+	Report(contactSolver.m_velocityConstraints);
 
-	// Integrate positions
-	for (int32 i = 0; i < m_bodyCount; ++i)
+	m_maxSleepMotion = b2_maxFloat;
+	m_minSleepMotion = b2_maxFloat;
+
+	if (allowSleep)
 	{
-		b2Vec2 c = m_positions[i].c;
-		float32 a = m_positions[i].a;
-		b2Vec2 v = m_velocities[i].v;
-		float32 w = m_velocities[i].w;
+		if (positionSolved)
+		{
+			m_maxSleepMotion = maxMotion;
+		}
+		m_minSleepMotion = minMotion;
+	}
+}
 
-		// Check for large velocities
-		b2Vec2 translation = h * v;
-		if (b2Dot(translation, translation) > b2_maxTranslationSquared)
+// The sequential impulse solver: velocity iterations followed by position iterations.
+bool b2Island::SolveIterations(b2Profile* profile, const b2TimeStep& step,
+							   b2ContactSolver* contactSolver, b2SolverData* solverData)
+{
+	b2Timer timer;
+
+	contactSolver->InitializeVelocityConstraints();
+
+	if (step.warmStarting)
+	{
+		contactSolver->WarmStart();
+	}
+	
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		m_joints[i]->InitVelocityConstraints(*solverData);
+	}
+
+	// Joint trees are solved directly, starting from the warm started impulses.
+	// Other joints are solved iteratively. The joint positions are always
+	// solved iteratively.
+	b2JointTreeSolver treeSolver(m_allocator);
+	bool useTree = step.jointTrees && m_jointCount > 0 &&
+		treeSolver.Initialize(*solverData, m_bodies, m_bodyCount, m_joints, m_jointCount);
+
+	b2JointBatchSolver jointSolver(m_allocator);
+	if (useTree == false)
+	{
+		jointSolver.Initialize(m_joints, m_jointCount);
+		jointSolver.InitializeVelocityConstraints(*solverData);
+	}
+
+	profile->solveInit = timer.GetMilliseconds();
+
+	// Solve velocity constraints. Iterative joints do not report a residual,
+	// so only islands without them can stop early. A joint tree is exact, so
+	// without contacts one iteration is enough.
+	timer.Reset();
+	bool adaptive = step.adaptiveIterations && (m_jointCount == 0 || useTree);
+	int32 velocityIterations = 0;
+	while (velocityIterations < step.velocityIterations)
+	{
+		float32 residual;
+		if (useTree)
 		{
-			float32 ratio = b2_maxTranslation / translation.Length();
-			v *= ratio;
+			residual = contactSolver->SolveVelocityConstraints();
+			treeSolver.SolveVelocityConstraints();
 		}
+		else
+		{
+			jointSolver.SolveVelocityConstraints(*solverData);
+			residual = contactSolver->SolveVelocityConstraints();
+		}
+		++velocityIterations;
 
-		float32 rotation = h * w;
-		if (rotation * rotation > b2_maxRotationSquared)
+		if ((adaptive && residual < b2_velocityTolerance) || (useTree && m_contactCount == 0))
 		{
-			float32 ratio = b2_maxRotation / b2Abs(rotation);
-			w *= ratio;
+			break;
 		}
+	}
 
-		// Integrate
-		c += h * v;
-		a += h * w;
+	profile->velocityIterations = velocityIterations;
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+	if (step.speculative)
+	{
+		contactSolver->ApplyRestitution();
 	}
 
+	// Store impulses for warm starting
+	contactSolver->StoreImpulses();
+	if (useTree)
+	{
+		treeSolver.StoreImpulses();
+	}
+	else
+	{
+		jointSolver.StoreImpulses();
+	}
+	profile->solveVelocity = timer.GetMilliseconds();
+
+	IntegratePositions(step.dt);
+
 	// Solve position constraints
 	timer.Reset();
 	bool positionSolved = false;
+	profile->positionIterations = 0;
 	for (int32 i = 0; i < step.positionIterations; ++i)
 	{
-		bool contactsOkay = contactSolver.SolvePositionConstraints();
+		++profile->positionIterations;
+		bool contactsOkay = contactSolver->SolvePositionConstraints();
 
 		bool jointsOkay = true;
 		for (int32 i = 0; i < m_jointCount; ++i)
 		{
-			bool jointOkay = m_joints[i]->SolvePositionConstraints(solverData);
+			bool jointOkay = m_joints[i]->SolvePositionConstraints(*solverData);
 			jointsOkay = jointsOkay && jointOkay;
 		}
 
@@ -326,58 +436,134 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		}
 	}
 
-	// Copy state buffers back to the bodies
-	for (int32 i = 0; i < m_bodyCount; ++i)
-	{
-		b2Body* body = m_bodies[i];
-		body->m_sweep.c = m_positions[i].c;
-		body->m_sweep.a = m_positions[i].a;
-		body->m_linearVelocity = m_velocities[i].v;
-		body->m_angularVelocity = m_velocities[i].w;
-		body->SynchronizeTransform();
-	}
-
 	profile->solvePosition = timer.GetMilliseconds();
+	return positionSolved;
+}
 
-	Report(contactSolver.m_velocityConstraints);
+// The soft step solver. Each sub-step integrates the velocities, solves the contacts as
+// soft constraints, integrates the positions and then relaxes the velocities with rigid
+// contacts. The joints are solved with the sub-step and keep their position solver.
+bool b2Island::SolveSubSteps(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity,
+							 b2ContactSolver* contactSolver, b2SolverData* solverData)
+{
+	b2Timer timer;
 
-	if (allowSleep)
-	{
-		float32 minSleepTime = b2_maxFloat;
+	int32 subStepCount = step.subStepCount;
+	float32 h = step.dt / subStepCount;
+
+	solverData->step.dt = h;
+	solverData->step.inv_dt = subStepCount * step.inv_dt;
+
+	contactSolver->InitializeVelocityConstraints();
 
-		const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
-		const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
+	b2JointBatchSolver jointSolver(m_allocator);
+	jointSolver.Initialize(m_joints, m_jointCount);
+	profile->solveInit = timer.GetMilliseconds();
 
-		for (int32 i = 0; i < m_bodyCount; ++i)
+	timer.Reset();
+	for (int32 i = 0; i < subStepCount; ++i)
+	{
+		// Integrate velocities and apply damping.
+		for (int32 j = 0; j < m_bodyCount; ++j)
 		{
-			b2Body* b = m_bodies[i];
-			if (b->GetType() == b2_staticBody)
+			b2Body* b = m_bodies[j];
+			if (b->m_type != b2_dynamicBody)
 			{
 				continue;
 			}
 
-			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
-				b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
-				b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
-			{
-				b->m_sleepTime = 0.0f;
-				minSleepTime = 0.0f;
-			}
-			else
-			{
-				b->m_sleepTime += h;
-				minSleepTime = b2Min(minSleepTime, b->m_sleepTime);
-			}
+			b2Vec2 v = m_velocities[j].v;
+			float32 w = m_velocities[j].w;
+
+			v += h * (b->m_gravityScale * gravity + b->InvMass() * b->Force());
+			w += h * b->InvI() * b->Torque();
+
+			v *= b2Clamp(1.0f - h * b->m_linearDamping, 0.0f, 1.0f);
+			w *= b2Clamp(1.0f - h * b->m_angularDamping, 0.0f, 1.0f);
+
+			m_velocities[j].v = v;
+			m_velocities[j].w = w;
 		}
 
-		if (minSleepTime >= b2_timeToSleep && positionSolved)
+		// Warm start with the impulses of the previous sub-step.
+		for (int32 j = 0; j < m_jointCount; ++j)
 		{
-			for (int32 i = 0; i < m_bodyCount; ++i)
-			{
-				b2Body* b = m_bodies[i];
-				b->SetAwake(false);
-			}
+			m_joints[j]->InitVelocityConstraints(*solverData);
+		}
+
+		jointSolver.InitializeVelocityConstraints(*solverData);
+		if (step.warmStarting)
+		{
+			contactSolver->WarmStart();
+		}
+
+		// Solve with soft contacts.
+		jointSolver.SolveVelocityConstraints(*solverData);
+
+		contactSolver->SolveSoftVelocityConstraints(h, true);
+
+		IntegratePositions(h);
+
+		for (int32 j = 0; j < m_jointCount; ++j)
+		{
+			m_joints[j]->SolvePositionConstraints(*solverData);
+		}
+
+		// Relax the velocities.
+		jointSolver.SolveVelocityConstraints(*solverData);
+		jointSolver.StoreImpulses();
+
+		contactSolver->SolveSoftVelocityConstraints(h, false);
+
+		// The next sub-step continues from these impulses.
+		solverData->step.dtRatio = 1.0f;
+	}
+
+	contactSolver->ApplyRestitution();
+
+	// Store impulses for warm starting
+	contactSolver->StoreImpulses();
+	profile->solveVelocity = timer.GetMilliseconds();
+	profile->solvePosition = 0.0f;
+	profile->velocityIterations = subStepCount;
+	profile->positionIterations = 0;
+
+	// The soft contacts do not track the position error.
+	return true;
+}
+
+void b2Island::IntegratePositions(float32 h)
+{
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Vec2 c = m_positions[i].c;
+		float32 a = m_positions[i].a;
+		b2Vec2 v = m_velocities[i].v;
+		float32 w = m_velocities[i].w;
+
+		// Check for large velocities
+		b2Vec2 translation = h * v;
+		if (b2Dot(translation, translation) > b2_maxTranslationSquared)
+		{
+			float32 ratio = b2_maxTranslation / translation.Length();
+			v *= ratio;
+		}
+
+		float32 rotation = h * w;
+		if (rotation * rotation > b2_maxRotationSquared)
+		{
+			float32 ratio = b2_maxRotation / b2Abs(rotation);
+			w *= ratio;
 		}
+
+		// Integrate
+		c += h * v;
+		a += h * w;
+
+		m_positions[i].c = c;
+		m_positions[i].a = a;
+		m_velocities[i].v = v;
+		m_velocities[i].w = w;
 	}
 }
 
@@ -390,10 +576,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
-		m_positions[i].c = b->m_sweep.c;
-		m_positions[i].a = b->m_sweep.a;
-		m_velocities[i].v = b->m_linearVelocity;
-		m_velocities[i].w = b->m_angularVelocity;
+		m_positions[i].c = b->Sweep().c;
+		m_positions[i].a = b->Sweep().a;
+		m_velocities[i].v = b->LinearVelocity();
+		m_velocities[i].w = b->AngularVelocity();
 	}
 
 	b2ContactSolverDef contactSolverDef;
@@ -449,10 +635,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 #endif
 
 	// Leap of faith to new safe state.
-	m_bodies[toiIndexA]->m_sweep.c0 = m_positions[toiIndexA].c;
-	m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
-	m_bodies[toiIndexB]->m_sweep.c0 = m_positions[toiIndexB].c;
-	m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+	m_bodies[toiIndexA]->Sweep().c0 = m_positions[toiIndexA].c;
+	m_bodies[toiIndexA]->Sweep().a0 = m_positions[toiIndexA].a;
+	m_bodies[toiIndexB]->Sweep().c0 = m_positions[toiIndexB].c;
+	m_bodies[toiIndexB]->Sweep().a0 = m_positions[toiIndexB].a;
 
 	// No warm starting is needed for TOI events because warm
 	// starting impulses were applied in the discrete solver.
@@ -503,10 +689,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 		// Sync bodies
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = c;
-		body->m_sweep.a = a;
-		body->m_linearVelocity = v;
-		body->m_angularVelocity = w;
+		body->Sweep().c = c;
+		body->Sweep().a = a;
+		body->LinearVelocity() = v;
+		body->AngularVelocity() = w;
 		body->SynchronizeTransform();
 	}
 
@@ -515,7 +701,7 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 {
-	if (m_listener == NULL)
+	if (m_listener == NULL && m_events == NULL)
 	{
 		return;
 	}
@@ -534,6 +720,30 @@ void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 			impulse.tangentImpulses[j] = vc->points[j].tangentImpulse;
 		}
 
-		m_listener->PostSolve(c, &impulse);
+		if (m_listener)
+		{
+			m_listener->PostSolve(c, &impulse);
+		}
+
+		if (m_events)
+		{
+			int32 maxIndex = -1;
+			float32 maxImpulse = m_events->GetImpactThreshold();
+			for (int32 j = 0; j < vc->pointCount; ++j)
+			{
+				if (vc->points[j].normalImpulse > maxImpulse)
+				{
+					maxImpulse = vc->points[j].normalImpulse;
+					maxIndex = j;
+				}
+			}
+
+			if (maxIndex >= 0)
+			{
+				b2WorldManifold worldManifold;
+				c->GetWorldManifold(&worldManifold);
+				m_events->AddImpact(c, worldManifold.points[maxIndex], worldManifold.normal, maxImpulse);
+			}
+		}
 	}
 }
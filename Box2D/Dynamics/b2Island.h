@@ -27,6 +27,8 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactEventBuffer;
+class b2ContactSolver;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
 
@@ -35,7 +37,7 @@ class b2Island
 {
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
-			b2StackAllocator* allocator, b2ContactListener* listener);
+			b2StackAllocator* allocator, b2ContactListener* listener, b2ContactEventBuffer* events);
 	~b2Island();
 
 	void Clear()
@@ -71,8 +73,19 @@ public:
 
 	void Report(const b2ContactVelocityConstraint* constraints);
 
+	// Solve the velocities and positions of Solve. These return true if the
+	// position errors are small.
+	bool SolveIterations(b2Profile* profile, const b2TimeStep& step,
+						 b2ContactSolver* contactSolver, b2SolverData* solverData);
+	bool SolveSubSteps(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity,
+					   b2ContactSolver* contactSolver, b2SolverData* solverData);
+
+	// Integrate the positions of the solver state.
+	void IntegratePositions(float32 h);
+
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
+	b2ContactEventBuffer* m_events;
 
 	b2Body** m_bodies;
 	b2Contact** m_contacts;
@@ -81,6 +94,9 @@ public:
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
 
+	// Store indices of the bodies, looked up at the start of Solve.
+	int32* m_storeIndices;
+
 	int32 m_bodyCount;
 	int32 m_jointCount;
 	int32 m_contactCount;
@@ -88,6 +104,13 @@ public:
 	int32 m_bodyCapacity;
 	int32 m_contactCapacity;
 	int32 m_jointCapacity;
+
+	// Set by Solve. The largest and smallest motion of the bodies, measured
+	// against the sleep tolerances. A body is slow enough to sleep if its
+	// motion is at most one. The largest motion is b2_maxFloat if the island
+	// cannot sleep.
+	float32 m_maxSleepMotion;
+	float32 m_minSleepMotion;
 };
 
 #endif
@@ -0,0 +1,480 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/b2IslandManager.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2StackAllocator.h>
+#include <new>
+
+// Only solid touching contacts that were not disabled hold an island together.
+static bool b2IsSolidTouching(b2Contact* contact)
+{
+	return contact->IsTouching() && contact->IsEnabled() &&
+		contact->GetFixtureA()->IsSensor() == false &&
+		contact->GetFixtureB()->IsSensor() == false;
+}
+
+b2IslandManager::b2IslandManager()
+{
+	m_islandList = NULL;
+	m_islandCount = 0;
+	m_allocator = NULL;
+	m_stackAllocator = NULL;
+}
+
+b2PersistentIsland* b2IslandManager::CreateIsland()
+{
+	void* mem = m_allocator->Allocate(sizeof(b2PersistentIsland));
+	b2PersistentIsland* island = new (mem) b2PersistentIsland;
+	island->bodyList = NULL;
+	island->contactList = NULL;
+	island->jointList = NULL;
+	island->bodyCount = 0;
+	island->contactCount = 0;
+	island->jointCount = 0;
+	island->constraintRemoveCount = 0;
+	island->epoch = 0;
+	island->sleepTime = 0.0f;
+	island->restTime = 0.0f;
+	island->awake = true;
+
+	// Connect to the island list.
+	island->prev = NULL;
+	island->next = m_islandList;
+	if (m_islandList)
+	{
+		m_islandList->prev = island;
+	}
+	m_islandList = island;
+	++m_islandCount;
+
+	return island;
+}
+
+void b2IslandManager::DestroyIsland(b2PersistentIsland* island)
+{
+	if (island->prev)
+	{
+		island->prev->next = island->next;
+	}
+
+	if (island->next)
+	{
+		island->next->prev = island->prev;
+	}
+
+	if (island == m_islandList)
+	{
+		m_islandList = island->next;
+	}
+
+	b2Assert(m_islandCount > 0);
+	--m_islandCount;
+	m_allocator->Free(island, sizeof(b2PersistentIsland));
+}
+
+void b2IslandManager::AddToIsland(b2PersistentIsland* island, b2Body* body)
+{
+	body->m_island = island;
+	body->m_islandPrev = NULL;
+	body->m_islandNext = island->bodyList;
+	if (island->bodyList)
+	{
+		island->bodyList->m_islandPrev = body;
+	}
+	island->bodyList = body;
+	++island->bodyCount;
+}
+
+void b2IslandManager::AddToIsland(b2PersistentIsland* island, b2Contact* contact)
+{
+	contact->m_island = island;
+	contact->m_islandPrev = NULL;
+	contact->m_islandNext = island->contactList;
+	if (island->contactList)
+	{
+		island->contactList->m_islandPrev = contact;
+	}
+	island->contactList = contact;
+	++island->contactCount;
+}
+
+void b2IslandManager::AddToIsland(b2PersistentIsland* island, b2Joint* joint)
+{
+	joint->m_island = island;
+	joint->m_islandPrev = NULL;
+	joint->m_islandNext = island->jointList;
+	if (island->jointList)
+	{
+		island->jointList->m_islandPrev = joint;
+	}
+	island->jointList = joint;
+	++island->jointCount;
+}
+
+b2PersistentIsland* b2IslandManager::Merge(b2PersistentIsland* islandA, b2PersistentIsland* islandB)
+{
+	if (islandA == islandB)
+	{
+		return islandA;
+	}
+
+	// Move the smaller island into the larger one.
+	if (islandA->bodyCount < islandB->bodyCount)
+	{
+		b2Swap(islandA, islandB);
+	}
+
+	b2Body* body = islandB->bodyList;
+	while (body)
+	{
+		b2Body* next = body->m_islandNext;
+		AddToIsland(islandA, body);
+		body = next;
+	}
+
+	b2Contact* contact = islandB->contactList;
+	while (contact)
+	{
+		b2Contact* next = contact->m_islandNext;
+		AddToIsland(islandA, contact);
+		contact = next;
+	}
+
+	b2Joint* joint = islandB->jointList;
+	while (joint)
+	{
+		b2Joint* next = joint->m_islandNext;
+		AddToIsland(islandA, joint);
+		joint = next;
+	}
+
+	islandA->constraintRemoveCount += islandB->constraintRemoveCount;
+	islandA->sleepTime = b2Min(islandA->sleepTime, islandB->sleepTime);
+	islandA->restTime = b2Min(islandA->restTime, islandB->restTime);
+	islandA->awake = islandA->awake || islandB->awake;
+
+	DestroyIsland(islandB);
+	return islandA;
+}
+
+void b2IslandManager::AddBody(b2Body* body)
+{
+	b2Assert(body->m_island == NULL);
+	if (body->m_type == b2_staticBody || body->IsActive() == false)
+	{
+		return;
+	}
+
+	AddToIsland(CreateIsland(), body);
+}
+
+void b2IslandManager::RemoveBody(b2Body* body)
+{
+	b2PersistentIsland* island = body->m_island;
+	if (island == NULL)
+	{
+		return;
+	}
+
+	if (body->m_islandPrev)
+	{
+		body->m_islandPrev->m_islandNext = body->m_islandNext;
+	}
+
+	if (body->m_islandNext)
+	{
+		body->m_islandNext->m_islandPrev = body->m_islandPrev;
+	}
+
+	if (body == island->bodyList)
+	{
+		island->bodyList = body->m_islandNext;
+	}
+
+	body->m_island = NULL;
+	body->m_islandPrev = NULL;
+	body->m_islandNext = NULL;
+
+	b2Assert(island->bodyCount > 0);
+	--island->bodyCount;
+	if (island->bodyCount == 0)
+	{
+		b2Assert(island->contactCount == 0 && island->jointCount == 0);
+		DestroyIsland(island);
+	}
+	else
+	{
+		++island->constraintRemoveCount;
+	}
+}
+
+void b2IslandManager::ResetBody(b2Body* body)
+{
+	for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+	{
+		UnlinkContact(ce->contact);
+	}
+
+	for (b2JointEdge* je = body->m_jointList; je; je = je->next)
+	{
+		UnlinkJoint(je->joint);
+	}
+
+	RemoveBody(body);
+	AddBody(body);
+
+	for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+	{
+		if (b2IsSolidTouching(ce->contact))
+		{
+			LinkContact(ce->contact);
+		}
+	}
+
+	for (b2JointEdge* je = body->m_jointList; je; je = je->next)
+	{
+		LinkJoint(je->joint);
+	}
+}
+
+void b2IslandManager::LinkContact(b2Contact* contact)
+{
+	b2Assert(contact->m_island == NULL);
+
+	// Only the part of a sleeping island that is still connected to the
+	// contact is merged, and so woken.
+	b2PersistentIsland* islandA = Prune(contact->m_fixtureA->GetBody());
+	b2PersistentIsland* islandB = Prune(contact->m_fixtureB->GetBody());
+
+	// A contact between two static bodies is waiting to be filtered out.
+	if (islandA == NULL && islandB == NULL)
+	{
+		return;
+	}
+
+	b2PersistentIsland* island;
+	if (islandA && islandB)
+	{
+		island = Merge(islandA, islandB);
+	}
+	else
+	{
+		island = islandA ? islandA : islandB;
+	}
+
+	AddToIsland(island, contact);
+}
+
+void b2IslandManager::UnlinkContact(b2Contact* contact)
+{
+	b2PersistentIsland* island = contact->m_island;
+	if (island == NULL)
+	{
+		return;
+	}
+
+	if (contact->m_islandPrev)
+	{
+		contact->m_islandPrev->m_islandNext = contact->m_islandNext;
+	}
+
+	if (contact->m_islandNext)
+	{
+		contact->m_islandNext->m_islandPrev = contact->m_islandPrev;
+	}
+
+	if (contact == island->contactList)
+	{
+		island->contactList = contact->m_islandNext;
+	}
+
+	contact->m_island = NULL;
+	contact->m_islandPrev = NULL;
+	contact->m_islandNext = NULL;
+
+	b2Assert(island->contactCount > 0);
+	--island->contactCount;
+	++island->constraintRemoveCount;
+}
+
+void b2IslandManager::LinkJoint(b2Joint* joint)
+{
+	b2Assert(joint->m_island == NULL);
+
+	if (joint->m_bodyA->IsActive() == false || joint->m_bodyB->IsActive() == false)
+	{
+		return;
+	}
+
+	// Only the part of a sleeping island that is still connected to the
+	// joint is merged, and so woken.
+	b2PersistentIsland* islandA = Prune(joint->m_bodyA);
+	b2PersistentIsland* islandB = Prune(joint->m_bodyB);
+
+	if (islandA == NULL && islandB == NULL)
+	{
+		return;
+	}
+
+	b2PersistentIsland* island;
+	if (islandA && islandB)
+	{
+		island = Merge(islandA, islandB);
+	}
+	else
+	{
+		island = islandA ? islandA : islandB;
+	}
+
+	AddToIsland(island, joint);
+}
+
+void b2IslandManager::UnlinkJoint(b2Joint* joint)
+{
+	b2PersistentIsland* island = joint->m_island;
+	if (island == NULL)
+	{
+		return;
+	}
+
+	if (joint->m_islandPrev)
+	{
+		joint->m_islandPrev->m_islandNext = joint->m_islandNext;
+	}
+
+	if (joint->m_islandNext)
+	{
+		joint->m_islandNext->m_islandPrev = joint->m_islandPrev;
+	}
+
+	if (joint == island->jointList)
+	{
+		island->jointList = joint->m_islandNext;
+	}
+
+	joint->m_island = NULL;
+	joint->m_islandPrev = NULL;
+	joint->m_islandNext = NULL;
+
+	b2Assert(island->jointCount > 0);
+	--island->jointCount;
+	++island->constraintRemoveCount;
+}
+
+void b2IslandManager::Split(b2PersistentIsland* island, b2StackAllocator* allocator)
+{
+	int32 bodyCount = island->bodyCount;
+
+	// The island lists are rebuilt as the parts are found, so copy the bodies.
+	b2Body** bodies = (b2Body**)allocator->Allocate(bodyCount * sizeof(b2Body*));
+	b2Body** stack = (b2Body**)allocator->Allocate(bodyCount * sizeof(b2Body*));
+
+	int32 count = 0;
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		bodies[count++] = b;
+	}
+	b2Assert(count == bodyCount);
+
+	// Bodies, contacts and joints that still point at the old island have not
+	// been visited yet.
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* seed = bodies[i];
+		if (seed->m_island != island)
+		{
+			continue;
+		}
+
+		b2PersistentIsland* part = CreateIsland();
+		part->epoch = island->epoch;
+		part->sleepTime = island->sleepTime;
+		part->restTime = island->restTime;
+		part->awake = island->awake;
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		AddToIsland(part, seed);
+
+		while (stackCount > 0)
+		{
+			b2Body* b = stack[--stackCount];
+
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			{
+				b2Contact* contact = ce->contact;
+				if (contact->m_island != island)
+				{
+					continue;
+				}
+
+				AddToIsland(part, contact);
+
+				b2Body* other = ce->other;
+				if (other->m_island == island)
+				{
+					b2Assert(stackCount < bodyCount);
+					stack[stackCount++] = other;
+					AddToIsland(part, other);
+				}
+			}
+
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				b2Joint* joint = je->joint;
+				if (joint->m_island != island)
+				{
+					continue;
+				}
+
+				AddToIsland(part, joint);
+
+				b2Body* other = je->other;
+				if (other->m_island == island)
+				{
+					b2Assert(stackCount < bodyCount);
+					stack[stackCount++] = other;
+					AddToIsland(part, other);
+				}
+			}
+		}
+	}
+
+	allocator->Free(stack);
+	allocator->Free(bodies);
+
+	DestroyIsland(island);
+}
+
+b2PersistentIsland* b2IslandManager::Prune(b2Body* body)
+{
+	b2PersistentIsland* island = body->m_island;
+	if (island && island->awake == false && island->constraintRemoveCount > 0)
+	{
+		Split(island, m_stackAllocator);
+		island = body->m_island;
+	}
+
+	return island;
+}
@@ -0,0 +1,120 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_ISLAND_MANAGER_H
+#define B2_ISLAND_MANAGER_H
+
+#include <Box2D/Common/b2Settings.h>
+
+class b2Body;
+class b2Contact;
+class b2Joint;
+class b2BlockAllocator;
+class b2StackAllocator;
+
+/// A persistent island is a set of bodies that are connected by touching
+/// contacts and joints. Islands are merged when a contact or joint links two
+/// of them. They are not split when a link goes away. Instead the island
+/// counts the removed links. The world splits one such island per step,
+/// preferring the one closest to sleep. A sleeping island is also split when
+/// it is woken, so that only the part that is still connected wakes.
+/// Islands sleep and wake as a whole. Static bodies don't belong to islands.
+struct b2PersistentIsland
+{
+	b2Body* bodyList;
+	b2Contact* contactList;
+	b2Joint* jointList;
+
+	int32 bodyCount;
+	int32 contactCount;
+	int32 jointCount;
+
+	/// The number of contacts, joints and bodies removed since the island
+	/// was built. If this is positive the island may have fallen apart.
+	int32 constraintRemoveCount;
+
+	/// The island epoch of the last step that solved this island.
+	uint32 epoch;
+
+	/// How long all the bodies have been slow enough to sleep.
+	float32 sleepTime;
+
+	/// How long the slowest body has been slow enough to sleep. This picks
+	/// the island to split when the links have changed.
+	float32 restTime;
+
+	/// False while the island is asleep.
+	bool awake;
+
+	b2PersistentIsland* prev;
+	b2PersistentIsland* next;
+};
+
+// Delegate of b2World.
+class b2IslandManager
+{
+public:
+	b2IslandManager();
+
+	/// Give a new body its own island. Static and inactive bodies are ignored.
+	void AddBody(b2Body* body);
+
+	/// Remove a body from its island. The body's contacts and joints must be
+	/// unlinked first.
+	void RemoveBody(b2Body* body);
+
+	/// Rebuild the island links of a body after its type or active state
+	/// changed.
+	void ResetBody(b2Body* body);
+
+	/// Add a touching contact to the island of its bodies, merging the
+	/// islands of the two bodies.
+	void LinkContact(b2Contact* contact);
+	void UnlinkContact(b2Contact* contact);
+
+	/// Add a joint to the island of its bodies, merging the islands of the
+	/// two bodies. Joints to inactive bodies are not linked.
+	void LinkJoint(b2Joint* joint);
+	void UnlinkJoint(b2Joint* joint);
+
+	/// Split an island into its connected parts. The parts keep the sleep
+	/// state of the island.
+	void Split(b2PersistentIsland* island, b2StackAllocator* allocator);
+
+	/// Split the island of a body if it is asleep and may have fallen apart.
+	/// Returns the island of the body.
+	b2PersistentIsland* Prune(b2Body* body);
+
+	b2PersistentIsland* m_islandList;
+	int32 m_islandCount;
+	b2BlockAllocator* m_allocator;
+	b2StackAllocator* m_stackAllocator;
+
+private:
+
+	b2PersistentIsland* CreateIsland();
+	void DestroyIsland(b2PersistentIsland* island);
+	b2PersistentIsland* Merge(b2PersistentIsland* islandA, b2PersistentIsland* islandB);
+
+	void AddToIsland(b2PersistentIsland* island, b2Body* body);
+	void AddToIsland(b2PersistentIsland* island, b2Contact* contact);
+	void AddToIsland(b2PersistentIsland* island, b2Joint* joint);
+};
+
+#endif
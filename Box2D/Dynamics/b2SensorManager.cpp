@@ -0,0 +1,368 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/b2SensorManager.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactEvents.h>
+#include <Box2D/Dynamics/b2ContactManager.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2WorldCallbacks.h>
+#include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Common/b2Allocator.h>
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <cstring>
+#include <new>
+using namespace std;
+
+b2SensorManager::b2SensorManager(b2Allocator* allocator)
+{
+	m_heapAllocator = allocator ? allocator : b2GetDefaultAllocator();
+	m_pairCapacity = 16;
+	m_maxPairCapacity = m_pairCapacity;
+	m_pairCount = 0;
+	m_pairs = (b2SensorPair**)m_heapAllocator->Allocate(m_pairCapacity * sizeof(b2SensorPair*));
+	m_testCount = 0;
+	m_contactManager = NULL;
+	m_allocator = NULL;
+}
+
+b2SensorManager::~b2SensorManager()
+{
+	// The pairs themselves live in the block allocator.
+	m_heapAllocator->Free(m_pairs, m_pairCapacity * sizeof(b2SensorPair*));
+}
+
+void b2SensorManager::ResizePairs(int32 capacity)
+{
+	b2Assert(capacity >= m_pairCount);
+	b2SensorPair** oldPairs = m_pairs;
+	int32 oldCapacity = m_pairCapacity;
+	m_pairCapacity = capacity;
+	m_maxPairCapacity = b2Max(m_maxPairCapacity, m_pairCapacity);
+	m_pairs = (b2SensorPair**)m_heapAllocator->Allocate(m_pairCapacity * sizeof(b2SensorPair*));
+	memcpy(m_pairs, oldPairs, m_pairCount * sizeof(b2SensorPair*));
+	m_heapAllocator->Free(oldPairs, oldCapacity * sizeof(b2SensorPair*));
+}
+
+void b2SensorManager::Compact()
+{
+	int32 capacity = 16;
+	while (capacity < m_pairCount)
+	{
+		capacity *= 2;
+	}
+
+	if (capacity < m_pairCapacity)
+	{
+		ResizePairs(capacity);
+	}
+}
+
+void b2SensorManager::AddPair(b2FixtureProxy* proxyA, b2FixtureProxy* proxyB)
+{
+	b2Fixture* fixtureA = proxyA->fixture;
+	b2Fixture* fixtureB = proxyB->fixture;
+
+	int32 indexA = proxyA->childIndex;
+	int32 indexB = proxyB->childIndex;
+
+	b2Assert(fixtureA->IsSensor() || fixtureB->IsSensor());
+
+	// Does the pair already exist?
+	for (b2SensorEdge* edge = fixtureA->m_sensorList; edge; edge = edge->next)
+	{
+		if (edge->other != fixtureB)
+		{
+			continue;
+		}
+
+		const b2SensorPair* pair = edge->pair;
+		if (pair->fixtureA == fixtureA && pair->indexA == indexA && pair->indexB == indexB)
+		{
+			return;
+		}
+
+		if (pair->fixtureA == fixtureB && pair->indexA == indexB && pair->indexB == indexA)
+		{
+			return;
+		}
+	}
+
+	b2Body* bodyA = fixtureA->GetBody();
+	b2Body* bodyB = fixtureB->GetBody();
+
+	// Does a joint override collision? Is at least one body dynamic?
+	if (bodyB->ShouldCollide(bodyA) == false)
+	{
+		return;
+	}
+
+	// Check user filtering.
+	b2ContactFilter* filter = m_contactManager->m_contactFilter;
+	if (filter && filter->ShouldCollide(fixtureA, fixtureB) == false)
+	{
+		return;
+	}
+
+	void* mem = m_allocator->Allocate(sizeof(b2SensorPair));
+	b2SensorPair* pair = new (mem) b2SensorPair;
+	pair->fixtureA = fixtureA;
+	pair->fixtureB = fixtureB;
+	pair->indexA = indexA;
+	pair->indexB = indexB;
+	pair->flags = 0;
+
+	// Insert into the world.
+	if (m_pairCount == m_pairCapacity)
+	{
+		ResizePairs(2 * m_pairCapacity);
+	}
+
+	pair->managerIndex = m_pairCount;
+	m_pairs[m_pairCount++] = pair;
+
+	// Connect to the fixtures.
+	pair->nodeA.pair = pair;
+	pair->nodeA.other = fixtureB;
+	pair->nodeA.prev = NULL;
+	pair->nodeA.next = fixtureA->m_sensorList;
+	if (fixtureA->m_sensorList != NULL)
+	{
+		fixtureA->m_sensorList->prev = &pair->nodeA;
+	}
+	fixtureA->m_sensorList = &pair->nodeA;
+
+	pair->nodeB.pair = pair;
+	pair->nodeB.other = fixtureA;
+	pair->nodeB.prev = NULL;
+	pair->nodeB.next = fixtureB->m_sensorList;
+	if (fixtureB->m_sensorList != NULL)
+	{
+		fixtureB->m_sensorList->prev = &pair->nodeB;
+	}
+	fixtureB->m_sensorList = &pair->nodeB;
+}
+
+void b2SensorManager::Destroy(b2SensorPair* pair)
+{
+	b2Fixture* fixtureA = pair->fixtureA;
+	b2Fixture* fixtureB = pair->fixtureB;
+
+	if (pair->flags & b2SensorPair::e_overlapFlag)
+	{
+		b2ContactEventBuffer* events = m_contactManager->m_contactEvents;
+		if (events)
+		{
+			events->AddOverlapEnd(pair);
+		}
+
+		b2ContactListener* listener = m_contactManager->m_contactListener;
+		if (listener)
+		{
+			listener->EndOverlap(fixtureA, pair->indexA, fixtureB, pair->indexB);
+		}
+	}
+
+	// Remove from fixture A.
+	if (pair->nodeA.prev)
+	{
+		pair->nodeA.prev->next = pair->nodeA.next;
+	}
+
+	if (pair->nodeA.next)
+	{
+		pair->nodeA.next->prev = pair->nodeA.prev;
+	}
+
+	if (&pair->nodeA == fixtureA->m_sensorList)
+	{
+		fixtureA->m_sensorList = pair->nodeA.next;
+	}
+
+	// Remove from fixture B.
+	if (pair->nodeB.prev)
+	{
+		pair->nodeB.prev->next = pair->nodeB.next;
+	}
+
+	if (pair->nodeB.next)
+	{
+		pair->nodeB.next->prev = pair->nodeB.prev;
+	}
+
+	if (&pair->nodeB == fixtureB->m_sensorList)
+	{
+		fixtureB->m_sensorList = pair->nodeB.next;
+	}
+
+	// Remove from the world. Move the last pair into the hole.
+	int32 index = pair->managerIndex;
+	b2Assert(0 <= index && index < m_pairCount && m_pairs[index] == pair);
+	--m_pairCount;
+	if (index < m_pairCount)
+	{
+		m_pairs[index] = m_pairs[m_pairCount];
+		m_pairs[index]->managerIndex = index;
+	}
+
+	pair->~b2SensorPair();
+	m_allocator->Free(pair, sizeof(b2SensorPair));
+}
+
+void b2SensorManager::DestroyPairs(b2Fixture* fixture)
+{
+	while (fixture->m_sensorList)
+	{
+		Destroy(fixture->m_sensorList->pair);
+	}
+}
+
+void b2SensorManager::FlagForFiltering(b2Fixture* fixture)
+{
+	for (b2SensorEdge* edge = fixture->m_sensorList; edge; edge = edge->next)
+	{
+		edge->pair->flags |= b2SensorPair::e_filterFlag;
+	}
+}
+
+void b2SensorManager::FlagForFiltering(b2Body* bodyA, b2Body* bodyB)
+{
+	for (b2Fixture* fixture = bodyB->GetFixtureList(); fixture; fixture = fixture->GetNext())
+	{
+		for (b2SensorEdge* edge = fixture->m_sensorList; edge; edge = edge->next)
+		{
+			if (edge->other->GetBody() == bodyA)
+			{
+				edge->pair->flags |= b2SensorPair::e_filterFlag;
+			}
+		}
+	}
+}
+
+void b2SensorManager::Update()
+{
+	b2BroadPhase* broadPhase = &m_contactManager->m_broadPhase;
+	b2ContactFilter* filter = m_contactManager->m_contactFilter;
+	b2ContactListener* listener = m_contactManager->m_contactListener;
+	b2ContactEventBuffer* events = m_contactManager->m_contactEvents;
+
+	m_testCount = 0;
+
+	// Destroying a pair moves the last pair into the current slot.
+	int32 i = 0;
+	while (i < m_pairCount)
+	{
+		b2SensorPair* pair = m_pairs[i];
+		b2Fixture* fixtureA = pair->fixtureA;
+		b2Fixture* fixtureB = pair->fixtureB;
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
+
+		// Is this pair flagged for filtering?
+		if (pair->flags & b2SensorPair::e_filterFlag)
+		{
+			// A fixture may have stopped being a sensor. The broad-phase
+			// creates a contact for the proxies instead.
+			bool sensor = fixtureA->IsSensor() || fixtureB->IsSensor();
+
+			if (sensor == false || bodyB->ShouldCollide(bodyA) == false ||
+				(filter && filter->ShouldCollide(fixtureA, fixtureB) == false))
+			{
+				Destroy(pair);
+				continue;
+			}
+
+			pair->flags &= ~b2SensorPair::e_filterFlag;
+		}
+
+		bool activeA = bodyA->IsAwake() && bodyA->GetType() != b2_staticBody;
+		bool activeB = bodyB->IsAwake() && bodyB->GetType() != b2_staticBody;
+
+		// Nothing moved if both bodies are asleep or static.
+		if (activeA == false && activeB == false)
+		{
+			++i;
+			continue;
+		}
+
+		// Destroy the pair when the fat AABBs cease to overlap.
+		int32 proxyIdA = fixtureA->m_proxies[pair->indexA].proxyId;
+		int32 proxyIdB = fixtureB->m_proxies[pair->indexB].proxyId;
+		if (broadPhase->TestOverlap(proxyIdA, proxyIdB) == false)
+		{
+			Destroy(pair);
+			continue;
+		}
+
+		// Only test the shapes if the bodies moved relative to each other.
+		const b2Transform& xfA = bodyA->GetTransform();
+		const b2Transform& xfB = bodyB->GetTransform();
+		b2Transform relativeXf = b2MulT(xfA, xfB);
+		if (pair->flags & b2SensorPair::e_cacheFlag)
+		{
+			b2Vec2 dp = relativeXf.p - pair->relativeXf.p;
+			float32 ds = relativeXf.q.s - pair->relativeXf.q.s;
+			float32 dc = relativeXf.q.c - pair->relativeXf.q.c;
+			if (b2Dot(dp, dp) < b2_manifoldLinearTolerance * b2_manifoldLinearTolerance &&
+				b2Abs(ds) < b2_manifoldAngularTolerance && b2Abs(dc) < b2_manifoldAngularTolerance)
+			{
+				++i;
+				continue;
+			}
+		}
+
+		pair->relativeXf = relativeXf;
+		pair->flags |= b2SensorPair::e_cacheFlag;
+
+		bool overlap = b2TestOverlap(fixtureA->GetShape(), pair->indexA, fixtureB->GetShape(), pair->indexB, xfA, xfB);
+		bool wasOverlapping = (pair->flags & b2SensorPair::e_overlapFlag) == b2SensorPair::e_overlapFlag;
+		++m_testCount;
+
+		if (overlap && wasOverlapping == false)
+		{
+			pair->flags |= b2SensorPair::e_overlapFlag;
+
+			if (events)
+			{
+				events->AddOverlapBegin(pair);
+			}
+
+			if (listener)
+			{
+				listener->BeginOverlap(fixtureA, pair->indexA, fixtureB, pair->indexB);
+			}
+		}
+		else if (overlap == false && wasOverlapping)
+		{
+			pair->flags &= ~b2SensorPair::e_overlapFlag;
+
+			if (events)
+			{
+				events->AddOverlapEnd(pair);
+			}
+
+			if (listener)
+			{
+				listener->EndOverlap(fixtureA, pair->indexA, fixtureB, pair->indexB);
+			}
+		}
+
+		++i;
+	}
+}
@@ -0,0 +1,122 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_SENSOR_MANAGER_H
+#define B2_SENSOR_MANAGER_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Allocator;
+class b2BlockAllocator;
+class b2Body;
+class b2ContactManager;
+class b2Fixture;
+struct b2FixtureProxy;
+struct b2SensorPair;
+
+/// A sensor edge connects a fixture to a sensor pair. A fixture keeps a doubly
+/// linked list of the sensor pairs it belongs to.
+struct b2SensorEdge
+{
+	b2Fixture* other;		///< the other fixture of the pair
+	b2SensorPair* pair;		///< the sensor pair
+	b2SensorEdge* prev;
+	b2SensorEdge* next;
+};
+
+/// A sensor pair exists while the fat AABBs of a sensor fixture and another
+/// fixture overlap in the broad-phase. Unlike a contact, it has no manifold
+/// and does not link its bodies into an island.
+struct b2SensorPair
+{
+	enum
+	{
+		// The shapes overlap.
+		e_overlapFlag	= 0x0001,
+
+		// The pair needs filtering because a fixture, body or joint changed.
+		e_filterFlag	= 0x0002,
+
+		// The overlap was tested at the relative transform in relativeXf.
+		e_cacheFlag		= 0x0004
+	};
+
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	int32 indexA;
+	int32 indexB;
+
+	b2SensorEdge nodeA;
+	b2SensorEdge nodeB;
+
+	b2Transform relativeXf;
+	uint32 flags;
+
+	// Index in the sensor manager's pair array.
+	int32 managerIndex;
+};
+
+// Delegate of b2World.
+// Broad-phase pairs with a sensor fixture become sensor pairs instead of
+// contacts. Update tests the shapes of a pair only when one of its bodies is
+// awake and the relative transform of the bodies changed since the last test.
+// Overlap changes are reported through b2ContactListener::BeginOverlap and
+// EndOverlap and the contact event buffer.
+class b2SensorManager
+{
+public:
+	b2SensorManager(b2Allocator* allocator = NULL);
+	~b2SensorManager();
+
+	// Create a pair for two broad-phase proxies, at least one of them a sensor.
+	void AddPair(b2FixtureProxy* proxyA, b2FixtureProxy* proxyB);
+
+	// Destroy all pairs of a fixture. Call this when its proxies are destroyed.
+	void DestroyPairs(b2Fixture* fixture);
+
+	// Check the pairs of a fixture against the filters at the next update.
+	void FlagForFiltering(b2Fixture* fixture);
+
+	// Check the pairs between two bodies against the filters at the next update.
+	void FlagForFiltering(b2Body* bodyA, b2Body* bodyB);
+
+	void Update();
+
+	// Shrink the pair array to fit.
+	void Compact();
+
+	b2SensorPair** m_pairs;
+	int32 m_pairCount;
+	int32 m_pairCapacity;
+	int32 m_maxPairCapacity;
+
+	// The number of shape overlap tests run by the last Update.
+	int32 m_testCount;
+
+	b2ContactManager* m_contactManager;
+	b2BlockAllocator* m_allocator;
+	b2Allocator* m_heapAllocator;
+
+private:
+
+	void Destroy(b2SensorPair* pair);
+	void ResizePairs(int32 capacity);
+};
+
+#endif
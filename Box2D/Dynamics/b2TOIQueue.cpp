@@ -0,0 +1,177 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/b2TOIQueue.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Common/b2Allocator.h>
+#include <cstring>
+using namespace std;
+
+b2TOIQueue::b2TOIQueue(b2Allocator* allocator)
+{
+	m_allocator = allocator ? allocator : b2GetDefaultAllocator();
+	m_capacity = 16;
+	m_maxCapacity = m_capacity;
+	m_count = 0;
+	m_heap = (b2Contact**)m_allocator->Allocate(m_capacity * sizeof(b2Contact*));
+}
+
+b2TOIQueue::~b2TOIQueue()
+{
+	m_allocator->Free(m_heap, m_capacity * sizeof(b2Contact*));
+}
+
+void b2TOIQueue::Resize(int32 capacity)
+{
+	b2Assert(capacity >= m_count);
+	b2Contact** oldHeap = m_heap;
+	int32 oldCapacity = m_capacity;
+	m_capacity = capacity;
+	m_maxCapacity = b2Max(m_maxCapacity, m_capacity);
+	m_heap = (b2Contact**)m_allocator->Allocate(m_capacity * sizeof(b2Contact*));
+	memcpy(m_heap, oldHeap, m_count * sizeof(b2Contact*));
+	m_allocator->Free(oldHeap, oldCapacity * sizeof(b2Contact*));
+}
+
+void b2TOIQueue::Compact()
+{
+	int32 capacity = 16;
+	while (capacity < m_count)
+	{
+		capacity *= 2;
+	}
+
+	if (capacity < m_capacity)
+	{
+		Resize(capacity);
+	}
+}
+
+void b2TOIQueue::Place(b2Contact* contact, int32 index)
+{
+	m_heap[index] = contact;
+	contact->m_toiIndex = index;
+}
+
+void b2TOIQueue::SiftUp(int32 index)
+{
+	b2Contact* contact = m_heap[index];
+	float32 toi = contact->m_toi;
+	while (index > 0)
+	{
+		int32 parent = (index - 1) >> 1;
+		if (m_heap[parent]->m_toi <= toi)
+		{
+			break;
+		}
+
+		Place(m_heap[parent], index);
+		index = parent;
+	}
+
+	Place(contact, index);
+}
+
+void b2TOIQueue::SiftDown(int32 index)
+{
+	b2Contact* contact = m_heap[index];
+	float32 toi = contact->m_toi;
+	for (;;)
+	{
+		int32 child = 2 * index + 1;
+		if (child >= m_count)
+		{
+			break;
+		}
+
+		if (child + 1 < m_count && m_heap[child + 1]->m_toi < m_heap[child]->m_toi)
+		{
+			++child;
+		}
+
+		if (toi <= m_heap[child]->m_toi)
+		{
+			break;
+		}
+
+		Place(m_heap[child], index);
+		index = child;
+	}
+
+	Place(contact, index);
+}
+
+void b2TOIQueue::Update(b2Contact* contact)
+{
+	if (contact->m_toi >= 1.0f)
+	{
+		Remove(contact);
+		return;
+	}
+
+	int32 index = contact->m_toiIndex;
+	if (index == b2_nullContactIndex)
+	{
+		if (m_count == m_capacity)
+		{
+			Resize(2 * m_capacity);
+		}
+
+		index = m_count++;
+		Place(contact, index);
+		SiftUp(index);
+		return;
+	}
+
+	b2Assert(0 <= index && index < m_count && m_heap[index] == contact);
+	SiftUp(index);
+	SiftDown(contact->m_toiIndex);
+}
+
+void b2TOIQueue::Remove(b2Contact* contact)
+{
+	int32 index = contact->m_toiIndex;
+	if (index == b2_nullContactIndex)
+	{
+		return;
+	}
+
+	b2Assert(0 <= index && index < m_count && m_heap[index] == contact);
+	contact->m_toiIndex = b2_nullContactIndex;
+
+	// Move the last contact into the hole and restore the heap order.
+	--m_count;
+	if (index < m_count)
+	{
+		b2Contact* moved = m_heap[m_count];
+		Place(moved, index);
+		SiftUp(index);
+		SiftDown(moved->m_toiIndex);
+	}
+}
+
+void b2TOIQueue::Clear()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_heap[i]->m_toiIndex = b2_nullContactIndex;
+	}
+
+	m_count = 0;
+}
@@ -0,0 +1,97 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_TOI_QUEUE_H
+#define B2_TOI_QUEUE_H
+
+#include <Box2D/Common/b2Settings.h>
+
+class b2Allocator;
+class b2Contact;
+
+/// A binary min-heap of contacts ordered by their cached time of impact.
+/// b2World::SolveTOI uses this to find the earliest TOI event without
+/// scanning all contacts after every sub-step. A contact knows its position
+/// in the heap, so it can be moved or removed when its TOI changes.
+/// The array is kept between steps.
+class b2TOIQueue
+{
+public:
+	b2TOIQueue(b2Allocator* allocator);
+	~b2TOIQueue();
+
+	/// Insert a contact or move it to match its current TOI. A contact
+	/// without an event in this step (TOI of one) is removed instead.
+	void Update(b2Contact* contact);
+
+	/// Remove a contact if it is in the queue.
+	void Remove(b2Contact* contact);
+
+	/// Remove all contacts.
+	void Clear();
+
+	/// Get the contact with the earliest TOI, or NULL if the queue is empty.
+	b2Contact* GetMin() const;
+
+	int32 GetCount() const;
+
+	/// Shrink the array to fit.
+	void Compact();
+
+	/// Get the heap bytes held by the array.
+	int32 GetBytes() const;
+
+	/// Get the largest value GetBytes has reached.
+	int32 GetPeakBytes() const;
+
+private:
+
+	void Resize(int32 capacity);
+	void Place(b2Contact* contact, int32 index);
+	void SiftUp(int32 index);
+	void SiftDown(int32 index);
+
+	b2Allocator* m_allocator;
+	b2Contact** m_heap;
+	int32 m_count;
+	int32 m_capacity;
+	int32 m_maxCapacity;
+};
+
+inline b2Contact* b2TOIQueue::GetMin() const
+{
+	return m_count > 0 ? m_heap[0] : NULL;
+}
+
+inline int32 b2TOIQueue::GetCount() const
+{
+	return m_count;
+}
+
+inline int32 b2TOIQueue::GetBytes() const
+{
+	return m_capacity * sizeof(b2Contact*);
+}
+
+inline int32 b2TOIQueue::GetPeakBytes() const
+{
+	return m_maxCapacity * sizeof(b2Contact*);
+}
+
+#endif
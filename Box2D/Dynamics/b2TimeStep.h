@@ -32,6 +32,16 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+	int32 stackGrowths;		///< stack allocator segments added this step
+	int32 stackFallbacks;	///< stack allocations that went to the heap this step
+	int32 contactUpdates;	///< contacts updated by the narrow phase this step
+	int32 manifoldReuses;	///< updated contacts that kept their previous manifold
+	int32 sensorTests;		///< sensor pairs whose shapes were tested for overlap this step
+	int32 velocityIterations;	///< velocity iterations run this step, summed over the islands
+	int32 positionIterations;	///< position iterations run this step, summed over the islands
+	int32 degradedIslands;	///< islands solved with fewer iterations to stay in the step budget
+	int32 deferredTOIs;		///< contacts that skipped continuous collision to stay in the step budget
+	int32 forcedSleeps;		///< islands put to sleep because the step overran its budget
 };
 
 /// This is an internal structure.
@@ -43,6 +53,10 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool speculative;	// solve contact points that are not touching yet
+	int32 subStepCount;	// sub-steps of the soft step solver, 0 for the sequential solver
+	bool adaptiveIterations;	// stop the velocity iterations once the contacts converge
+	bool jointTrees;	// solve joint trees directly
 };
 
 /// This is an internal structure.
@@ -31,13 +31,24 @@
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2TaskExecutor.h>
 #include <Box2D/Common/b2Timer.h>
 #include <new>
 
-b2World::b2World(const b2Vec2& gravity)
+b2World::b2World(const b2Vec2& gravity, b2Allocator* allocator, b2SolverType solverType)
+	: m_allocator(allocator ? allocator : b2GetDefaultAllocator()),
+	m_blockAllocator(m_allocator),
+	m_contactAllocator(m_allocator),
+	m_contactCache(&m_contactAllocator),
+	m_stackAllocator(m_allocator),
+	m_bodyStore(m_allocator),
+	m_contactManager(m_allocator),
+	m_sensorManager(m_allocator),
+	m_toiQueue(m_allocator)
 {
 	m_destructionListener = NULL;
 	m_debugDraw = NULL;
+	m_taskExecutor = NULL;
 
 	m_bodyList = NULL;
 	m_jointList = NULL;
@@ -45,9 +56,19 @@ b2World::b2World(const b2Vec2& gravity)
 	m_bodyCount = 0;
 	m_jointCount = 0;
 
+	m_proxyBytes = 0;
+	m_maxProxyBytes = 0;
+
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_speculativeContacts = false;
+	m_solverType = solverType;
+	m_adaptiveIterations = false;
+	m_jointTrees = false;
+	m_stepBudget = 0.0f;
+	m_deferTOI = false;
+	m_speculativeTime = 0.0f;
 
 	m_stepComplete = true;
 
@@ -58,7 +79,15 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_inv_dt0 = 0.0f;
 
-	m_contactManager.m_allocator = &m_blockAllocator;
+	m_islandEpoch = 0;
+
+	m_contactManager.m_allocator = &m_contactCache;
+	m_contactManager.m_islandManager = &m_islandManager;
+	m_islandManager.m_allocator = &m_blockAllocator;
+	m_islandManager.m_stackAllocator = &m_stackAllocator;
+	m_contactManager.m_sensorManager = &m_sensorManager;
+	m_sensorManager.m_contactManager = &m_contactManager;
+	m_sensorManager.m_allocator = &m_blockAllocator;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
 }
@@ -99,6 +128,33 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactManager.m_contactListener = listener;
 }
 
+void b2World::SetContactEventBuffer(b2ContactEventBuffer* buffer)
+{
+	m_contactManager.m_contactEvents = buffer;
+}
+
+void b2World::SetSpeculativeContacts(bool flag)
+{
+	if (flag == m_speculativeContacts)
+	{
+		return;
+	}
+
+	m_speculativeContacts = flag;
+
+	// The cached manifolds were computed with the other margin.
+	b2Contact** contacts = m_contactManager.m_contacts;
+	for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
+	{
+		contacts[i]->m_flags &= ~b2Contact::e_manifoldCacheFlag;
+	}
+}
+
+void b2World::SetTaskExecutor(b2TaskExecutor* executor)
+{
+	m_taskExecutor = executor;
+}
+
 void b2World::SetDebugDraw(b2Draw* debugDraw)
 {
 	m_debugDraw = debugDraw;
@@ -125,6 +181,8 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	m_bodyList = b;
 	++m_bodyCount;
 
+	m_islandManager.AddBody(b);
+
 	return b;
 }
 
@@ -177,7 +235,9 @@ void b2World::DestroyBody(b2Body* b)
 			m_destructionListener->SayGoodbye(f0);
 		}
 
+		m_sensorManager.DestroyPairs(f0);
 		f0->DestroyProxies(&m_contactManager.m_broadPhase);
+		m_proxyBytes -= f0->m_shape->GetChildCount() * sizeof(b2FixtureProxy);
 		f0->Destroy(&m_blockAllocator);
 		f0->~b2Fixture();
 		m_blockAllocator.Free(f0, sizeof(b2Fixture));
@@ -204,6 +264,9 @@ void b2World::DestroyBody(b2Body* b)
 		m_bodyList = b->m_next;
 	}
 
+	// The joints and contacts are gone, so the body can leave its island.
+	m_islandManager.RemoveBody(b);
+
 	--m_bodyCount;
 	b->~b2Body();
 	m_blockAllocator.Free(b, sizeof(b2Body));
@@ -244,6 +307,8 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	if (j->m_bodyB->m_jointList) j->m_bodyB->m_jointList->prev = &j->m_edgeB;
 	j->m_bodyB->m_jointList = &j->m_edgeB;
 
+	m_islandManager.LinkJoint(j);
+
 	b2Body* bodyA = def->bodyA;
 	b2Body* bodyB = def->bodyB;
 
@@ -262,6 +327,8 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 
 			edge = edge->next;
 		}
+
+		m_sensorManager.FlagForFiltering(bodyA, bodyB);
 	}
 
 	// Note: creating a joint doesn't wake the bodies.
@@ -296,6 +363,8 @@ void b2World::DestroyJoint(b2Joint* j)
 	}
 
 	// Disconnect from island graph.
+	m_islandManager.UnlinkJoint(j);
+
 	b2Body* bodyA = j->m_bodyA;
 	b2Body* bodyB = j->m_bodyB;
 
@@ -382,156 +451,183 @@ void b2World::SetAllowSleeping(bool flag)
 	}
 }
 
-// Find islands, integrate and solve constraints, solve position constraints
+// Gather the awake islands, integrate and solve constraints, solve position constraints
 void b2World::Solve(const b2TimeStep& step)
 {
 	m_profile.solveInit = 0.0f;
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
+	m_profile.velocityIterations = 0;
+	m_profile.positionIterations = 0;
 
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
 					m_jointCount,
 					&m_stackAllocator,
-					m_contactManager.m_contactListener);
-
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
-	{
-		b->m_flags &= ~b2Body::e_islandFlag;
-	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+					m_contactManager.m_contactListener,
+					m_contactManager.m_contactEvents);
+
+	// Start a new island epoch. This clears the island marks of all bodies
+	// and islands at once.
+	uint32 epoch = NextIslandEpoch();
+
+	// Solving an island can put its bodies to sleep, which reorders the awake
+	// bodies, so seed the islands from a copy.
+	int32 seedCount = m_bodyStore.m_awakeCount;
+	b2Body** seeds = (b2Body**)m_stackAllocator.Allocate(seedCount * sizeof(b2Body*));
+	memcpy(seeds, m_bodyStore.m_bodies, seedCount * sizeof(b2Body*));
+
+	// The bodies that were moved by the solver.
+	int32 movedCount = 0;
+	b2Body** moved = (b2Body**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Body*));
+
+	// Islands without bullets fall back to this step once the solver has used
+	// up its share of the step budget.
+	b2TimeStep degradedStep = step;
+	degradedStep.velocityIterations = b2Min(step.velocityIterations, b2_budgetVelocityIterations);
+	degradedStep.positionIterations = b2Min(step.positionIterations, b2_budgetPositionIterations);
+	degradedStep.subStepCount = b2Min(step.subStepCount, b2_budgetVelocityIterations);
+
+	// At most one island is split per step. Pick the one holding the body
+	// that has been resting the longest, then the one that lost the most
+	// constraints. Islands are split even when sleeping is disabled, so they
+	// keep solving and waking in connected parts.
+	b2PersistentIsland* splitIsland = NULL;
+	float32 splitRestTime = 0.0f;
+	int32 splitRemoveCount = 0;
+
+	for (int32 seedIndex = 0; seedIndex < seedCount; ++seedIndex)
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
-	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
-	{
-		j->m_islandFlag = false;
-	}
+		b2Body* seed = seeds[seedIndex];
 
-	// Build and simulate all awake islands.
-	int32 stackSize = m_bodyCount;
-	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
-	{
-		if (seed->m_flags & b2Body::e_islandFlag)
+		if (seed->IsAwake() == false || seed->IsActive() == false)
 		{
 			continue;
 		}
 
-		if (seed->IsAwake() == false || seed->IsActive() == false)
+		// The seed can be dynamic or kinematic.
+		if (seed->GetType() == b2_staticBody)
 		{
 			continue;
 		}
 
-		// The seed can be dynamic or kinematic.
-		if (seed->GetType() == b2_staticBody)
+		b2PersistentIsland* persistentIsland = seed->m_island;
+		b2Assert(persistentIsland != NULL);
+		if (persistentIsland->epoch == epoch)
 		{
 			continue;
 		}
 
-		// Reset island and stack.
+		if (persistentIsland->awake == false)
+		{
+			// Only wake the part of the island that is still connected to the seed.
+			persistentIsland = m_islandManager.Prune(seed);
+			persistentIsland->awake = true;
+			persistentIsland->sleepTime = 0.0f;
+			persistentIsland->restTime = 0.0f;
+		}
+		persistentIsland->epoch = epoch;
+
 		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
 
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
+		// Add the island bodies and make sure they are awake.
+		bool hasBullet = false;
+		for (b2Body* b = persistentIsland->bodyList; b; b = b->m_islandNext)
 		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
 			b2Assert(b->IsActive() == true);
 			island.Add(b);
-
-			// Make sure the body is awake.
 			b->SetAwake(true);
+			hasBullet = hasBullet || b->IsBullet();
+		}
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
-			if (b->GetType() == b2_staticBody)
+		// Static bodies are shared between islands, so add them as they are found.
+		for (b2Contact* contact = persistentIsland->contactList; contact; contact = contact->m_islandNext)
+		{
+			b2Assert(contact->IsTouching());
+
+			// Is this contact solid?
+			if (contact->IsEnabled() == false ||
+				contact->m_fixtureA->m_isSensor ||
+				contact->m_fixtureB->m_isSensor)
 			{
 				continue;
 			}
 
-			// Search all contacts connected to this body.
-			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			b2Body* bodyA = contact->m_fixtureA->m_body;
+			b2Body* bodyB = contact->m_fixtureB->m_body;
+			if (bodyA->m_type == b2_staticBody && bodyA->m_islandEpoch != epoch)
 			{
-				b2Contact* contact = ce->contact;
-
-				// Has this contact already been added to an island?
-				if (contact->m_flags & b2Contact::e_islandFlag)
-				{
-					continue;
-				}
-
-				// Is this contact solid and touching?
-				if (contact->IsEnabled() == false ||
-					contact->IsTouching() == false)
-				{
-					continue;
-				}
-
-				// Skip sensors.
-				bool sensorA = contact->m_fixtureA->m_isSensor;
-				bool sensorB = contact->m_fixtureB->m_isSensor;
-				if (sensorA || sensorB)
-				{
-					continue;
-				}
-
-				island.Add(contact);
-				contact->m_flags |= b2Contact::e_islandFlag;
-
-				b2Body* other = ce->other;
-
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
-
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
+				island.Add(bodyA);
+				bodyA->m_islandEpoch = epoch;
 			}
-
-			// Search all joints connect to this body.
-			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			if (bodyB->m_type == b2_staticBody && bodyB->m_islandEpoch != epoch)
 			{
-				if (je->joint->m_islandFlag == true)
-				{
-					continue;
-				}
-
-				b2Body* other = je->other;
+				island.Add(bodyB);
+				bodyB->m_islandEpoch = epoch;
+			}
 
-				// Don't simulate joints connected to inactive bodies.
-				if (other->IsActive() == false)
-				{
-					continue;
-				}
+			island.Add(contact);
+		}
 
-				island.Add(je->joint);
-				je->joint->m_islandFlag = true;
+		for (b2Joint* joint = persistentIsland->jointList; joint; joint = joint->m_islandNext)
+		{
+			b2Body* bodyA = joint->m_bodyA;
+			b2Body* bodyB = joint->m_bodyB;
+			if (bodyA->m_type == b2_staticBody && bodyA->m_islandEpoch != epoch)
+			{
+				island.Add(bodyA);
+				bodyA->m_islandEpoch = epoch;
+			}
+			if (bodyB->m_type == b2_staticBody && bodyB->m_islandEpoch != epoch)
+			{
+				island.Add(bodyB);
+				bodyB->m_islandEpoch = epoch;
+			}
 
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+			island.Add(joint);
+		}
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+		bool degrade = m_stepBudget > 0.0f && hasBullet == false &&
+			m_stepTimer.GetMilliseconds() > b2_budgetIslandFraction * m_stepBudget;
+		if (degrade)
+		{
+			++m_profile.degradedIslands;
 		}
 
 		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
+		island.Solve(&profile, degrade ? degradedStep : step, m_gravity, m_allowSleep);
 		m_profile.solveInit += profile.solveInit;
 		m_profile.solveVelocity += profile.solveVelocity;
 		m_profile.solvePosition += profile.solvePosition;
+		m_profile.velocityIterations += profile.velocityIterations;
+		m_profile.positionIterations += profile.positionIterations;
+
+		persistentIsland->sleepTime = island.m_maxSleepMotion <= 1.0f ? persistentIsland->sleepTime + step.dt : 0.0f;
+		persistentIsland->restTime = island.m_minSleepMotion <= 1.0f ? persistentIsland->restTime + step.dt : 0.0f;
+
+		if (persistentIsland->constraintRemoveCount > 0)
+		{
+			// The island may have fallen apart. It has to be split before any
+			// part of it can sleep.
+			float32 restTime = persistentIsland->restTime;
+			int32 removeCount = persistentIsland->constraintRemoveCount;
+			if (splitIsland == NULL || restTime > splitRestTime ||
+				(restTime == splitRestTime && removeCount > splitRemoveCount))
+			{
+				splitIsland = persistentIsland;
+				splitRestTime = restTime;
+				splitRemoveCount = removeCount;
+			}
+		}
+		else if (persistentIsland->sleepTime >= b2_timeToSleep)
+		{
+			for (b2Body* b = persistentIsland->bodyList; b; b = b->m_islandNext)
+			{
+				b->SetAwake(false);
+			}
+			persistentIsland->awake = false;
+		}
 
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -540,178 +636,422 @@ void b2World::Solve(const b2TimeStep& step)
 			b2Body* b = island.m_bodies[i];
 			if (b->GetType() == b2_staticBody)
 			{
-				b->m_flags &= ~b2Body::e_islandFlag;
+				b->m_islandEpoch = 0;
+				continue;
 			}
+
+			moved[movedCount++] = b;
 		}
 	}
 
-	m_stackAllocator.Free(stack);
+	if (splitIsland)
+	{
+		m_islandManager.Split(splitIsland, &m_stackAllocator);
+	}
 
 	{
 		b2Timer timer;
 		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		// If a body was not in an island then it did not move.
+		for (int32 i = 0; i < movedCount; ++i)
 		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			// Update fixtures (for broad-phase).
+			moved[i]->SynchronizeFixtures();
+		}
+
+		// Look for new contacts.
+		m_contactManager.FindNewContacts();
+		m_profile.broadphase = timer.GetMilliseconds();
+	}
+
+	m_stackAllocator.Free(moved);
+	m_stackAllocator.Free(seeds);
+}
+
+void b2World::SleepSlowIslands()
+{
+	float32 linTolSqr = b2_budgetSleepFactor * b2_budgetSleepFactor * b2_linearSleepTolerance * b2_linearSleepTolerance;
+	float32 angTolSqr = b2_budgetSleepFactor * b2_budgetSleepFactor * b2_angularSleepTolerance * b2_angularSleepTolerance;
+
+	for (b2PersistentIsland* island = m_islandManager.m_islandList; island; island = island->next)
+	{
+		// An island that may have fallen apart has to be split before it can sleep.
+		if (island->awake == false || island->constraintRemoveCount > 0)
+		{
+			continue;
+		}
+
+		bool awake = false;
+		bool slow = true;
+		for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+		{
+			if (b->IsAwake() == false)
 			{
 				continue;
 			}
 
-			if (b->GetType() == b2_staticBody)
+			awake = true;
+			if (b->IsSleepingAllowed() == false ||
+				b2Dot(b->LinearVelocity(), b->LinearVelocity()) > linTolSqr ||
+				b->AngularVelocity() * b->AngularVelocity() > angTolSqr)
 			{
-				continue;
+				slow = false;
+				break;
 			}
-
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
 		}
 
-		// Look for new contacts.
-		m_contactManager.FindNewContacts();
-		m_profile.broadphase = timer.GetMilliseconds();
+		if (awake && slow)
+		{
+			for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+			{
+				b->SetAwake(false);
+			}
+			island->awake = false;
+
+			++m_profile.forcedSleeps;
+		}
 	}
 }
 
-// Find TOI contacts and solve them.
-void b2World::SolveTOI(const b2TimeStep& step)
+uint32 b2World::NextIslandEpoch()
 {
-	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
-
-	if (m_stepComplete)
+	++m_islandEpoch;
+	if (m_islandEpoch == 0)
 	{
+		// The counter wrapped. Clear the marks so that no old mark matches.
 		for (b2Body* b = m_bodyList; b; b = b->m_next)
 		{
-			b->m_flags &= ~b2Body::e_islandFlag;
-			b->m_sweep.alpha0 = 0.0f;
+			b->m_islandEpoch = 0;
+		}
+		for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
+		{
+			m_contactManager.m_contacts[i]->m_islandEpoch = 0;
+		}
+		for (b2PersistentIsland* island = m_islandManager.m_islandList; island; island = island->next)
+		{
+			island->epoch = 0;
 		}
+		m_islandEpoch = 1;
+	}
+
+	return m_islandEpoch;
+}
+
+// The input of a TOI computation. The distance proxies may point into their
+// own storage, so a candidate must not be copied once it is prepared.
+struct b2TOICandidate
+{
+	b2Contact* contact;
+	b2TOIInput input;
+	float32 alpha0;
+	float32 alpha;
+	b2TOIStats stats;
+};
+
+// Compute the TOI of a prepared candidate. This only writes to the candidate,
+// so different candidates can be computed concurrently. The caller adds the
+// candidate's stats to the global statistics.
+static void b2ComputeTOI(b2TOICandidate* candidate)
+{
+	b2ResetTOIStats(&candidate->stats);
+
+	b2TOIOutput output;
+	b2TimeOfImpact(&output, &candidate->input, &candidate->stats);
+
+	// Beta is the fraction of the remaining portion of the .
+	float32 alpha0 = candidate->alpha0;
+	float32 alpha;
+	float32 beta = output.t;
+	if (output.state == b2TOIOutput::e_touching)
+	{
+		alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
+	}
+	else
+	{
+		alpha = 1.0f;
+	}
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	candidate->alpha = alpha;
+}
+
+// Computes the TOIs of a batch of candidates.
+class b2TOITask : public b2RangeTask
+{
+public:
+	b2TOITask(b2TOICandidate* candidates) : m_candidates(candidates) {}
+
+	void Execute(int32 begin, int32 end)
+	{
+		for (int32 i = begin; i < end; ++i)
 		{
-			// Invalidate TOI
-			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
-			c->m_toiCount = 0;
-			c->m_toi = 1.0f;
+			b2ComputeTOI(m_candidates + i);
 		}
 	}
 
-	// Find TOI events and solve them.
-	for (;;)
+	b2TOICandidate* m_candidates;
+};
+
+// Check if a contact takes part in continuous collision. If its TOI is not
+// cached, put the sweeps of the bodies onto the same time interval and set up
+// the candidate. Otherwise the candidate's contact is NULL.
+bool b2World::PrepareTOI(b2Contact* c, b2TOICandidate* candidate)
+{
+	candidate->contact = NULL;
+
+	// Is this contact disabled?
+	if (c->IsEnabled() == false)
 	{
-		// Find the first TOI.
-		b2Contact* minContact = NULL;
-		float32 minAlpha = 1.0f;
+		return false;
+	}
+
+	// Prevent excessive sub-stepping.
+	if (c->m_toiCount > b2_maxSubSteps)
+	{
+		return false;
+	}
+
+	if (c->m_flags & b2Contact::e_toiFlag)
+	{
+		// This contact has a valid cached TOI.
+		return true;
+	}
+
+	b2Fixture* fA = c->GetFixtureA();
+	b2Fixture* fB = c->GetFixtureB();
+
+	// Is there a sensor?
+	if (fA->IsSensor() || fB->IsSensor())
+	{
+		return false;
+	}
+
+	b2Body* bA = fA->GetBody();
+	b2Body* bB = fB->GetBody();
+
+	b2BodyType typeA = bA->m_type;
+	b2BodyType typeB = bB->m_type;
+	b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
+
+	bool activeA = bA->IsAwake() && typeA != b2_staticBody;
+	bool activeB = bB->IsAwake() && typeB != b2_staticBody;
+
+	// Is at least one body active (awake and dynamic or kinematic)?
+	if (activeA == false && activeB == false)
+	{
+		return false;
+	}
+
+	bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
+	bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
+
+	// Are these two non-bullet dynamic bodies?
+	if (collideA == false && collideB == false)
+	{
+		return false;
+	}
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	// Did either body move far enough to tunnel?
+	bool fastA = activeA && (bA->m_flags & b2Body::e_fastFlag);
+	bool fastB = activeB && (bB->m_flags & b2Body::e_fastFlag);
+	if (fastA == false && fastB == false)
+	{
+		return false;
+	}
+
+	// Over budget, only bullets get continuous collision.
+	if (m_deferTOI && bA->IsBullet() == false && bB->IsBullet() == false)
+	{
+		++m_profile.deferredTOIs;
+		return false;
+	}
+
+	// Compute the TOI for this contact.
+	// Put the sweeps onto the same time interval. Only the sweep of an
+	// active body is kept, so sleeping and static bodies never carry
+	// a partial sweep out of this step.
+	b2Sweep sweepA = bA->Sweep();
+	b2Sweep sweepB = bB->Sweep();
+	float32 alpha0 = sweepA.alpha0;
+
+	if (sweepA.alpha0 < sweepB.alpha0)
+	{
+		alpha0 = sweepB.alpha0;
+		sweepA.Advance(alpha0);
+		if (activeA)
 		{
-			// Is this contact disabled?
-			if (c->IsEnabled() == false)
-			{
-				continue;
-			}
+			bA->Sweep() = sweepA;
+		}
+	}
+	else if (sweepB.alpha0 < sweepA.alpha0)
+	{
+		alpha0 = sweepA.alpha0;
+		sweepB.Advance(alpha0);
+		if (activeB)
+		{
+			bB->Sweep() = sweepB;
+		}
+	}
 
-			// Prevent excessive sub-stepping.
-			if (c->m_toiCount > b2_maxSubSteps)
-			{
-				continue;
-			}
+	b2Assert(alpha0 < 1.0f);
 
-			float32 alpha = 1.0f;
-			if (c->m_flags & b2Contact::e_toiFlag)
-			{
-				// This contact has a valid cached TOI.
-				alpha = c->m_toi;
-			}
-			else
-			{
-				b2Fixture* fA = c->GetFixtureA();
-				b2Fixture* fB = c->GetFixtureB();
+	int32 indexA = c->GetChildIndexA();
+	int32 indexB = c->GetChildIndexB();
 
-				// Is there a sensor?
-				if (fA->IsSensor() || fB->IsSensor())
-				{
-					continue;
-				}
+	// The time of impact is computed in the interval [0, minTOI]
+	b2TOIInput* input = &candidate->input;
+	input->proxyA.Set(fA->GetShape(), indexA);
+	input->proxyB.Set(fB->GetShape(), indexB);
+	input->sweepA = sweepA;
+	input->sweepB = sweepB;
+	input->tMax = 1.0f;
 
-				b2Body* bA = fA->GetBody();
-				b2Body* bB = fB->GetBody();
+	candidate->contact = c;
+	candidate->alpha0 = alpha0;
+	return true;
+}
 
-				b2BodyType typeA = bA->m_type;
-				b2BodyType typeB = bB->m_type;
-				b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
+// Compute the TOI of a contact if it is not cached. Returns false if the
+// contact doesn't take part in continuous collision.
+bool b2World::UpdateTOI(b2Contact* c)
+{
+	b2TOICandidate candidate;
+	if (PrepareTOI(c, &candidate) == false)
+	{
+		return false;
+	}
 
-				bool activeA = bA->IsAwake() && typeA != b2_staticBody;
-				bool activeB = bB->IsAwake() && typeB != b2_staticBody;
+	if (candidate.contact)
+	{
+		b2ComputeTOI(&candidate);
+		b2AddTOIStats(&candidate.stats);
+		c->m_toi = candidate.alpha;
+		c->m_flags |= b2Contact::e_toiFlag;
+	}
 
-				// Is at least one body active (awake and dynamic or kinematic)?
-				if (activeA == false && activeB == false)
-				{
-					continue;
-				}
+	return true;
+}
 
-				bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
-				bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
+// Bring a contact's place in the TOI queue up to date.
+void b2World::QueueTOI(b2Contact* c)
+{
+	if (UpdateTOI(c))
+	{
+		m_toiQueue.Update(c);
+	}
+	else
+	{
+		m_toiQueue.Remove(c);
+	}
+}
 
-				// Are these two non-bullet dynamic bodies?
-				if (collideA == false && collideB == false)
-				{
-					continue;
-				}
+// Queue the contacts that became awake since the awake contact count was
+// taken. Waking up moves them to the end of the awake contacts.
+void b2World::QueueAwakenedTOI(int32 awakeContactCount)
+{
+	b2Contact** contacts = m_contactManager.m_contacts;
+	for (int32 i = awakeContactCount; i < m_contactManager.m_awakeContactCount; ++i)
+	{
+		QueueTOI(contacts[i]);
+	}
+}
 
-				// Compute the TOI for this contact.
-				// Put the sweeps onto the same time interval.
-				float32 alpha0 = bA->m_sweep.alpha0;
+// Find TOI contacts and solve them.
+void b2World::SolveTOI(const b2TimeStep& step)
+{
+	m_deferTOI = m_stepBudget > 0.0f && m_stepTimer.GetMilliseconds() > b2_budgetTOIFraction * m_stepBudget;
 
-				if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
-				{
-					alpha0 = bB->m_sweep.alpha0;
-					bA->m_sweep.Advance(alpha0);
-				}
-				else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
-				{
-					alpha0 = bA->m_sweep.alpha0;
-					bB->m_sweep.Advance(alpha0);
-				}
+	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator,
+					m_contactManager.m_contactListener,
+					m_contactManager.m_contactEvents);
 
-				b2Assert(alpha0 < 1.0f);
+	if (m_stepComplete)
+	{
+		NextIslandEpoch();
 
-				int32 indexA = c->GetChildIndexA();
-				int32 indexB = c->GetChildIndexB();
+		// Only awake bodies carry a partial sweep from the last step.
+		b2Sweep* sweeps = m_bodyStore.m_sweeps;
+		b2Body** bodies = m_bodyStore.m_bodies;
+		for (int32 i = 0; i < m_bodyStore.m_awakeCount; ++i)
+		{
+			sweeps[i].alpha0 = 0.0f;
+			bodies[i]->UpdateFastFlag();
+		}
 
-				// Compute the time of impact in interval [0, minTOI]
-				b2TOIInput input;
-				input.proxyA.Set(fA->GetShape(), indexA);
-				input.proxyB.Set(fB->GetShape(), indexB);
-				input.sweepA = bA->m_sweep;
-				input.sweepB = bB->m_sweep;
-				input.tMax = 1.0f;
+		b2Contact** contacts = m_contactManager.m_contacts;
+		for (int32 i = 0; i < m_contactManager.m_awakeContactCount; ++i)
+		{
+			// Invalidate TOI
+			b2Contact* c = contacts[i];
+			c->m_flags &= ~b2Contact::e_toiFlag;
+			c->m_toiCount = 0;
+			c->m_toi = 1.0f;
+		}
+	}
 
-				b2TOIOutput output;
-				b2TimeOfImpact(&output, &input);
+	uint32 epoch = m_islandEpoch;
 
-				// Beta is the fraction of the remaining portion of the .
-				float32 beta = output.t;
-				if (output.state == b2TOIOutput::e_touching)
-				{
-					alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
-				}
-				else
+	// Queue the TOI events of the awake contacts. After this only the contacts
+	// of bodies moved by a sub-step and contacts that became awake are visited.
+	{
+		int32 awakeContactCount = m_contactManager.m_awakeContactCount;
+		b2Contact** contacts = m_contactManager.m_contacts;
+		b2Contact** queued = (b2Contact**)m_stackAllocator.Allocate(awakeContactCount * sizeof(b2Contact*));
+		b2TOICandidate* candidates = (b2TOICandidate*)m_stackAllocator.Allocate(awakeContactCount * sizeof(b2TOICandidate));
+		int32 queuedCount = 0;
+		int32 candidateCount = 0;
+
+		// Preparing moves body sweeps, so it runs in contact order.
+		for (int32 i = 0; i < awakeContactCount; ++i)
+		{
+			b2TOICandidate* candidate = candidates + candidateCount;
+			if (PrepareTOI(contacts[i], candidate))
+			{
+				queued[queuedCount++] = contacts[i];
+				if (candidate->contact)
 				{
-					alpha = 1.0f;
+					++candidateCount;
 				}
-
-				c->m_toi = alpha;
-				c->m_flags |= b2Contact::e_toiFlag;
 			}
+		}
 
-			if (alpha < minAlpha)
-			{
-				// This is the minimum TOI found so far.
-				minContact = c;
-				minAlpha = alpha;
-			}
+		// The TOI computations are independent.
+		b2TOITask task(candidates);
+		if (m_taskExecutor && candidateCount > 0)
+		{
+			m_taskExecutor->ParallelFor(&task, candidateCount, b2_minTOITaskRange);
+		}
+		else
+		{
+			task.Execute(0, candidateCount);
+		}
+
+		// Cache the results and insert in contact order, so the queue doesn't
+		// depend on the executor. The stats are gathered here, on this thread.
+		for (int32 i = 0; i < candidateCount; ++i)
+		{
+			b2AddTOIStats(&candidates[i].stats);
+
+			b2Contact* c = candidates[i].contact;
+			c->m_toi = candidates[i].alpha;
+			c->m_flags |= b2Contact::e_toiFlag;
 		}
 
+		for (int32 i = 0; i < queuedCount; ++i)
+		{
+			m_toiQueue.Update(queued[i]);
+		}
+
+		m_stackAllocator.Free(candidates);
+		m_stackAllocator.Free(queued);
+	}
+
+	// Find TOI events and solve them.
+	for (;;)
+	{
+		// Find the first TOI.
+		b2Contact* minContact = m_toiQueue.GetMin();
+		float32 minAlpha = minContact ? minContact->m_toi : 1.0f;
+
 		if (minContact == NULL || 1.0f - 10.0f * b2_epsilon < minAlpha)
 		{
 			// No more TOI events. Done!
@@ -719,20 +1059,31 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			break;
 		}
 
+		// Contacts that become awake during this event are moved to the end
+		// of the awake contacts.
+		int32 awakeContactCount = m_contactManager.m_awakeContactCount;
+
 		// Advance the bodies to the TOI.
 		b2Fixture* fA = minContact->GetFixtureA();
 		b2Fixture* fB = minContact->GetFixtureB();
 		b2Body* bA = fA->GetBody();
 		b2Body* bB = fB->GetBody();
 
-		b2Sweep backup1 = bA->m_sweep;
-		b2Sweep backup2 = bB->m_sweep;
+		b2Sweep backup1 = bA->Sweep();
+		b2Sweep backup2 = bB->Sweep();
 
-		bA->Advance(minAlpha);
-		bB->Advance(minAlpha);
+		// Static bodies do not move, so only their alpha would change.
+		if (bA->m_type != b2_staticBody)
+		{
+			bA->Advance(minAlpha);
+		}
+		if (bB->m_type != b2_staticBody)
+		{
+			bB->Advance(minAlpha);
+		}
 
 		// The TOI contact likely has some new contact points.
-		minContact->Update(m_contactManager.m_contactListener);
+		minContact->Update(m_contactManager.m_contactListener, m_contactManager.m_contactEvents);
 		minContact->m_flags &= ~b2Contact::e_toiFlag;
 		++minContact->m_toiCount;
 
@@ -741,10 +1092,13 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		{
 			// Restore the sweeps.
 			minContact->SetEnabled(false);
-			bA->m_sweep = backup1;
-			bB->m_sweep = backup2;
+			bA->Sweep() = backup1;
+			bB->Sweep() = backup2;
 			bA->SynchronizeTransform();
 			bB->SynchronizeTransform();
+
+			m_toiQueue.Remove(minContact);
+			QueueAwakenedTOI(awakeContactCount);
 			continue;
 		}
 
@@ -757,9 +1111,9 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		island.Add(bB);
 		island.Add(minContact);
 
-		bA->m_flags |= b2Body::e_islandFlag;
-		bB->m_flags |= b2Body::e_islandFlag;
-		minContact->m_flags |= b2Contact::e_islandFlag;
+		bA->m_islandEpoch = epoch;
+		bB->m_islandEpoch = epoch;
+		minContact->m_islandEpoch = epoch;
 
 		// Get contacts on bodyA and bodyB.
 		b2Body* bodies[2] = {bA, bB};
@@ -783,7 +1137,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					b2Contact* contact = ce->contact;
 
 					// Has this contact already been added to the island?
-					if (contact->m_flags & b2Contact::e_islandFlag)
+					if (contact->m_islandEpoch == epoch)
 					{
 						continue;
 					}
@@ -805,19 +1159,19 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					}
 
 					// Tentatively advance the body to the TOI.
-					b2Sweep backup = other->m_sweep;
-					if ((other->m_flags & b2Body::e_islandFlag) == 0)
+					b2Sweep backup = other->Sweep();
+					if (other->m_islandEpoch != epoch && other->m_type != b2_staticBody)
 					{
 						other->Advance(minAlpha);
 					}
 
 					// Update the contact points
-					contact->Update(m_contactManager.m_contactListener);
+					contact->Update(m_contactManager.m_contactListener, m_contactManager.m_contactEvents);
 
 					// Was the contact disabled by the user?
 					if (contact->IsEnabled() == false)
 					{
-						other->m_sweep = backup;
+						other->Sweep() = backup;
 						other->SynchronizeTransform();
 						continue;
 					}
@@ -825,23 +1179,23 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					// Are there contact points?
 					if (contact->IsTouching() == false)
 					{
-						other->m_sweep = backup;
+						other->Sweep() = backup;
 						other->SynchronizeTransform();
 						continue;
 					}
 
 					// Add the contact to the island
-					contact->m_flags |= b2Contact::e_islandFlag;
+					contact->m_islandEpoch = epoch;
 					island.Add(contact);
 
 					// Has the other body already been added to the island?
-					if (other->m_flags & b2Body::e_islandFlag)
+					if (other->m_islandEpoch == epoch)
 					{
 						continue;
 					}
 					
 					// Add the other body to the island.
-					other->m_flags |= b2Body::e_islandFlag;
+					other->m_islandEpoch = epoch;
 
 					if (other->m_type != b2_staticBody)
 					{
@@ -860,13 +1214,17 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
+		subStep.speculative = false;
+		subStep.subStepCount = 0;
+		subStep.adaptiveIterations = false;
+		subStep.jointTrees = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
 		// Reset island flags and synchronize broad-phase proxies.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
 		{
 			b2Body* body = island.m_bodies[i];
-			body->m_flags &= ~b2Body::e_islandFlag;
+			body->m_islandEpoch = 0;
 
 			if (body->m_type != b2_dynamicBody)
 			{
@@ -875,10 +1233,14 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 			body->SynchronizeFixtures();
 
+			// The sub-step gave the body a new sweep.
+			body->UpdateFastFlag();
+
 			// Invalidate all contact TOIs on this displaced body.
 			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 			{
-				ce->contact->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+				ce->contact->m_flags &= ~b2Contact::e_toiFlag;
+				ce->contact->m_islandEpoch = 0;
 			}
 		}
 
@@ -886,17 +1248,41 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		// Also, some contacts can be destroyed.
 		m_contactManager.FindNewContacts();
 
+		// Only the TOI events of the moved bodies changed. This includes the
+		// events of contacts created for them.
+		m_toiQueue.Remove(minContact);
+		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		{
+			b2Body* body = island.m_bodies[i];
+			if (body->m_type == b2_staticBody)
+			{
+				continue;
+			}
+
+			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+			{
+				QueueTOI(ce->contact);
+			}
+		}
+
+		QueueAwakenedTOI(awakeContactCount);
+
 		if (m_subStepping)
 		{
 			m_stepComplete = false;
 			break;
 		}
 	}
+
+	m_toiQueue.Clear();
 }
 
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
-	b2Timer stepTimer;
+	m_stepTimer.Reset();
+
+	int32 stackGrowths = m_stackAllocator.GetGrowCount();
+	int32 stackFallbacks = m_stackAllocator.GetFallbackCount();
 
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_flags & e_newFixture)
@@ -923,14 +1309,27 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.speculative = m_speculativeContacts;
+	step.subStepCount = m_solverType == b2_softStepSolver ? b2Max(velocityIterations, 1) : 0;
+	step.adaptiveIterations = m_adaptiveIterations;
+	step.jointTrees = m_jointTrees;
+	m_speculativeTime = m_speculativeContacts ? dt : 0.0f;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
 		b2Timer timer;
 		m_contactManager.Collide();
+		m_sensorManager.Update();
 		m_profile.collide = timer.GetMilliseconds();
+		m_profile.contactUpdates = m_contactManager.m_contactUpdateCount;
+		m_profile.manifoldReuses = m_contactManager.m_manifoldReuseCount;
+		m_profile.sensorTests = m_sensorManager.m_testCount;
 	}
 
+	m_profile.degradedIslands = 0;
+	m_profile.deferredTOIs = 0;
+	m_profile.forcedSleeps = 0;
+
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	if (m_stepComplete && step.dt > 0.0f)
 	{
@@ -939,14 +1338,21 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 		m_profile.solve = timer.GetMilliseconds();
 	}
 
-	// Handle TOI events.
-	if (m_continuousPhysics && step.dt > 0.0f)
+	// Handle TOI events. Speculative contacts take care of tunneling instead.
+	if (m_continuousPhysics && m_speculativeContacts == false && step.dt > 0.0f)
 	{
 		b2Timer timer;
 		SolveTOI(step);
 		m_profile.solveTOI = timer.GetMilliseconds();
 	}
 
+	// An overrun step puts nearly resting islands to sleep to relieve the next steps.
+	if (m_stepBudget > 0.0f && m_allowSleep && step.dt > 0.0f &&
+		m_stepTimer.GetMilliseconds() > m_stepBudget)
+	{
+		SleepSlowIslands();
+	}
+
 	if (step.dt > 0.0f)
 	{
 		m_inv_dt0 = step.inv_dt;
@@ -959,15 +1365,20 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 
 	m_flags &= ~e_locked;
 
-	m_profile.step = stepTimer.GetMilliseconds();
+	m_profile.stackGrowths = m_stackAllocator.GetGrowCount() - stackGrowths;
+	m_profile.stackFallbacks = m_stackAllocator.GetFallbackCount() - stackFallbacks;
+	m_profile.step = m_stepTimer.GetMilliseconds();
 }
 
 void b2World::ClearForces()
 {
-	for (b2Body* body = m_bodyList; body; body = body->GetNext())
+	// Sleeping and static bodies have no force.
+	b2Vec2* forces = m_bodyStore.m_forces;
+	float32* torques = m_bodyStore.m_torques;
+	for (int32 i = 0; i < m_bodyStore.m_awakeCount; ++i)
 	{
-		body->m_force.SetZero();
-		body->m_torque = 0.0f;
+		forces[i].SetZero();
+		torques[i] = 0.0f;
 	}
 }
 
@@ -1183,8 +1594,9 @@ void b2World::DrawDebugData()
 	if (flags & b2Draw::e_pairBit)
 	{
 		b2Color color(0.3f, 0.9f, 0.9f);
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->GetNext())
+		for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 		{
+			//b2Contact* c = m_contactManager.m_contacts[i];
 			//b2Fixture* fixtureA = c->GetFixtureA();
 			//b2Fixture* fixtureB = c->GetFixtureB();
 
@@ -1236,6 +1648,77 @@ void b2World::DrawDebugData()
 	}
 }
 
+void b2World::GetMemoryStats(b2MemoryStats* stats) const
+{
+	const b2BlockAllocator& blocks = m_blockAllocator;
+	stats->blockAllocator.current = blocks.GetBytes();
+	stats->blockAllocator.peak = blocks.GetPeakBytes();
+	for (int32 i = 0; i < b2_blockSizes; ++i)
+	{
+		stats->blockSizes[i] = b2BlockAllocator::GetBlockSize(i);
+		stats->chunkCounts[i] = blocks.GetChunkCount(i);
+		stats->freeBlockCounts[i] = blocks.GetFreeBlockCount(i);
+	}
+
+	stats->contactAllocator.current = m_contactAllocator.GetBytes();
+	stats->contactAllocator.peak = m_contactAllocator.GetPeakBytes();
+
+	stats->stackAllocator.current = m_stackAllocator.GetAllocation();
+	stats->stackAllocator.peak = m_stackAllocator.GetMaxAllocation();
+	stats->stackCapacity = m_stackAllocator.GetCapacity();
+
+	stats->bodyStore.current = m_bodyStore.GetBytes();
+	stats->bodyStore.peak = m_bodyStore.GetPeakBytes();
+
+	const int32 contactBytes = 2 * sizeof(b2Contact*) + sizeof(b2ContactKey);
+	stats->contactArray.current = m_contactManager.m_contactCapacity * contactBytes;
+	stats->contactArray.peak = m_contactManager.m_maxContactCapacity * contactBytes;
+
+	stats->sensorArray.current = m_sensorManager.m_pairCapacity * sizeof(b2SensorPair*);
+	stats->sensorArray.peak = m_sensorManager.m_maxPairCapacity * sizeof(b2SensorPair*);
+
+	stats->toiQueue.current = m_toiQueue.GetBytes();
+	stats->toiQueue.peak = m_toiQueue.GetPeakBytes();
+
+	const b2BroadPhase& broadPhase = m_contactManager.m_broadPhase;
+	const b2DynamicTree& tree = broadPhase.GetTree();
+	stats->treeNodes.current = tree.GetNodeCapacity() * sizeof(b2TreeNode);
+	stats->treeNodes.peak = tree.GetMaxNodeCapacity() * sizeof(b2TreeNode);
+
+	stats->moveBuffer.current = broadPhase.GetMoveCapacity() * sizeof(int32);
+	stats->moveBuffer.peak = broadPhase.GetMaxMoveCapacity() * sizeof(int32);
+	stats->pairBuffer.current = broadPhase.GetPairCapacity() * sizeof(b2Pair);
+	stats->pairBuffer.peak = broadPhase.GetMaxPairCapacity() * sizeof(b2Pair);
+
+	stats->fixtureProxies.current = m_proxyBytes;
+	stats->fixtureProxies.peak = m_maxProxyBytes;
+
+	stats->total.current = stats->blockAllocator.current + stats->contactAllocator.current + stats->stackCapacity +
+		stats->bodyStore.current + stats->contactArray.current + stats->sensorArray.current +
+		stats->toiQueue.current + stats->treeNodes.current + stats->moveBuffer.current + stats->pairBuffer.current;
+	stats->total.peak = stats->blockAllocator.peak + stats->contactAllocator.peak + stats->stackCapacity +
+		stats->bodyStore.peak + stats->contactArray.peak + stats->sensorArray.peak +
+		stats->toiQueue.peak + stats->treeNodes.peak + stats->moveBuffer.peak + stats->pairBuffer.peak;
+}
+
+void b2World::Compact()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_blockAllocator.Compact();
+	m_contactCache.Flush();
+	m_contactAllocator.Compact();
+	m_bodyStore.Compact();
+	m_contactManager.Compact();
+	m_contactManager.m_broadPhase.Compact();
+	m_sensorManager.Compact();
+	m_toiQueue.Compact();
+}
+
 int32 b2World::GetProxyCount() const
 {
 	return m_contactManager.m_broadPhase.GetProxyCount();
@@ -21,8 +21,14 @@
 
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2ConcurrentBlockAllocator.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2Timer.h>
+#include <Box2D/Dynamics/b2BodyStore.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
+#include <Box2D/Dynamics/b2IslandManager.h>
+#include <Box2D/Dynamics/b2SensorManager.h>
+#include <Box2D/Dynamics/b2TOIQueue.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -31,10 +37,80 @@ struct b2BodyDef;
 struct b2Color;
 struct b2JointDef;
 class b2Body;
+class b2ContactEventBuffer;
 class b2Draw;
+class b2TaskExecutor;
+struct b2TOICandidate;
 class b2Fixture;
 class b2Joint;
 
+/// Current and peak heap usage of a world subsystem, in bytes.
+struct b2MemoryUsage
+{
+	int32 current;
+	int32 peak;
+};
+
+/// A breakdown of the memory used by a world.
+/// @see b2World::GetMemoryStats
+struct b2MemoryStats
+{
+	/// Chunks, chunk array and large blocks of the small object allocator.
+	b2MemoryUsage blockAllocator;
+
+	/// The chunks of the contact allocator, including blocks held in caches.
+	b2MemoryUsage contactAllocator;
+
+	/// The number of chunks and free blocks for each block size class.
+	int32 blockSizes[b2_blockSizes];
+	int32 chunkCounts[b2_blockSizes];
+	int32 freeBlockCounts[b2_blockSizes];
+
+	/// Live per-step allocations. The peak is the stack allocator high-water mark.
+	b2MemoryUsage stackAllocator;
+
+	/// The stack allocator segments. Grown segments are kept.
+	int32 stackCapacity;
+
+	/// The solver state arrays of the bodies.
+	b2MemoryUsage bodyStore;
+
+	/// The contact manager's contact and key arrays and its update buffer.
+	b2MemoryUsage contactArray;
+
+	/// The sensor manager's pair array.
+	b2MemoryUsage sensorArray;
+
+	/// The TOI event queue.
+	b2MemoryUsage toiQueue;
+
+	/// The broad-phase tree node pool.
+	b2MemoryUsage treeNodes;
+
+	/// The broad-phase move and pair buffers.
+	b2MemoryUsage moveBuffer;
+	b2MemoryUsage pairBuffer;
+
+	/// Fixture proxy arrays. These live in the block allocator and are
+	/// not added to the total.
+	b2MemoryUsage fixtureProxies;
+
+	/// Sum of the heap owned subsystems above. The peak is the sum of the
+	/// subsystem peaks, so it is an upper bound.
+	b2MemoryUsage total;
+};
+
+/// The constraint solver of a world.
+enum b2SolverType
+{
+	/// Sequential impulses with velocity and position iterations.
+	b2_sequentialSolver = 0,
+
+	/// Soft contacts solved in sub-steps, each followed by a relaxation pass.
+	/// This needs fewer passes than the sequential solver for stable stacking.
+	b2_softStepSolver
+};
+
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
 /// management facilities.
@@ -43,7 +119,11 @@ class b2World
 public:
 	/// Construct a world object.
 	/// @param gravity the world gravity vector.
-	b2World(const b2Vec2& gravity);
+	/// @param allocator the heap used by this world. The allocator is owned by you
+	/// and must outlive the world. NULL means the default allocator (b2Alloc/b2Free).
+	/// @param solverType the constraint solver. This cannot be changed later.
+	b2World(const b2Vec2& gravity, b2Allocator* allocator = NULL,
+			b2SolverType solverType = b2_sequentialSolver);
 
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
@@ -61,11 +141,22 @@ public:
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
 
+	/// Register a buffer that collects begin, end and impact events as records
+	/// during the step. The buffer is owned by you and must remain in scope.
+	/// NULL turns event recording off, which is the default.
+	void SetContactEventBuffer(b2ContactEventBuffer* buffer);
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside with b2World::DrawDebugData method. The debug draw object is owned
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2Draw* debugDraw);
 
+	/// Register an executor to run the parallel passes of the step on your
+	/// worker threads. Currently this computes the initial TOI candidates of
+	/// continuous collision. NULL runs everything on the calling thread, which
+	/// is the default. The results do not depend on the executor.
+	void SetTaskExecutor(b2TaskExecutor* executor);
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
@@ -89,8 +180,10 @@ public:
 	/// Take a time step. This performs collision detection, integration,
 	/// and constraint solution.
 	/// @param timeStep the amount of time to simulate, this should not vary.
-	/// @param velocityIterations for the velocity constraint solver.
-	/// @param positionIterations for the position constraint solver.
+	/// @param velocityIterations for the velocity constraint solver. The soft step
+	/// solver uses this as the number of sub-steps.
+	/// @param positionIterations for the position constraint solver. The soft step
+	/// solver does not use this.
 	void Step(	float32 timeStep,
 				int32 velocityIterations,
 				int32 positionIterations);
@@ -153,6 +246,42 @@ public:
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 	bool GetContinuousPhysics() const { return m_continuousPhysics; }
 
+	/// Enable/disable speculative contacts. In this mode the contact solver also
+	/// handles shapes that can touch during the step, which prevents tunneling
+	/// without TOI sub-stepping. This is cheaper than continuous physics, which
+	/// is skipped, but fast rotating bodies may still tunnel and contacts begin
+	/// slightly before the shapes touch. Off by default.
+	void SetSpeculativeContacts(bool flag);
+	bool GetSpeculativeContacts() const { return m_speculativeContacts; }
+
+	/// Enable/disable adaptive iterations. Each island then stops its velocity
+	/// iterations once the contact impulses converge, so settled islands use
+	/// fewer iterations than the count passed to Step. Islands with joints always
+	/// use the full count. The iterations run are reported in the profile. Off by default.
+	void SetAdaptiveIterations(bool flag) { m_adaptiveIterations = flag; }
+	bool GetAdaptiveIterations() const { return m_adaptiveIterations; }
+
+	/// Enable/disable the direct joint solver. Islands whose joints form a tree,
+	/// such as ropes and ragdolls, then satisfy their joint velocities exactly in time
+	/// linear in the number of joints instead of converging over the velocity iterations.
+	/// Only revolute and distance joints without motors, limits or springs are
+	/// supported, other islands use the iterative solver. This does not apply to
+	/// the soft step solver. Off by default.
+	void SetJointTreeSolver(bool flag) { m_jointTrees = flag; }
+	bool GetJointTreeSolver() const { return m_jointTrees; }
+
+	/// Set a time budget for Step, in milliseconds. As the step uses up its budget
+	/// it cuts work in this order:
+	/// 1. islands without bullets are solved with fewer iterations,
+	/// 2. continuous collision is only done for bullets,
+	/// 3. after an overrun, nearly resting islands are put to sleep.
+	/// The profile records each of these. Zero turns the budget off, which is the default.
+	void SetStepBudget(float32 milliseconds) { m_stepBudget = milliseconds; }
+	float32 GetStepBudget() const { return m_stepBudget; }
+
+	/// Get the constraint solver chosen at construction.
+	b2SolverType GetSolverType() const { return m_solverType; }
+
 	/// Enable/disable single stepped continuous physics. For testing.
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
@@ -169,6 +298,14 @@ public:
 	/// Get the number of contacts (each may have 0 or more contact points).
 	int32 GetContactCount() const;
 
+	/// Get the number of islands. An island is a set of bodies connected by
+	/// touching contacts or joints, and it sleeps and wakes as a whole.
+	int32 GetIslandCount() const;
+
+	/// Get the number of sensor pairs. A sensor pair exists for each sensor
+	/// fixture and other fixture whose AABBs overlap in the broad-phase.
+	int32 GetSensorPairCount() const;
+
 	/// Get the height of the dynamic tree.
 	int32 GetTreeHeight() const;
 
@@ -200,6 +337,19 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Get the heap allocator used by this world.
+	b2Allocator* GetAllocator() const;
+
+	/// Get a breakdown of the memory used by this world. This walks the
+	/// block allocator free lists, so avoid calling it every step.
+	void GetMemoryStats(b2MemoryStats* stats) const;
+
+	/// Release memory left over from a load spike: empty block allocator
+	/// chunks, unused broad-phase buffer capacity and free tree nodes at the
+	/// end of the node pool.
+	/// @warning This function is locked during callbacks.
+	void Compact();
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
@@ -217,20 +367,41 @@ private:
 	friend class b2Body;
 	friend class b2Fixture;
 	friend class b2ContactManager;
+	friend class b2Contact;
 	friend class b2Controller;
 
 	void Solve(const b2TimeStep& step);
+	void SleepSlowIslands();
 	void SolveTOI(const b2TimeStep& step);
+	bool PrepareTOI(b2Contact* contact, b2TOICandidate* candidate);
+	bool UpdateTOI(b2Contact* contact);
+	void QueueTOI(b2Contact* contact);
+	void QueueAwakenedTOI(int32 awakeContactCount);
+
+	// Start a new island epoch and return it. Island marks from older epochs
+	// no longer match, so the marks never need to be cleared one by one.
+	uint32 NextIslandEpoch();
 
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
+	b2Allocator* m_allocator;
 	b2BlockAllocator m_blockAllocator;
+
+	// Contacts come from a thread-safe block allocator, so code that creates
+	// contacts on worker threads can give each worker its own cache. The
+	// world's thread allocates through m_contactCache.
+	b2ConcurrentBlockAllocator m_contactAllocator;
+	b2BlockCache m_contactCache;
 	b2StackAllocator m_stackAllocator;
+	b2BodyStore m_bodyStore;
 
 	int32 m_flags;
 
 	b2ContactManager m_contactManager;
+	b2IslandManager m_islandManager;
+	b2SensorManager m_sensorManager;
+	b2TOIQueue m_toiQueue;
 
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
@@ -238,20 +409,40 @@ private:
 	int32 m_bodyCount;
 	int32 m_jointCount;
 
+	int32 m_proxyBytes;
+	int32 m_maxProxyBytes;
+
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
 
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
+	b2TaskExecutor* m_taskExecutor;
 
 	// This is used to compute the time step ratio to
 	// support a variable time step.
 	float32 m_inv_dt0;
 
+	uint32 m_islandEpoch;
+
 	// These are for debugging the solver.
 	bool m_warmStarting;
 	bool m_continuousPhysics;
 	bool m_subStepping;
+	bool m_speculativeContacts;
+	b2SolverType m_solverType;
+	bool m_adaptiveIterations;
+	bool m_jointTrees;
+
+	// The step budget in milliseconds, zero if there is none. The timer runs
+	// from the start of the current step.
+	float32 m_stepBudget;
+	b2Timer m_stepTimer;
+	bool m_deferTOI;
+
+	// The time step used by the narrow phase to find speculative contact
+	// points. Zero when speculative contacts are off.
+	float32 m_speculativeTime;
 
 	bool m_stepComplete;
 
@@ -280,12 +471,12 @@ inline const b2Joint* b2World::GetJointList() const
 
 inline b2Contact* b2World::GetContactList()
 {
-	return m_contactManager.m_contactList;
+	return m_contactManager.m_contactCount > 0 ? m_contactManager.m_contacts[0] : NULL;
 }
 
 inline const b2Contact* b2World::GetContactList() const
 {
-	return m_contactManager.m_contactList;
+	return m_contactManager.m_contactCount > 0 ? m_contactManager.m_contacts[0] : NULL;
 }
 
 inline int32 b2World::GetBodyCount() const
@@ -303,6 +494,16 @@ inline int32 b2World::GetContactCount() const
 	return m_contactManager.m_contactCount;
 }
 
+inline int32 b2World::GetIslandCount() const
+{
+	return m_islandManager.m_islandCount;
+}
+
+inline int32 b2World::GetSensorPairCount() const
+{
+	return m_sensorManager.m_pairCount;
+}
+
 inline void b2World::SetGravity(const b2Vec2& gravity)
 {
 	m_gravity = gravity;
@@ -346,4 +547,9 @@ inline const b2Profile& b2World::GetProfile() const
 	return m_profile;
 }
 
+inline b2Allocator* b2World::GetAllocator() const
+{
+	return m_allocator;
+}
+
 #endif
@@ -84,11 +84,32 @@ public:
 	virtual ~b2ContactListener() {}
 
 	/// Called when two fixtures begin to touch.
+	/// Note: this is not called for sensors. See BeginOverlap.
 	virtual void BeginContact(b2Contact* contact) { B2_NOT_USED(contact); }
 
 	/// Called when two fixtures cease to touch.
 	virtual void EndContact(b2Contact* contact) { B2_NOT_USED(contact); }
 
+	/// Called when a sensor fixture begins to overlap another fixture. At least one
+	/// of the fixtures is a sensor. The child indices identify the overlapping
+	/// edges of chain shapes.
+	virtual void BeginOverlap(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB)
+	{
+		B2_NOT_USED(fixtureA);
+		B2_NOT_USED(indexA);
+		B2_NOT_USED(fixtureB);
+		B2_NOT_USED(indexB);
+	}
+
+	/// Called when a sensor fixture ceases to overlap another fixture.
+	virtual void EndOverlap(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB)
+	{
+		B2_NOT_USED(fixtureA);
+		B2_NOT_USED(indexA);
+		B2_NOT_USED(fixtureB);
+		B2_NOT_USED(indexB);
+	}
+
 	/// This is called after a contact is updated. This allows you to inspect a
 	/// contact before it goes to the solver. If you are careful, you can modify the
 	/// contact manifold (e.g. disable contact).
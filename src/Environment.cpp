@@ -63,13 +63,15 @@ Environment::Environment() {
 
     /* World Creation */
     world = shared_ptr<b2World>(new b2World(b2Vec2(0, -9.8))); // Normal earth gravity (9.8 m/s/s)
+    world->SetAdaptiveIterations(true); // Settled islands stop iterating early
+    world->SetStepBudget(8); // Degrade the simulation instead of stuttering (milliseconds)
 }
 
 /*
  * Step the physics simulation
  */
 void Environment::Step(float frameTime) {
-    const int velocityIterations = 8; // How strongly to correct velocity
+    const int velocityIterations = 8; // Most iterations to correct velocity
     const int positionIterations = 4; // How strongly to correct position
 
     world->Step(frameTime, velocityIterations, positionIterations);